@@ -10,14 +10,13 @@ void AddressStore::debitAddressToStore(std::vector<unsigned char> addressKey, UA
 }
 
 void AddressStore::debitAddressToStore(AddressForStore* address, UAmount amount, bool isUndo) {
-    DB& db = DB::Instance();
     Log(LOG_LEVEL_INFO) << "Amount to debit: " << amount;
 
     if(!(address->getAmount() >= amount)) {
         // If we are spending more than our balance debit from UBI grants
 
         UAmount debit;
-        for(std::map<uint8_t, CAmount>::iterator it = amount.map.begin(); it != amount.map.end(); it++) {
+        for(auto it = amount.map.begin(); it != amount.map.end(); it++) {
             Log(LOG_LEVEL_INFO) << "it->second: " << (uint32_t)it->first;
             if(it->second > address->getAmount().map[it->first]) {
                 debit.map.insert(std::pair<uint8_t, CAmount>(it->first, it->second - address->getAmount().map[it->first]));
@@ -36,7 +35,7 @@ void AddressStore::debitAddressToStore(AddressForStore* address, UAmount amount,
 
     Log(LOG_LEVEL_INFO) << "new address nonce: " << address->getNonce();
 
-    db.serializeToDb(DB_ADDRESS_STORE, AddressHelper::addressLinkFromScript(address->getScript()), *address);
+    this->storeAddress(AddressHelper::addressLinkFromScript(address->getScript()), address);
 }
 
 void AddressStore::creditAddressToStore(AddressForStore* address, bool isUndo) {
@@ -67,17 +66,109 @@ void AddressStore::creditAddressToStore(AddressForStore* address, bool isUndo) {
         currentAddress.setDscCertificate(address->getDscCertificate());
     }
 
-    DB& db = DB::Instance();
-
-    db.serializeToDb(DB_ADDRESS_STORE, addressKey, currentAddress);
+    this->storeAddress(addressKey, &currentAddress);
     Log(LOG_LEVEL_INFO) << "Credited address " << addressKey;
 }
 
 AddressForStore AddressStore::getAddressFromStore(std::vector<unsigned char> address) {
-    AddressForStore addressForStore;
-    addressForStore.setNonce(0); //default nonce if not in address store
-    DB& db = DB::Instance();
-    db.deserializeFromDb(DB_ADDRESS_STORE, address, addressForStore);
+    cacheMutex.lock();
+    AddressForStore addressForStore = this->getCacheEntry(address).address;
+    this->evict();
+    cacheMutex.unlock();
 
     return addressForStore;
 }
+
+/**
+ * Has to be called with cacheMutex locked
+ * Addresses that are not in the DB are cached too, new addresses are looked up repeatedly while verifying
+ */
+AddressCacheEntry& AddressStore::getCacheEntry(std::vector<unsigned char> addressKey) {
+    auto found = this->cache.find(addressKey);
+    if(found != this->cache.end()) {
+        this->lru.splice(this->lru.begin(), this->lru, found->second.lruPosition);
+        return found->second;
+    }
+
+    AddressCacheEntry entry;
+    entry.address.setNonce(0); //default nonce if not in address store
+    DB& db = DB::Instance();
+    db.deserializeFromDb(DB_ADDRESS_STORE, addressKey, entry.address);
+
+    this->lru.push_front(addressKey);
+    entry.lruPosition = this->lru.begin();
+
+    return this->cache.insert(std::make_pair(addressKey, entry)).first->second;
+}
+
+void AddressStore::storeAddress(std::vector<unsigned char> addressKey, AddressForStore* address) {
+    cacheMutex.lock();
+    AddressCacheEntry& entry = this->getCacheEntry(addressKey);
+    entry.address = *address;
+    if(!entry.dirty) {
+        entry.dirty = true;
+        this->dirtyCount++;
+    }
+    cacheMutex.unlock();
+}
+
+/**
+ * Has to be called with cacheMutex locked, dirty addresses are skipped until they are flushed
+ */
+void AddressStore::evict() {
+    auto it = this->lru.end();
+    while(this->cache.size() > ADDRESS_CACHE_SIZE && it != this->lru.begin()) {
+        it--;
+        auto found = this->cache.find(*it);
+        if(found->second.dirty) {
+            continue;
+        }
+
+        this->cache.erase(found);
+        it = this->lru.erase(it);
+    }
+}
+
+/**
+ * Writes the addresses modified since the last flush, has to be called inside the block transaction
+ * before its undo record is created so the prior values of the addresses are recorded
+ */
+bool AddressStore::flushCache() {
+    DB& db = DB::Instance();
+    bool success = true;
+    uint64_t flushedCount = 0;
+
+    cacheMutex.lock();
+    if(this->dirtyCount > 0) {
+        for(auto &entry : this->cache) {
+            if(!entry.second.dirty) {
+                continue;
+            }
+
+            success = db.serializeToDb(DB_ADDRESS_STORE, entry.first, entry.second.address) && success;
+            entry.second.dirty = false;
+            flushedCount++;
+        }
+        this->dirtyCount = 0;
+    }
+    this->evict();
+    cacheMutex.unlock();
+
+    if(flushedCount > 0) {
+        Log(LOG_LEVEL_INFO) << "flushed " << flushedCount << " address(es)";
+    }
+
+    return success;
+}
+
+/**
+ * Drops all cached addresses including unflushed modifications,
+ * has to be called when DB_ADDRESS_STORE is written without going through the cache
+ */
+void AddressStore::clearCache() {
+    cacheMutex.lock();
+    this->cache.clear();
+    this->lru.clear();
+    this->dirtyCount = 0;
+    cacheMutex.unlock();
+}
\ No newline at end of file
@@ -2,10 +2,33 @@
 #ifndef TX_ADDRESSSTORE_H
 #define TX_ADDRESSSTORE_H
 
+#include <list>
+#include <map>
+#include <mutex>
 #include "Address.h"
 #include "BlockHeader.h"
 
+struct AddressCacheEntry {
+    AddressForStore address;
+    bool dirty = false;
+    std::list<std::vector<unsigned char> >::iterator lruPosition;
+};
+
+/**
+ * Addresses are read and modified through a write-back cache,
+ * modified addresses are written to the DB by flushCache() in the block transaction of the block that modified them.
+ * Clean addresses are evicted least recently used first once there are more than ADDRESS_CACHE_SIZE.
+ */
 class AddressStore {
+private:
+    std::mutex cacheMutex;
+    std::map<std::vector<unsigned char>, AddressCacheEntry> cache;
+    std::list<std::vector<unsigned char> > lru; // most recently used first
+    uint64_t dirtyCount = 0;
+
+    AddressCacheEntry& getCacheEntry(std::vector<unsigned char> addressKey);
+    void storeAddress(std::vector<unsigned char> addressKey, AddressForStore* address);
+    void evict();
 public:
     static AddressStore& Instance(){
         static AddressStore instance;
@@ -16,6 +39,8 @@ public:
     void debitAddressToStore(AddressForStore* address, UAmount amount, bool isUndo);
     void creditAddressToStore(AddressForStore* address, bool isUndo);
     AddressForStore getAddressFromStore(std::vector<unsigned char> address);
+    bool flushCache();
+    void clearCache();
 };
 
 
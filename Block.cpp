@@ -16,7 +16,12 @@
 #include "Time.h"
 #include "MerkleTree.h"
 #include "AddressHelper.h"
+#include "Tools/WorkerPool.h"
+#include "Network/HeaderSkeleton.h"
+#include "Config.h"
+#include <algorithm>
 #include <math.h>
+#include <unordered_set>
 
 BlockHeader *Block::getHeader() {
     return &header;
@@ -38,12 +43,91 @@ void Block::setTransactions(std::vector<Transaction> transactions) {
     Block::transactions = transactions;
 }
 
+/**
+ * Verifies what can be verified on a header without the chain state: hash, linkage, slot and issuer signature
+ * The issuer schedule depends on the delegates voted in the previous blocks and is only checked by verifyBlock()
+ * previousBlockHeader has to be nullptr for the genesis block
+ */
+bool BlockHelper::verifyBlockHeader(BlockHeader* header, BlockHeader* previousBlockHeader) {
+    std::vector<unsigned char> computedHeaderHash = BlockHelper::computeBlockHeaderHash(*header);
+
+    if(computedHeaderHash != header->getHeaderHash()) {
+        Log(LOG_LEVEL_ERROR) << "Header hash "
+                             << header->getHeaderHash()
+                             << " and computed header hash "
+                             << computedHeaderHash
+                             << " mismatch";
+        return false;
+    }
+
+    if(previousBlockHeader == nullptr) {
+        if(header->getBlockHeight() != 1) {
+            Log(LOG_LEVEL_ERROR) << "Header " << header->getHeaderHash() << " has no previous header";
+            return false;
+        }
+    } else {
+        if(header->getPreviousHeaderHash() != previousBlockHeader->getHeaderHash()
+           || header->getBlockHeight() != previousBlockHeader->getBlockHeight() + 1) {
+            Log(LOG_LEVEL_ERROR) << "Header " << header->getHeaderHash()
+                                 << " doesn't link to " << previousBlockHeader->getHeaderHash();
+            return false;
+        }
+
+        if(header->getIssuerPubKey() == previousBlockHeader->getIssuerPubKey()) {
+            Log(LOG_LEVEL_ERROR) << "Previous block was issued by the same issuer";
+            return false;
+        }
+
+        if((uint64_t)(header->getTimestamp() / BLOCK_INTERVAL_IN_SECONDS) == (uint64_t)(previousBlockHeader->getTimestamp() / BLOCK_INTERVAL_IN_SECONDS)) {
+            Log(LOG_LEVEL_ERROR) << "Slot number " << (uint64_t)(header->getTimestamp() / BLOCK_INTERVAL_IN_SECONDS)
+                                 << " is already taken by another block";
+            return false;
+        }
+    }
+
+    if(header->getTimestamp() > Time::getCurrentTimestamp() + 110) {
+        Log(LOG_LEVEL_ERROR) << "Timestamp of the block is in the future";
+        return false;
+    }
+
+    if(!VerifySignature::verify(computedHeaderHash, header->getIssuerSignature(), header->getIssuerPubKey())) {
+        Log(LOG_LEVEL_ERROR) << "Block header signature isn't correct";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * A block is assumed valid if it is the configured assume-valid block or one of its ancestors
+ * Ancestry is established by HeaderSkeleton::appendAssumeValidHeaders() following the previous hashes down from the configured hash,
+ * sync fetches those headers down to our tip before the bodies
+ * Signatures and proofs of its transactions are then not verified again, state checks and transitions still happen
+ */
+bool BlockHelper::isAssumedValid(BlockHeader* header) {
+    Config& config = Config::Instance();
+    std::vector<unsigned char> assumeValidBlockHash = config.getAssumeValidBlockHash();
+
+    if(assumeValidBlockHash.empty()) {
+        return false;
+    }
+
+    HeaderSkeleton& headerSkeleton = HeaderSkeleton::Instance();
+    return headerSkeleton.isAncestorOf(header, assumeValidBlockHash, config.getAssumeValidBlockHeight());
+}
+
 bool BlockHelper::verifyBlock(Block* block) {
 
     Chain& chain = Chain::Instance();
     BlockHeader* header = block->getHeader();
     VoteStore& voteStore = VoteStore::Instance();
-    BlockHeader* previousBlockHeader = chain.getBlockHeader(header->getPreviousHeaderHash());
+
+    // nullptr for the genesis block
+    BlockHeader connectedPreviousBlockHeader;
+    BlockHeader* previousBlockHeader = nullptr;
+    if(chain.readBlockHeader(header->getPreviousHeaderHash(), connectedPreviousBlockHeader)) {
+        previousBlockHeader = &connectedPreviousBlockHeader;
+    }
 
     std::vector<unsigned char> computedHeaderHash = BlockHelper::computeBlockHeaderHash(*header);
 
@@ -86,15 +170,6 @@ bool BlockHelper::verifyBlock(Block* block) {
         return false;
     }
 
-    if(header->getVotes().size() > 0) {
-        for (auto vote: header->getVotes()) {
-            if(!TransactionHelper::verifyTx(&vote, IS_IN_HEADER, header)) {
-                Log(LOG_LEVEL_ERROR) << "Couldn't verify Vote in block header";
-                return false;
-            }
-        }
-    }
-
     std::vector<Transaction> transactions = block->getTransactions();
     std::vector<unsigned char> computedMerkleTreeRootHash =  MerkleTree::computeMerkleTreeRootValue(transactions);
 
@@ -106,32 +181,63 @@ bool BlockHelper::verifyBlock(Block* block) {
         return false;
     }
 
-    for(Transaction transaction: transactions) {
-        if(!TransactionHelper::verifyTx(&transaction, IS_NOT_IN_HEADER, header)) {
-            Log(LOG_LEVEL_ERROR) << "Failed to verify block with height "
-                                 << header->getBlockHeight()
-                                 << ", previous hash "
-                                 << header->getPreviousHeaderHash()
-                                 << " and header hash "
-                                 << header->getHeaderHash()
-                                 << " due to transaction";
-            return false;
-        }
-    }
-
     std::vector<Transaction> transactionsAndVotes;
 
     transactionsAndVotes.reserve(header->getVotes().size() + transactions.size());
     transactionsAndVotes.insert(transactionsAndVotes.end(), header->getVotes().begin(), header->getVotes().end());
     transactionsAndVotes.insert(transactionsAndVotes.end(), transactions.begin(), transactions.end());
 
+    size_t voteCount = header->getVotes().size();
+
+    // Signatures and NtpRsk/NtpEsk proofs don't depend on the chain state, verify them on all cores first.
+    // Results are evaluated in block order afterwards so the reported error doesn't depend on thread scheduling.
+    std::vector<char> proofsVerified(transactionsAndVotes.size(), 0);
+    if(BlockHelper::isAssumedValid(header)) {
+        Log(LOG_LEVEL_INFO) << "Block " << header->getHeaderHash() << " is assumed valid, skip proof verification";
+        std::fill(proofsVerified.begin(), proofsVerified.end(), 1);
+    } else {
+        WorkerPool& workerPool = WorkerPool::Instance();
+        workerPool.parallelFor(transactionsAndVotes.size(), [&](size_t i) {
+            try {
+                proofsVerified[i] = TransactionHelper::verifyTx(
+                        &transactionsAndVotes[i],
+                        i < voteCount ? IS_IN_HEADER : IS_NOT_IN_HEADER,
+                        header,
+                        TX_VERIFY_PROOFS
+                );
+            } catch (const std::exception& e) {
+                proofsVerified[i] = false;
+            }
+        });
+    }
+
+    for(size_t i = 0; i < transactionsAndVotes.size(); i++) {
+        uint8_t isInHeader = i < voteCount ? IS_IN_HEADER : IS_NOT_IN_HEADER;
+
+        if(!proofsVerified[i]
+           || !TransactionHelper::verifyTx(&transactionsAndVotes[i], isInHeader, header, TX_VERIFY_STATE)) {
+            if(isInHeader == IS_IN_HEADER) {
+                Log(LOG_LEVEL_ERROR) << "Couldn't verify Vote in block header";
+            } else {
+                Log(LOG_LEVEL_ERROR) << "Failed to verify block with height "
+                                     << header->getBlockHeight()
+                                     << ", previous hash "
+                                     << header->getPreviousHeaderHash()
+                                     << " and header hash "
+                                     << header->getHeaderHash()
+                                     << " due to transaction";
+            }
+            return false;
+        }
+    }
+
     // Verify there aren't two transactions with the same "TxInput" in the same block
     // This ensures that two different actions are not executed on the same object in parallel
     // which could cause errors or double spends.
     // /!\ For VOTE transactions also the TxOut matters and is included in the txInputs list.
     //     Indeed by receiving a vote or an unvote the delegates state can be changed
     // /!\ PASSPORT_REGISTER transactions the passport hash is used instead of the tx input which is the DSC certificate ID
-    std::vector<std::string> txInputs;
+    std::unordered_set<std::string> txInputs;
     for(Transaction transaction: transactionsAndVotes) {
 
         // Also insert and verify for target Delegate in txInputs
@@ -144,11 +250,7 @@ bool BlockHelper::verifyBlock(Block* block) {
                            transaction.getTxOuts().front().getScript().getScript().size());
             voScript >> *vote;
 
-            auto txInputsIt = std::find(txInputs.begin(),
-                                        txInputs.end(),
-                                        Hexdump::vectorToHexString(vote->getTargetPubKey())
-            );
-            txInputs.emplace_back(Hexdump::vectorToHexString(vote->getTargetPubKey()));
+            txInputs.insert(TransactionHelper::getInputKey(vote->getTargetPubKey()));
         }
     }
 
@@ -156,12 +258,7 @@ bool BlockHelper::verifyBlock(Block* block) {
         if(TransactionHelper::isRegisterPassport(&transaction)) {
             std::vector<unsigned char> passportHash = TransactionHelper::getPassportHash(&transaction);
 
-            auto txInputsIt = std::find(txInputs.begin(),
-                                        txInputs.end(),
-                                        Hexdump::vectorToHexString(passportHash)
-            );
-
-            if (txInputsIt != txInputs.end()) {
+            if (!txInputs.insert(TransactionHelper::getInputKey(passportHash)).second) {
                 Log(LOG_LEVEL_ERROR) << "Failed to verify block with height "
                                      << header->getBlockHeight()
                                      << ", previous hash "
@@ -171,15 +268,9 @@ bool BlockHelper::verifyBlock(Block* block) {
                                      << " due to duplicate input";
                 return false;
             }
-            txInputs.emplace_back(Hexdump::vectorToHexString(passportHash));
         } else {
             for (TxIn txIn: transaction.getTxIns()) {
-                auto txInputsIt = std::find(txInputs.begin(),
-                                            txInputs.end(),
-                                            Hexdump::vectorToHexString(txIn.getInAddress())
-                );
-
-                if (txInputsIt != txInputs.end()) {
+                if (!txInputs.insert(TransactionHelper::getInputKey(txIn.getInAddress())).second) {
                     Log(LOG_LEVEL_ERROR) << "Failed to verify block with height "
                                          << header->getBlockHeight()
                                          << ", previous hash "
@@ -189,7 +280,6 @@ bool BlockHelper::verifyBlock(Block* block) {
                                          << " due to duplicate input";
                     return false;
                 }
-                txInputs.emplace_back(Hexdump::vectorToHexString(txIn.getInAddress()));
             }
         }
     }
@@ -245,24 +335,25 @@ bool BlockHelper::applyBlock(Block* block) {
     TxPool& txPool = TxPool::Instance();
     Wallet& wallet = Wallet::Instance();
     AddressStore& addressStore = AddressStore::Instance();
+    bool success = true;
 
     // apply transactions
     for(Transaction transaction: block->getTransactions()) {
-        TransactionHelper::applyTransaction(&transaction, block->getHeader());
+        success = TransactionHelper::applyTransaction(&transaction, block->getHeader()) && success;
         // remove transaction from transaction pool
         txPool.popTransaction(TransactionHelper::getTxId(&transaction));
     }
 
     // apply votes
     for(Transaction transaction: block->getHeader()->getVotes()) {
-        TransactionHelper::applyTransaction(&transaction, block->getHeader());
+        success = TransactionHelper::applyTransaction(&transaction, block->getHeader()) && success;
         // remove vote from transaction pool
         txPool.popTransaction(TransactionHelper::getTxId(&transaction));
     }
 
     // apply payouts to PathSum
     PathSum& pathSum = PathSum::Instance();
-    pathSum.appendValue(block->getHeader()->getPayout());
+    success = pathSum.appendValue(block->getHeader()->getPayout()) && success;
 
     // apply delegate payout
     Address delegateAddress = wallet.addressFromPublicKey(block->getHeader()->getIssuerPubKey());
@@ -283,27 +374,26 @@ bool BlockHelper::applyBlock(Block* block) {
     addressStore.creditAddressToStore(devFundAddressForStore, false);
 
     Chain &chain = Chain::Instance();
-    BlockHeader* previousBlockHeader = chain.getBlockHeader(block->getHeader()->getPreviousHeaderHash());
+    BlockHeaderIndexEntry* previousBlockHeader = chain.getBlockHeader(block->getHeader()->getPreviousHeaderHash());
     CertStore& certStore = CertStore::Instance();
-    std::unordered_map<std::string, Cert>* dscList = certStore.getDSCList();
 
     if(previousBlockHeader != nullptr) {
-        // go through all DSCs to find out if one has been deactivated between previous and current block
-        // @TODO this is not the most performant solution, find something better
-        for(std::unordered_map<std::string, Cert>::iterator it = dscList->begin(); it != dscList->end(); ++it) {
-            if(it->second.getExpirationDate() > previousBlockHeader->getTimestamp()
-               && it->second.getExpirationDate() <= block->getHeader()->getTimestamp()) {
+        // deactivate the DSCs that expired between previous and current block
+        std::vector<Cert*> expiredDSCs = certStore.getDSCsExpiringBetween(
+                previousBlockHeader->getTimestamp(),
+                block->getHeader()->getTimestamp()
+        );
 
-                certStore.deactivateDSC(it->second.getId(), block->getHeader()); // the certificate might already have been deactivated but that isn't an issue
+        for(Cert* dsc : expiredDSCs) {
+            certStore.deactivateDSC(dsc->getId(), block->getHeader()); // the certificate might already have been deactivated but that isn't an issue
 
-                Log(LOG_LEVEL_INFO) << "DSC with id:"
-                                    << it->second.getId()
-                                    << " has been deactivated";
-            }
+            Log(LOG_LEVEL_INFO) << "DSC with id:"
+                                << dsc->getId()
+                                << " has been deactivated";
         }
     }
 
-    return true;
+    return success;
 }
 
 bool BlockHelper::undoBlock(Block* block) {
@@ -330,7 +420,7 @@ bool BlockHelper::undoBlock(Block* block) {
 
     // undo payouts to PathSum
     PathSum& pathSum = PathSum::Instance();
-    pathSum.popValue(1);
+    bool success = pathSum.popValue(1);
 
     // undo delegate payout
     Address delegateAddress = wallet.addressFromPublicKey(block->getHeader()->getIssuerPubKey());
@@ -356,161 +446,98 @@ bool BlockHelper::undoBlock(Block* block) {
 
 
     Chain &chain = Chain::Instance();
-    BlockHeader* previousBlockHeader = chain.getBlockHeader(block->getHeader()->getPreviousHeaderHash());
+    BlockHeaderIndexEntry* previousBlockHeader = chain.getBlockHeader(block->getHeader()->getPreviousHeaderHash());
     CertStore& certStore = CertStore::Instance();
-    std::unordered_map<std::string, Cert>* dscList = certStore.getDSCList();
-    std::unordered_map<std::string, Cert>* cscaList = certStore.getDSCList();
 
     if(previousBlockHeader != nullptr) {
-        // go through all DSCs to find out if one has been deactivated between previous and current block
-        // @TODO this is not the most performant solution, find something better
-        for (std::unordered_map<std::string, Cert>::iterator it = dscList->begin(); it != dscList->end(); ++it) {
-            if (it->second.getExpirationDate() > previousBlockHeader->getTimestamp()
-                && it->second.getExpirationDate() <= block->getHeader()->getTimestamp()) {
-
-                if(certStore.undoLastActionOnDSC(it->second.getId(), CERT_ACTION_DISABLED)) {
-                    Log(LOG_LEVEL_INFO) << "last action on DSC with id:"
-                                        << it->second.getId()
-                                        << " has undone";
-                }
+        // reactivate the DSCs that applyBlock deactivated because they expired between previous and current block
+        // CSCAs are not deactivated on expiration so there is nothing to undo for them
+        std::vector<Cert*> expiredDSCs = certStore.getDSCsExpiringBetween(
+                previousBlockHeader->getTimestamp(),
+                block->getHeader()->getTimestamp()
+        );
+
+        for(Cert* dsc : expiredDSCs) {
+            std::vector<unsigned char> dscId = dsc->getId();
+            if(certStore.undoLastActionOnDSC(dscId, CERT_ACTION_DISABLED)) {
+                Log(LOG_LEVEL_INFO) << "last action on DSC with id:"
+                                    << dscId
+                                    << " has undone";
             }
         }
+    }
 
-        // same with CSCAs
-        for (std::unordered_map<std::string, Cert>::iterator it = cscaList->begin(); it != cscaList->end(); ++it) {
-            if (it->second.getExpirationDate() > previousBlockHeader->getTimestamp()
-                && it->second.getExpirationDate() <= block->getHeader()->getTimestamp()) {
+    return success;
+}
 
-                if(certStore.undoLastActionOnCSCA(it->second.getId(), CERT_ACTION_DISABLED)) {
-                    Log(LOG_LEVEL_INFO) << "last action on CSCA with id:"
-                                        << it->second.getId()
-                                        << " has undone";
-                }
+struct CurrencyParams {
+    uint8_t currency;
+    CAmount emissionRate;
+    CAmount delegatePayout;
+    CAmount developmentPayout;
+};
+
+#define CURRENCY_PARAMS(NAME) {CURRENCY_##NAME, CURRENCY_##NAME##_EMISSION_RATE, CURRENCY_##NAME##_DELEGATE_PAYOUT, CURRENCY_##NAME##_DEVELOPMENT_PAYOUT},
+static constexpr CurrencyParams currencyParams[] = {FOR_EACH_CURRENCY(CURRENCY_PARAMS)};
+#undef CURRENCY_PARAMS
+
+static_assert(sizeof(currencyParams) / sizeof(currencyParams[0]) == CURRENCY_COUNT, "FOR_EACH_CURRENCY doesn't list CURRENCY_COUNT currencies");
+
+static uint32_t getNumberOfHalvings(uint32_t blockHeight) {
+    return std::min((uint32_t)(blockHeight / HALVING_INTERVAL_IN_BLOCKS), (uint32_t)NUMBER_OF_HALVINGS);
+}
+
+/**
+ * Delegate and dev fund payouts of every halving period, they are only built once
+ */
+struct HalvedPayouts {
+    UAmount delegatePayouts[NUMBER_OF_HALVINGS + 1];
+    UAmount devFundPayouts[NUMBER_OF_HALVINGS + 1];
+
+    HalvedPayouts() {
+        for(uint32_t numberOfHalvings = 0; numberOfHalvings <= NUMBER_OF_HALVINGS; numberOfHalvings++) {
+            CAmount halvingFactor = (CAmount)1 << numberOfHalvings;
+            for(const CurrencyParams& params : currencyParams) {
+                delegatePayouts[numberOfHalvings].map[params.currency] = params.delegatePayout / halvingFactor;
+                devFundPayouts[numberOfHalvings].map[params.currency] = params.developmentPayout / halvingFactor;
             }
         }
     }
+};
 
-    return true;
+static const HalvedPayouts& getHalvedPayouts() {
+    static HalvedPayouts halvedPayouts;
+    return halvedPayouts;
 }
 
 UAmount BlockHelper::calculateDelegatePayout(uint32_t blockHeight) {
-    uint32_t numberOfHalvings = (uint32_t)(blockHeight / HALVING_INTERVAL_IN_BLOCKS);
-    int32_t halvingFactor = 1;
-
-    for(int i = 0; i < numberOfHalvings && i < NUMBER_OF_HALVINGS; i++) {
-        halvingFactor = halvingFactor * 2;
-    }
-
-    Log(LOG_LEVEL_INFO) << "BlockHelper::calculateDelegatePayout() halvingFactor:" << halvingFactor;
-    Log(LOG_LEVEL_INFO) << "BlockHelper::calculateDelegatePayout() UCH payout:" << CURRENCY_SWITZERLAND_DELEGATE_PAYOUT / halvingFactor;
-
-    UAmount amount;
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWITZERLAND, CURRENCY_SWITZERLAND_DELEGATE_PAYOUT / halvingFactor));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_GERMANY, CURRENCY_GERMANY_DELEGATE_PAYOUT / halvingFactor));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRIA, CURRENCY_AUSTRIA_DELEGATE_PAYOUT / halvingFactor));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_KINGDOM, CURRENCY_UNITED_KINGDOM_DELEGATE_PAYOUT / halvingFactor));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_IRELAND, (uint64_t)(CURRENCY_IRELAND_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_USA, (uint64_t)(CURRENCY_USA_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRALIA, (uint64_t)(CURRENCY_AUSTRALIA_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CHINA, (uint64_t)(CURRENCY_CHINA_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWEDEN, (uint64_t)(CURRENCY_SWEDEN_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FRANCE, (uint64_t)(CURRENCY_FRANCE_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CANADA, (uint64_t)(CURRENCY_CANADA_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_JAPAN, (uint64_t)(CURRENCY_JAPAN_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_THAILAND, (uint64_t)(CURRENCY_THAILAND_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_NEW_ZEALAND, (uint64_t)(CURRENCY_NEW_ZEALAND_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_ARAB_EMIRATES, (uint64_t)(CURRENCY_UNITED_ARAB_EMIRATES_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FINLAND, (uint64_t)(CURRENCY_FINLAND_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LUXEMBOURG, (uint64_t)(CURRENCY_LUXEMBOURG_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SINGAPORE, (uint64_t)(CURRENCY_SINGAPORE_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_HUNGARY, (uint64_t)(CURRENCY_HUNGARY_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CZECH_REPUBLIC, (uint64_t)(CURRENCY_CZECH_REPUBLIC_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MALAYSIA, (uint64_t)(CURRENCY_MALAYSIA_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UKRAINE, (uint64_t)(CURRENCY_UKRAINE_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_ESTONIA, (uint64_t)(CURRENCY_ESTONIA_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MONACO, (uint64_t)(CURRENCY_MONACO_DELEGATE_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LIECHTENSTEIN, (uint64_t)(CURRENCY_LIECHTENSTEIN_DELEGATE_PAYOUT / halvingFactor)));
+    uint32_t numberOfHalvings = getNumberOfHalvings(blockHeight);
+    UAmount amount = getHalvedPayouts().delegatePayouts[numberOfHalvings];
+
+    Log(LOG_LEVEL_INFO) << "BlockHelper::calculateDelegatePayout() halvingFactor:" << (1 << numberOfHalvings);
+    Log(LOG_LEVEL_INFO) << "BlockHelper::calculateDelegatePayout() UCH payout:" << amount.map[CURRENCY_SWITZERLAND];
 
     return amount;
 }
 
 UAmount BlockHelper::calculateDevFundPayout(uint32_t blockHeight) {
-    uint32_t numberOfHalvings = (uint32_t)(blockHeight / HALVING_INTERVAL_IN_BLOCKS);
-    int32_t halvingFactor = 1;
-
-    for(int i = 0; i < numberOfHalvings && i < NUMBER_OF_HALVINGS; i++) {
-        halvingFactor = halvingFactor * 2;
-    }
-
-    UAmount amount;
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWITZERLAND,(uint64_t)( CURRENCY_SWITZERLAND_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_GERMANY, (uint64_t)(CURRENCY_GERMANY_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRIA, (uint64_t)(CURRENCY_AUSTRIA_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_KINGDOM, (uint64_t)(CURRENCY_UNITED_KINGDOM_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_IRELAND, (uint64_t)(CURRENCY_IRELAND_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_USA, (uint64_t)(CURRENCY_USA_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRALIA, (uint64_t)(CURRENCY_AUSTRALIA_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CHINA, (uint64_t)(CURRENCY_CHINA_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWEDEN, (uint64_t)(CURRENCY_SWEDEN_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FRANCE, (uint64_t)(CURRENCY_FRANCE_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CANADA, (uint64_t)(CURRENCY_CANADA_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_JAPAN, (uint64_t)(CURRENCY_JAPAN_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_THAILAND, (uint64_t)(CURRENCY_THAILAND_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_NEW_ZEALAND, (uint64_t)(CURRENCY_NEW_ZEALAND_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_ARAB_EMIRATES, (uint64_t)(CURRENCY_UNITED_ARAB_EMIRATES_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FINLAND, (uint64_t)(CURRENCY_FINLAND_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LUXEMBOURG, (uint64_t)(CURRENCY_LUXEMBOURG_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SINGAPORE, (uint64_t)(CURRENCY_SINGAPORE_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_HUNGARY, (uint64_t)(CURRENCY_HUNGARY_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CZECH_REPUBLIC, (uint64_t)(CURRENCY_CZECH_REPUBLIC_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MALAYSIA, (uint64_t)(CURRENCY_MALAYSIA_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UKRAINE, (uint64_t)(CURRENCY_UKRAINE_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_ESTONIA, (uint64_t)(CURRENCY_ESTONIA_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MONACO, (uint64_t)(CURRENCY_MONACO_DEVELOPMENT_PAYOUT / halvingFactor)));
-    amount.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LIECHTENSTEIN, (uint64_t)(CURRENCY_LIECHTENSTEIN_DEVELOPMENT_PAYOUT / halvingFactor)));
-
-    return amount;
+    return getHalvedPayouts().devFundPayouts[getNumberOfHalvings(blockHeight)];
 }
 
 UAmount32 BlockHelper::calculateUbiReceiverCount(Block* block, BlockHeader* previousBlockHeader) {
 
     if(previousBlockHeader == nullptr) {
         UAmount32 newUbiReceiverCount;
+        for(const CurrencyParams& params : currencyParams) {
+            newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(params.currency, 0));
+        }
 
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_SWITZERLAND, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_GERMANY, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_AUSTRIA, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_UNITED_KINGDOM, 0));
-
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_IRELAND, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_USA, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_AUSTRALIA, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_CHINA, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_SWEDEN, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_FRANCE, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_CANADA, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_JAPAN, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_THAILAND, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_NEW_ZEALAND, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_UNITED_ARAB_EMIRATES, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_FINLAND, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_LUXEMBOURG, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_SINGAPORE, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_HUNGARY, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_CZECH_REPUBLIC, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_MALAYSIA, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_UKRAINE, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_ESTONIA, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_MONACO, 0));
-        newUbiReceiverCount.map.insert(std::pair<uint8_t, CAmount32>(CURRENCY_LIECHTENSTEIN, 0));
-        
         return newUbiReceiverCount;
     }
 
     UAmount32 newUbiReceiverCount = previousBlockHeader->getUbiReceiverCount();
 
     CertStore& certStore = CertStore::Instance();
-    std::unordered_map<std::string, Cert>* dscList = certStore.getDSCList();
 
     //go through all transactions and check for new subscriptions/certificate addition or removal
     for(Transaction transaction: block->getTransactions()) {
@@ -574,24 +601,25 @@ UAmount32 BlockHelper::calculateUbiReceiverCount(Block* block, BlockHeader* prev
         }
     }
 
-    // go through all DSCs to find out if one has been deactivated between previous and current block
-    // @TODO this is not the most performant solution, find something better
-    for(std::unordered_map<std::string, Cert>::iterator it = dscList->begin(); it != dscList->end(); ++it) {
-        if(it->second.getExpirationDate() > previousBlockHeader->getTimestamp()
-           && it->second.getExpirationDate() <= block->getHeader()->getTimestamp()) {
-            UAmount32 toSubstract;
-            toSubstract.map.insert(std::pair<uint8_t, CAmount32>(
-                    it->second.getCurrencyId(),
-                    DSCAttachedPassportCounter::getCount(it->second.getId()))
-            );
-            newUbiReceiverCount -= toSubstract;
+    // subtract the passports attached to DSCs that expired between previous and current block
+    std::vector<Cert*> expiredDSCs = certStore.getDSCsExpiringBetween(
+            previousBlockHeader->getTimestamp(),
+            block->getHeader()->getTimestamp()
+    );
 
-            Log(LOG_LEVEL_INFO) << "DSC with id:"
-                                << it->second.getId()
-                                << " and "
-                                << toSubstract
-                                << " attached IDs has been deactivated";
-        }
+    for(Cert* dsc : expiredDSCs) {
+        UAmount32 toSubstract;
+        toSubstract.map.insert(std::pair<uint8_t, CAmount32>(
+                dsc->getCurrencyId(),
+                DSCAttachedPassportCounter::getCount(dsc->getId()))
+        );
+        newUbiReceiverCount -= toSubstract;
+
+        Log(LOG_LEVEL_INFO) << "DSC with id:"
+                            << dsc->getId()
+                            << " and "
+                            << toSubstract
+                            << " attached IDs has been deactivated";
     }
 
     Log(LOG_LEVEL_INFO) << "newUbiReceiverCount:" << newUbiReceiverCount;
@@ -601,32 +629,9 @@ UAmount32 BlockHelper::calculateUbiReceiverCount(Block* block, BlockHeader* prev
 
 UAmount BlockHelper::getTotalPayout() {
     UAmount totalPayout;
-
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWITZERLAND, (uint64_t)(CURRENCY_SWITZERLAND_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_GERMANY, (uint64_t)(CURRENCY_GERMANY_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRIA, (uint64_t)(CURRENCY_AUSTRIA_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_KINGDOM, (uint64_t)(CURRENCY_UNITED_KINGDOM_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_IRELAND, (uint64_t)(CURRENCY_IRELAND_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_USA, (uint64_t)(CURRENCY_USA_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRALIA, (uint64_t)(CURRENCY_AUSTRALIA_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CHINA, (uint64_t)(CURRENCY_CHINA_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWEDEN, (uint64_t)(CURRENCY_SWEDEN_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FRANCE, (uint64_t)(CURRENCY_FRANCE_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CANADA, (uint64_t)(CURRENCY_CANADA_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_JAPAN, (uint64_t)(CURRENCY_JAPAN_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_THAILAND, (uint64_t)(CURRENCY_THAILAND_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_NEW_ZEALAND, (uint64_t)(CURRENCY_NEW_ZEALAND_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_ARAB_EMIRATES, (uint64_t)(CURRENCY_UNITED_ARAB_EMIRATES_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FINLAND, (uint64_t)(CURRENCY_FINLAND_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LUXEMBOURG, (uint64_t)(CURRENCY_LUXEMBOURG_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SINGAPORE, (uint64_t)(CURRENCY_SINGAPORE_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_HUNGARY, (uint64_t)(CURRENCY_HUNGARY_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CZECH_REPUBLIC, (uint64_t)(CURRENCY_CZECH_REPUBLIC_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MALAYSIA, (uint64_t)(CURRENCY_MALAYSIA_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UKRAINE, (uint64_t)(CURRENCY_UKRAINE_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_ESTONIA, (uint64_t)(CURRENCY_ESTONIA_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MONACO, (uint64_t)(CURRENCY_MONACO_EMISSION_RATE)));
-    totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LIECHTENSTEIN, (uint64_t)(CURRENCY_LIECHTENSTEIN_EMISSION_RATE)));
+    for(const CurrencyParams& params : currencyParams) {
+        totalPayout.map.insert(std::pair<uint8_t, CAmount>(params.currency, params.emissionRate));
+    }
 
     return totalPayout;
 }
@@ -634,82 +639,10 @@ UAmount BlockHelper::getTotalPayout() {
 void BlockHelper::calculatePayout(Block* block, BlockHeader* previousBlockHeader, UAmount32 newReceiverCount, UAmount &payout, UAmount &payoutRemainder) {
 
     if(previousBlockHeader == nullptr) {
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWITZERLAND, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWITZERLAND, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_GERMANY, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_GERMANY, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRIA, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRIA, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_KINGDOM, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_KINGDOM, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_IRELAND, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_IRELAND, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_USA, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_USA, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRALIA, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRALIA, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CHINA, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CHINA, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWEDEN, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWEDEN, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FRANCE, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FRANCE, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CANADA, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CANADA, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_JAPAN, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_JAPAN, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_THAILAND, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_THAILAND, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_NEW_ZEALAND, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_NEW_ZEALAND, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_ARAB_EMIRATES, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_ARAB_EMIRATES, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FINLAND, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FINLAND, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LUXEMBOURG, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LUXEMBOURG, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SINGAPORE, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SINGAPORE, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_HUNGARY, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_HUNGARY, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CZECH_REPUBLIC, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CZECH_REPUBLIC, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MALAYSIA, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MALAYSIA, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UKRAINE, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UKRAINE, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_ESTONIA, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_ESTONIA, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MONACO, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MONACO, 0));
-
-        payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LIECHTENSTEIN, 0));
-        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LIECHTENSTEIN, 0));
-
+        for(const CurrencyParams& params : currencyParams) {
+            payout.map.insert(std::pair<uint8_t, CAmount>(params.currency, 0));
+            payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(params.currency, 0));
+        }
         return;
     }
 
@@ -717,256 +650,20 @@ void BlockHelper::calculatePayout(Block* block, BlockHeader* previousBlockHeader
 
     totalPayout += previousBlockHeader->getPayoutRemainder();
 
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divCH = 0;
-    uint64_t remCH = 0;
-    if(newReceiverCount.map[CURRENCY_SWITZERLAND] != 0) {
-        divCH = (uint64_t) totalPayout.map[CURRENCY_SWITZERLAND] / newReceiverCount.map[CURRENCY_SWITZERLAND];
-        remCH = (uint64_t) totalPayout.map[CURRENCY_SWITZERLAND] % newReceiverCount.map[CURRENCY_SWITZERLAND];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWITZERLAND, divCH));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWITZERLAND, remCH));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divDE = 0;
-    uint64_t remDE = 0;
-    if(newReceiverCount.map[CURRENCY_GERMANY] != 0) {
-        divDE = (uint64_t) totalPayout.map[CURRENCY_GERMANY] / newReceiverCount.map[CURRENCY_GERMANY];
-        remDE = (uint64_t) totalPayout.map[CURRENCY_GERMANY] % newReceiverCount.map[CURRENCY_GERMANY];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_GERMANY, divDE));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_GERMANY, remDE));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divAT = 0;
-    uint64_t remAT = 0;
-    if(newReceiverCount.map[CURRENCY_AUSTRIA] != 0) {
-        divAT = (uint64_t) totalPayout.map[CURRENCY_AUSTRIA] / newReceiverCount.map[CURRENCY_AUSTRIA];
-        remAT = (uint64_t) totalPayout.map[CURRENCY_AUSTRIA] % newReceiverCount.map[CURRENCY_AUSTRIA];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRIA, divAT));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRIA, remAT));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divUK = 0;
-    uint64_t remUK = 0;
-    if(newReceiverCount.map[CURRENCY_UNITED_KINGDOM] != 0) {
-        divUK = (uint64_t) totalPayout.map[CURRENCY_UNITED_KINGDOM] / newReceiverCount.map[CURRENCY_UNITED_KINGDOM];
-        remUK = (uint64_t) totalPayout.map[CURRENCY_UNITED_KINGDOM] % newReceiverCount.map[CURRENCY_UNITED_KINGDOM];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_KINGDOM, divUK));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_KINGDOM, remUK));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divIE = 0;
-    uint64_t remIE = 0;
-    if(newReceiverCount.map[CURRENCY_IRELAND] != 0) {
-        divIE = (uint64_t) totalPayout.map[CURRENCY_IRELAND] / newReceiverCount.map[CURRENCY_IRELAND];
-        remIE = (uint64_t) totalPayout.map[CURRENCY_IRELAND] % newReceiverCount.map[CURRENCY_IRELAND];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_IRELAND, divIE));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_IRELAND, remIE));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divUS = 0;
-    uint64_t remUS = 0;
-    if(newReceiverCount.map[CURRENCY_USA] != 0) {
-        divUS = (uint64_t) totalPayout.map[CURRENCY_USA] / newReceiverCount.map[CURRENCY_USA];
-        remUS = (uint64_t) totalPayout.map[CURRENCY_USA] % newReceiverCount.map[CURRENCY_USA];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_USA, divUS));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_USA, remUS));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divAU = 0;
-    uint64_t remAU = 0;
-    if(newReceiverCount.map[CURRENCY_AUSTRALIA] != 0) {
-        divAU = (uint64_t) totalPayout.map[CURRENCY_AUSTRALIA] / newReceiverCount.map[CURRENCY_AUSTRALIA];
-        remAU = (uint64_t) totalPayout.map[CURRENCY_AUSTRALIA] % newReceiverCount.map[CURRENCY_AUSTRALIA];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRALIA, divAU));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_AUSTRALIA, remAU));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divCN = 0;
-    uint64_t remCN = 0;
-    if(newReceiverCount.map[CURRENCY_CHINA] != 0) {
-        divCN = (uint64_t) totalPayout.map[CURRENCY_CHINA] / newReceiverCount.map[CURRENCY_CHINA];
-        remCN = (uint64_t) totalPayout.map[CURRENCY_CHINA] % newReceiverCount.map[CURRENCY_CHINA];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CHINA, divCN));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CHINA, remCN));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divSE = 0;
-    uint64_t remSE = 0;
-    if(newReceiverCount.map[CURRENCY_SWEDEN] != 0) {
-        divSE = (uint64_t) totalPayout.map[CURRENCY_SWEDEN] / newReceiverCount.map[CURRENCY_SWEDEN];
-        remSE = (uint64_t) totalPayout.map[CURRENCY_SWEDEN] % newReceiverCount.map[CURRENCY_SWEDEN];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWEDEN, divSE));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SWEDEN, remSE));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divFR = 0;
-    uint64_t remFR = 0;
-    if(newReceiverCount.map[CURRENCY_FRANCE] != 0) {
-        divFR = (uint64_t) totalPayout.map[CURRENCY_FRANCE] / newReceiverCount.map[CURRENCY_FRANCE];
-        remFR = (uint64_t) totalPayout.map[CURRENCY_FRANCE] % newReceiverCount.map[CURRENCY_FRANCE];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FRANCE, divFR));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FRANCE, remFR));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divCA = 0;
-    uint64_t remCA = 0;
-    if(newReceiverCount.map[CURRENCY_CANADA] != 0) {
-        divCA = (uint64_t) totalPayout.map[CURRENCY_CANADA] / newReceiverCount.map[CURRENCY_CANADA];
-        remCA = (uint64_t) totalPayout.map[CURRENCY_CANADA] % newReceiverCount.map[CURRENCY_CANADA];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CANADA, divCA));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CANADA, remCA));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divJP = 0;
-    uint64_t remJP = 0;
-    if(newReceiverCount.map[CURRENCY_JAPAN] != 0) {
-        divJP = (uint64_t) totalPayout.map[CURRENCY_JAPAN] / newReceiverCount.map[CURRENCY_JAPAN];
-        remJP = (uint64_t) totalPayout.map[CURRENCY_JAPAN] % newReceiverCount.map[CURRENCY_JAPAN];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_JAPAN, divJP));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_JAPAN, remJP));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divTH = 0;
-    uint64_t remTH = 0;
-    if(newReceiverCount.map[CURRENCY_THAILAND] != 0) {
-        divTH = (uint64_t) totalPayout.map[CURRENCY_THAILAND] / newReceiverCount.map[CURRENCY_THAILAND];
-        remTH = (uint64_t) totalPayout.map[CURRENCY_THAILAND] % newReceiverCount.map[CURRENCY_THAILAND];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_THAILAND, divTH));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_THAILAND, remTH));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divNZ = 0;
-    uint64_t remNZ = 0;
-    if(newReceiverCount.map[CURRENCY_NEW_ZEALAND] != 0) {
-        divNZ = (uint64_t) totalPayout.map[CURRENCY_NEW_ZEALAND] / newReceiverCount.map[CURRENCY_NEW_ZEALAND];
-        remNZ = (uint64_t) totalPayout.map[CURRENCY_NEW_ZEALAND] % newReceiverCount.map[CURRENCY_NEW_ZEALAND];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_NEW_ZEALAND, divNZ));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_NEW_ZEALAND, remNZ));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divAE = 0;
-    uint64_t remAE = 0;
-    if(newReceiverCount.map[CURRENCY_UNITED_ARAB_EMIRATES] != 0) {
-        divAE = (uint64_t) totalPayout.map[CURRENCY_UNITED_ARAB_EMIRATES] / newReceiverCount.map[CURRENCY_UNITED_ARAB_EMIRATES];
-        remAE = (uint64_t) totalPayout.map[CURRENCY_UNITED_ARAB_EMIRATES] % newReceiverCount.map[CURRENCY_UNITED_ARAB_EMIRATES];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_ARAB_EMIRATES, divAE));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UNITED_ARAB_EMIRATES, remAE));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divFI = 0;
-    uint64_t remFI = 0;
-    if(newReceiverCount.map[CURRENCY_FINLAND] != 0) {
-        divFI = (uint64_t) totalPayout.map[CURRENCY_FINLAND] / newReceiverCount.map[CURRENCY_FINLAND];
-        remFI = (uint64_t) totalPayout.map[CURRENCY_FINLAND] % newReceiverCount.map[CURRENCY_FINLAND];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FINLAND, divFI));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_FINLAND, remFI));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divLU = 0;
-    uint64_t remLU = 0;
-    if(newReceiverCount.map[CURRENCY_LUXEMBOURG] != 0) {
-        divLU = (uint64_t) totalPayout.map[CURRENCY_LUXEMBOURG] / newReceiverCount.map[CURRENCY_LUXEMBOURG];
-        remLU = (uint64_t) totalPayout.map[CURRENCY_LUXEMBOURG] % newReceiverCount.map[CURRENCY_LUXEMBOURG];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LUXEMBOURG, divLU));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LUXEMBOURG, remLU));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divSG = 0;
-    uint64_t remSG = 0;
-    if(newReceiverCount.map[CURRENCY_SINGAPORE] != 0) {
-        divSG = (uint64_t) totalPayout.map[CURRENCY_SINGAPORE] / newReceiverCount.map[CURRENCY_SINGAPORE];
-        remSG = (uint64_t) totalPayout.map[CURRENCY_SINGAPORE] % newReceiverCount.map[CURRENCY_SINGAPORE];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SINGAPORE, divSG));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_SINGAPORE, remSG));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divHU = 0;
-    uint64_t remHU = 0;
-    if(newReceiverCount.map[CURRENCY_HUNGARY] != 0) {
-        divHU = (uint64_t) totalPayout.map[CURRENCY_HUNGARY] / newReceiverCount.map[CURRENCY_HUNGARY];
-        remHU = (uint64_t) totalPayout.map[CURRENCY_HUNGARY] % newReceiverCount.map[CURRENCY_HUNGARY];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_HUNGARY, divHU));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_HUNGARY, remHU));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divCZ = 0;
-    uint64_t remCZ = 0;
-    if(newReceiverCount.map[CURRENCY_CZECH_REPUBLIC] != 0) {
-        divCZ = (uint64_t) totalPayout.map[CURRENCY_CZECH_REPUBLIC] / newReceiverCount.map[CURRENCY_CZECH_REPUBLIC];
-        remCZ = (uint64_t) totalPayout.map[CURRENCY_CZECH_REPUBLIC] % newReceiverCount.map[CURRENCY_CZECH_REPUBLIC];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CZECH_REPUBLIC, divCZ));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_CZECH_REPUBLIC, remCZ));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divMY = 0;
-    uint64_t remMY = 0;
-    if(newReceiverCount.map[CURRENCY_MALAYSIA] != 0) {
-        divMY = (uint64_t) totalPayout.map[CURRENCY_MALAYSIA] / newReceiverCount.map[CURRENCY_MALAYSIA];
-        remMY = (uint64_t) totalPayout.map[CURRENCY_MALAYSIA] % newReceiverCount.map[CURRENCY_MALAYSIA];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MALAYSIA, divMY));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MALAYSIA, remMY));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divUA = 0;
-    uint64_t remUA = 0;
-    if(newReceiverCount.map[CURRENCY_UKRAINE] != 0) {
-        divUA = (uint64_t) totalPayout.map[CURRENCY_UKRAINE] / newReceiverCount.map[CURRENCY_UKRAINE];
-        remUA = (uint64_t) totalPayout.map[CURRENCY_UKRAINE] % newReceiverCount.map[CURRENCY_UKRAINE];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UKRAINE, divUA));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_UKRAINE, remUA));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divEE = 0;
-    uint64_t remEE = 0;
-    if(newReceiverCount.map[CURRENCY_ESTONIA] != 0) {
-        divEE = (uint64_t) totalPayout.map[CURRENCY_ESTONIA] / newReceiverCount.map[CURRENCY_ESTONIA];
-        remEE = (uint64_t) totalPayout.map[CURRENCY_ESTONIA] % newReceiverCount.map[CURRENCY_ESTONIA];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_ESTONIA, divEE));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_ESTONIA, remEE));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divMC = 0;
-    uint64_t remMC = 0;
-    if(newReceiverCount.map[CURRENCY_MONACO] != 0) {
-        divMC = (uint64_t) totalPayout.map[CURRENCY_MONACO] / newReceiverCount.map[CURRENCY_MONACO];
-        remMC = (uint64_t) totalPayout.map[CURRENCY_MONACO] % newReceiverCount.map[CURRENCY_MONACO];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MONACO, divMC));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_MONACO, remMC));
-
-    // -------------------------------------------------------------------------------------------------------
-    uint64_t divLI = 0;
-    uint64_t remLI = 0;
-    if(newReceiverCount.map[CURRENCY_LIECHTENSTEIN] != 0) {
-        divLI = (uint64_t) totalPayout.map[CURRENCY_LIECHTENSTEIN] / newReceiverCount.map[CURRENCY_LIECHTENSTEIN];
-        remLI = (uint64_t) totalPayout.map[CURRENCY_LIECHTENSTEIN] % newReceiverCount.map[CURRENCY_LIECHTENSTEIN];
-    }
-    payout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LIECHTENSTEIN, divLI));
-    payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_LIECHTENSTEIN, remLI));
+    // the emission of a currency is split between its receivers, what can't be split is carried over to the next block
+    for(const CurrencyParams& params : currencyParams) {
+        CAmount currencyTotal = totalPayout.map[params.currency];
+        CAmount32 receiverCount = newReceiverCount.map[params.currency];
 
+        CAmount currencyPayout = 0;
+        CAmount currencyRemainder = 0;
+        if(receiverCount != 0) {
+            currencyPayout = currencyTotal / receiverCount;
+            currencyRemainder = currencyTotal % receiverCount;
+        }
+        payout.map.insert(std::pair<uint8_t, CAmount>(params.currency, currencyPayout));
+        payoutRemainder.map.insert(std::pair<uint8_t, CAmount>(params.currency, currencyRemainder));
+    }
 }
 
 std::vector<unsigned char> BlockHelper::computeBlockHeaderHash(BlockHeader header) {
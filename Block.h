@@ -28,6 +28,8 @@ public:
 class BlockHelper {
 public:
     static bool verifyBlock(Block* block);
+    static bool verifyBlockHeader(BlockHeader* header, BlockHeader* previousBlockHeader);
+    static bool isAssumedValid(BlockHeader* header);
     static bool applyBlock(Block* block);
     static bool undoBlock(Block* block);
     static UAmount calculateDelegatePayout(uint32_t blockHeight);
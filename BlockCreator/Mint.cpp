@@ -18,6 +18,7 @@
 #include "../Wallet.h"
 #include "../AddressHelper.h"
 #include "../App.h"
+#include <unordered_set>
 
 Block Mint::mintBlock() {
     Log(LOG_LEVEL_INFO) << "Mint::mintBlock()";
@@ -103,19 +104,13 @@ Block Mint::mintBlock() {
     // Check for double inputs which can only occur because of votes
 
     // index transaction inputs
-    std::vector<std::string> txInputs;
+    std::unordered_set<std::string> txInputs;
     for(std::vector<Transaction>::iterator it = transactionList.begin(); it != transactionList.end();) {
         bool doRemove = false;
         for(TxIn txIn: it->getTxIns()) {
-            auto txInputsIt = std::find(txInputs.begin(),
-                                        txInputs.end(),
-                                        Hexdump::vectorToHexString(txIn.getInAddress())
-            );
-
-            if(txInputsIt != txInputs.end()) {
+            if(!txInputs.insert(TransactionHelper::getInputKey(txIn.getInAddress())).second) {
                 doRemove = true;
             }
-            txInputs.emplace_back(Hexdump::vectorToHexString(txIn.getInAddress()));
         }
 
         if(doRemove) {
@@ -137,12 +132,7 @@ Block Mint::mintBlock() {
                        it->getTxOuts().front().getScript().getScript().size());
         voScript >> *vote;
 
-        auto txInputsIt = std::find(txInputs.begin(),
-                                    txInputs.end(),
-                                    Hexdump::vectorToHexString(vote->getTargetPubKey())
-        );
-
-        txInputs.emplace_back(Hexdump::vectorToHexString(vote->getTargetPubKey()));
+        txInputs.insert(TransactionHelper::getInputKey(vote->getTargetPubKey()));
         it++;
     }
 
@@ -150,15 +140,9 @@ Block Mint::mintBlock() {
     for(std::vector<Transaction>::iterator it = voteList.begin(); it != voteList.end();) {
         bool doRemove = false;
         for(TxIn txIn: it->getTxIns()) {
-            auto txInputsIt = std::find(txInputs.begin(),
-                                        txInputs.end(),
-                                        Hexdump::vectorToHexString(txIn.getInAddress())
-            );
-
-            if(txInputsIt != txInputs.end()) {
+            if(!txInputs.insert(TransactionHelper::getInputKey(txIn.getInAddress())).second) {
                 doRemove = true;
             }
-            txInputs.emplace_back(Hexdump::vectorToHexString(txIn.getInAddress()));
         }
 
         if(doRemove) {
@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "BlockDatWriter.h"
+#include "BlockStore.h"
+#include "ChainParams.h"
+#include "Config.h"
+#include "DB/DB.h"
+#include "FS/FS.h"
+#include "uint256.h"
+#include "Tools/Log.h"
+
+BlockDatWriter::~BlockDatWriter() {
+    this->close();
+}
+
+uint32_t BlockDatWriter::getFileNumber(std::vector<unsigned char> blockDatPath) {
+    std::string blockDatPathString(blockDatPath.begin(), blockDatPath.end());
+    size_t nameStart = blockDatPathString.find_last_of("/\\") + 1;
+
+    return (uint32_t)atoi(blockDatPathString.substr(nameStart).c_str());
+}
+
+/**
+ * The file number is big-endian so the keys of one file are contiguous
+ */
+std::vector<unsigned char> BlockDatWriter::getFileBlocksPrefix(uint32_t fileNumber) {
+    std::string prefix = BLOCK_DAT_FILE_BLOCKS_PREFIX;
+    std::vector<unsigned char> key(prefix.begin(), prefix.end());
+    for(int shift = 24; shift >= 0; shift -= 8) {
+        key.emplace_back((unsigned char)(fileNumber >> shift));
+    }
+
+    return key;
+}
+
+std::vector<unsigned char> BlockDatWriter::getFileBlockKey(uint32_t fileNumber, std::vector<unsigned char> blockHeaderHash) {
+    std::vector<unsigned char> key = getFileBlocksPrefix(fileNumber);
+    key.insert(key.end(), blockHeaderHash.begin(), blockHeaderHash.end());
+
+    return key;
+}
+
+/**
+ * Resumes at the stored position, nodes without one continue at the end of their newest blockdat file
+ */
+bool BlockDatWriter::open() {
+    DB& db = DB::Instance();
+    std::string positionKey = BLOCK_DAT_POSITION_KEY;
+
+    this->loadFiles();
+
+    BlockDatPosition storedPosition;
+    if(db.deserializeFromDb(DB_BLOCK_INDEX, std::vector<unsigned char>(positionKey.begin(), positionKey.end()), storedPosition)) {
+        return this->openFile(storedPosition.fileNumber, storedPosition.offset);
+    }
+
+    std::vector<unsigned char> blockDatPath = FS::getBlockDatPath();
+
+    return this->openFile(getFileNumber(blockDatPath), FS::getEofPosition(blockDatPath));
+}
+
+/**
+ * Nodes that stored blocks before the heights were tracked rebuild them once from the block index
+ */
+void BlockDatWriter::loadFiles() {
+    DB& db = DB::Instance();
+    std::string filesKey = BLOCK_DAT_FILES_KEY;
+
+    if(db.deserializeFromDb(DB_BLOCK_INDEX, std::vector<unsigned char>(filesKey.begin(), filesKey.end()), this->files)) {
+        return;
+    }
+
+    DBIterator* it = db.newIterator(DB_BLOCK_INDEX);
+    for(; it->valid(); it->next()) {
+        // the block index also holds the writer state, only 32 bytes keys are header hashes
+        leveldb::Slice key = it->key();
+        if(key.size() != uint256::size()) {
+            continue;
+        }
+
+        BlockIndex index;
+        BlockHeader header;
+        if(!it->deserializeValue(index) || !db.deserializeFromDb(DB_BLOCK_HEADERS, std::vector<unsigned char>(key.data(), key.data() + key.size()), header)) {
+            continue;
+        }
+
+        uint32_t fileNumber = getFileNumber(index.getBlockDatPath());
+        uint64_t& highestBlockHeight = this->files.highestBlockHeights[fileNumber];
+        if(header.getBlockHeight() > highestBlockHeight) {
+            highestBlockHeight = header.getBlockHeight();
+        }
+        db.putInDB(DB_BLOCK_INDEX, getFileBlockKey(fileNumber, std::vector<unsigned char>(key.data(), key.data() + key.size())), std::vector<unsigned char>());
+    }
+    delete it;
+
+    db.serializeToDb(DB_BLOCK_INDEX, std::vector<unsigned char>(filesKey.begin(), filesKey.end()), this->files);
+}
+
+bool BlockDatWriter::openFile(uint32_t fileNumber, uint64_t offset) {
+    std::vector<unsigned char> blockDatPath = FS::getBlockDatPath(fileNumber);
+    FS::touchFile(blockDatPath);
+
+    char cPath[512];
+    FS::charPathFromVectorPath(cPath, blockDatPath);
+    this->file = fopen(cPath, "rb+");
+    if(this->file == nullptr) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "failed to open blockdat file " << cPath;
+        return false;
+    }
+
+    fseek(this->file, 0, SEEK_END);
+    this->allocatedSize = (uint64_t)ftell(this->file);
+    if(offset > this->allocatedSize) {
+        Log(LOG_LEVEL_ERROR) << "blockdat file " << cPath << " is shorter than its stored position";
+        offset = this->allocatedSize;
+    }
+    fseek(this->file, (long)offset, SEEK_SET);
+
+    this->position.fileNumber = fileNumber;
+    this->position.offset = offset;
+
+    Log(LOG_LEVEL_INFO) << "writing blocks to " << cPath << " at offset " << offset;
+
+    return true;
+}
+
+/**
+ * Cuts off the preallocated tail so finished files end with their last block
+ */
+void BlockDatWriter::closeFile() {
+    if(this->file == nullptr) {
+        return;
+    }
+
+    this->sync();
+#if !defined(_WIN32)
+    if(this->allocatedSize > this->position.offset && ftruncate(fileno(this->file), (off_t)this->position.offset) == 0) {
+        this->allocatedSize = this->position.offset;
+    }
+#endif
+    fclose(this->file);
+    this->file = nullptr;
+}
+
+/**
+ * Grows the file in BLOCK_FILES_PREALLOCATION_CHUNK_SIZE steps to limit fragmentation
+ * Windows can't resize a file while it is mapped by the BlockStore, there it grows with each write
+ */
+void BlockDatWriter::preallocate(uint64_t size) {
+#if !defined(_WIN32)
+    if(size <= this->allocatedSize) {
+        return;
+    }
+
+    uint64_t chunks = (size + BLOCK_FILES_PREALLOCATION_CHUNK_SIZE - 1) / BLOCK_FILES_PREALLOCATION_CHUNK_SIZE;
+    uint64_t newSize = chunks * BLOCK_FILES_PREALLOCATION_CHUNK_SIZE;
+    if(posix_fallocate(fileno(this->file), (off_t)this->allocatedSize, (off_t)(newSize - this->allocatedSize)) == 0) {
+        this->allocatedSize = newSize;
+    }
+#endif
+}
+
+void BlockDatWriter::sync() {
+    if(this->unsyncedBlocks == 0) {
+        return;
+    }
+
+    fflush(this->file);
+#if defined(_WIN32)
+    _commit(_fileno(this->file));
+#else
+    fsync(fileno(this->file));
+#endif
+    this->unsyncedBlocks = 0;
+}
+
+/**
+ * Appends a serialized block with a single write, the new position is stored with the current DB block transaction
+ * The block is flushed to the OS right away so it can be read through the blockdat mapping.
+ * With the default sync interval of 1 it is also synced before the transaction indexing it commits,
+ * larger intervals let a power loss drop blocks the committed index still points to.
+ */
+bool BlockDatWriter::append(const char* data, uint64_t size, uint64_t blockHeight, std::vector<unsigned char> &blockDatPath, uint64_t &startPosition) {
+    Config& config = Config::Instance();
+    DB& db = DB::Instance();
+
+    writerMutex.lock();
+    if(this->file == nullptr && !this->open()) {
+        writerMutex.unlock();
+        return false;
+    }
+
+    if(this->position.offset > BLOCK_FILES_MAX_SIZE) {
+        this->closeFile();
+        if(!this->openFile(this->position.fileNumber + 1, 0)) {
+            writerMutex.unlock();
+            return false;
+        }
+    }
+
+    if(config.getPreallocateBlockDatFiles()) {
+        this->preallocate(this->position.offset + size);
+    }
+
+    if(fwrite(data, 1, size, this->file) != size || fflush(this->file) != 0) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "failed to write to blockdat file " << this->position.fileNumber;
+        fseek(this->file, (long)this->position.offset, SEEK_SET);
+        writerMutex.unlock();
+        return false;
+    }
+
+    blockDatPath = FS::getBlockDatPath(this->position.fileNumber);
+    startPosition = this->position.offset;
+    this->position.offset += size;
+    if(this->position.offset > this->allocatedSize) {
+        this->allocatedSize = this->position.offset;
+    }
+
+    std::string positionKey = BLOCK_DAT_POSITION_KEY;
+    db.serializeToDb(DB_BLOCK_INDEX, std::vector<unsigned char>(positionKey.begin(), positionKey.end()), this->position);
+
+    uint64_t& highestBlockHeight = this->files.highestBlockHeights[this->position.fileNumber];
+    if(blockHeight > highestBlockHeight) {
+        highestBlockHeight = blockHeight;
+        std::string filesKey = BLOCK_DAT_FILES_KEY;
+        db.serializeToDb(DB_BLOCK_INDEX, std::vector<unsigned char>(filesKey.begin(), filesKey.end()), this->files);
+    }
+
+    this->unsyncedBlocks++;
+    if(config.getBlockDatSyncInterval() > 0 && this->unsyncedBlocks >= config.getBlockDatSyncInterval()) {
+        this->sync();
+    }
+    writerMutex.unlock();
+
+    return true;
+}
+
+/**
+ * Files whose blocks are all at or below pruneHeight, the file currently written to is never pruned
+ */
+std::vector<uint32_t> BlockDatWriter::getPrunableFiles(uint64_t pruneHeight) {
+    std::vector<uint32_t> prunableFiles;
+
+    writerMutex.lock();
+    if(this->file != nullptr || this->open()) {
+        for(auto& fileHeight : this->files.highestBlockHeights) {
+            if(fileHeight.first != this->position.fileNumber && fileHeight.second <= pruneHeight) {
+                prunableFiles.emplace_back(fileHeight.first);
+            }
+        }
+    }
+    writerMutex.unlock();
+
+    return prunableFiles;
+}
+
+/**
+ * The file's blocks are no longer indexed, it is deleted from disk by setUnlinked() once that has been committed
+ */
+void BlockDatWriter::setPruned(uint32_t fileNumber) {
+    DB& db = DB::Instance();
+
+    writerMutex.lock();
+    auto found = this->files.highestBlockHeights.find(fileNumber);
+    if(found != this->files.highestBlockHeights.end()) {
+        if(found->second > this->files.prunedBlockHeight) {
+            this->files.prunedBlockHeight = found->second;
+        }
+        this->files.highestBlockHeights.erase(found);
+        this->files.unlinkedFiles.emplace_back(fileNumber);
+
+        std::string filesKey = BLOCK_DAT_FILES_KEY;
+        db.serializeToDb(DB_BLOCK_INDEX, std::vector<unsigned char>(filesKey.begin(), filesKey.end()), this->files);
+    }
+    writerMutex.unlock();
+}
+
+/**
+ * Pruned files that are still waiting to be deleted from disk
+ */
+std::vector<uint32_t> BlockDatWriter::getUnlinkedFiles() {
+    writerMutex.lock();
+    if(this->file == nullptr) {
+        this->open();
+    }
+    std::vector<uint32_t> unlinkedFiles = this->files.unlinkedFiles;
+    writerMutex.unlock();
+
+    return unlinkedFiles;
+}
+
+void BlockDatWriter::setUnlinked(uint32_t fileNumber) {
+    DB& db = DB::Instance();
+
+    writerMutex.lock();
+    auto found = std::find(this->files.unlinkedFiles.begin(), this->files.unlinkedFiles.end(), fileNumber);
+    if(found != this->files.unlinkedFiles.end()) {
+        this->files.unlinkedFiles.erase(found);
+
+        std::string filesKey = BLOCK_DAT_FILES_KEY;
+        db.serializeToDb(DB_BLOCK_INDEX, std::vector<unsigned char>(filesKey.begin(), filesKey.end()), this->files);
+    }
+    writerMutex.unlock();
+}
+
+/**
+ * Blocks up to blockHeight are not stored, a node loaded from a snapshot starts without them
+ */
+void BlockDatWriter::setPrunedBlockHeight(uint64_t blockHeight) {
+    DB& db = DB::Instance();
+
+    writerMutex.lock();
+    if(this->file == nullptr) {
+        this->open();
+    }
+    if(blockHeight > this->files.prunedBlockHeight) {
+        this->files.prunedBlockHeight = blockHeight;
+
+        std::string filesKey = BLOCK_DAT_FILES_KEY;
+        db.serializeToDb(DB_BLOCK_INDEX, std::vector<unsigned char>(filesKey.begin(), filesKey.end()), this->files);
+    }
+    writerMutex.unlock();
+}
+
+uint64_t BlockDatWriter::getPrunedBlockHeight() {
+    writerMutex.lock();
+    if(this->file == nullptr) {
+        this->open();
+    }
+    uint64_t prunedBlockHeight = this->files.prunedBlockHeight;
+    writerMutex.unlock();
+
+    return prunedBlockHeight;
+}
+
+/**
+ * Reloads the position and the file heights last committed to the DB, the next block overwrites the bytes appended since
+ */
+void BlockDatWriter::revertToStoredPosition() {
+    writerMutex.lock();
+    if(this->file != nullptr) {
+        // not closeFile(), the stored position can be in an earlier file so nothing is truncated
+        fclose(this->file);
+        this->file = nullptr;
+        this->unsyncedBlocks = 0;
+        this->files = BlockDatFiles();
+        this->open();
+    }
+    writerMutex.unlock();
+}
+
+void BlockDatWriter::close() {
+    writerMutex.lock();
+    this->closeFile();
+    writerMutex.unlock();
+}
@@ -0,0 +1,95 @@
+
+#ifndef TX_BLOCKDATWRITER_H
+#define TX_BLOCKDATWRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "serialize.h"
+
+#define BLOCK_DAT_POSITION_KEY "blockDatPosition"
+#define BLOCK_DAT_FILES_KEY "blockDatFiles"
+#define BLOCK_DAT_FILE_BLOCKS_PREFIX "blockDatFileBlocks"
+
+/**
+ * Current blockdat file and the offset where the next block is written
+ * Preallocated files are larger than the offset, so it is stored in the block index store
+ */
+struct BlockDatPosition {
+    uint32_t fileNumber = 0;
+    uint64_t offset = 0;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(fileNumber);
+        READWRITE(offset);
+    }
+};
+
+/**
+ * Highest block height per blockdat file, used to decide when a file can be pruned
+ * The blocks of a file are listed under BLOCK_DAT_FILE_BLOCKS_PREFIX keys, so pruning doesn't scan the whole block index
+ */
+struct BlockDatFiles {
+    std::map<uint32_t, uint64_t> highestBlockHeights; // file number -> highest block height in it
+    uint64_t prunedBlockHeight = 0; // all blockdat files up to this height have been pruned
+    std::vector<uint32_t> unlinkedFiles; // pruned files that are still on disk
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(highestBlockHeights);
+        READWRITE(prunedBlockHeight);
+        READWRITE(unlinkedFiles);
+    }
+};
+
+/**
+ * Keeps the current blockdat file open and appends serialized blocks to it
+ * Files are rotated once they exceed BLOCK_FILES_MAX_SIZE
+ */
+class BlockDatWriter {
+private:
+    std::mutex writerMutex;
+    FILE* file = nullptr;
+    BlockDatPosition position;
+    BlockDatFiles files;
+    uint64_t allocatedSize = 0;
+    uint32_t unsyncedBlocks = 0;
+
+    bool open();
+    void loadFiles();
+    bool openFile(uint32_t fileNumber, uint64_t offset);
+    void closeFile();
+    void preallocate(uint64_t size);
+    void sync();
+public:
+    static BlockDatWriter& Instance(){
+        static BlockDatWriter instance;
+        return instance;
+    }
+
+    ~BlockDatWriter();
+
+    static uint32_t getFileNumber(std::vector<unsigned char> blockDatPath);
+    static std::vector<unsigned char> getFileBlocksPrefix(uint32_t fileNumber);
+    static std::vector<unsigned char> getFileBlockKey(uint32_t fileNumber, std::vector<unsigned char> blockHeaderHash);
+
+    bool append(const char* data, uint64_t size, uint64_t blockHeight, std::vector<unsigned char> &blockDatPath, uint64_t &startPosition);
+    std::vector<uint32_t> getPrunableFiles(uint64_t pruneHeight);
+    void setPruned(uint32_t fileNumber);
+    std::vector<uint32_t> getUnlinkedFiles();
+    void setUnlinked(uint32_t fileNumber);
+    void setPrunedBlockHeight(uint64_t blockHeight);
+    void revertToStoredPosition();
+    uint64_t getPrunedBlockHeight();
+    void close();
+};
+
+
+#endif //TX_BLOCKDATWRITER_H
@@ -3,7 +3,7 @@
 #include "BlockHeader.h"
 #include "UAmount.h"
 
-std::vector<unsigned char> BlockHeader::getHeaderHash() {
+const std::vector<unsigned char>& BlockHeader::getHeaderHash() const {
     return headerHash;
 }
 
@@ -11,7 +11,7 @@ void BlockHeader::setHeaderHash(std::vector<unsigned char> headerHash) {
     this->headerHash = headerHash;
 }
 
-std::vector<unsigned char> BlockHeader::getPreviousHeaderHash() {
+const std::vector<unsigned char>& BlockHeader::getPreviousHeaderHash() const {
     return previousHeaderHash;
 }
 
@@ -33,9 +33,9 @@ public:
 
     void setVotes(const std::vector<Transaction> &votes);
 
-    std::vector<unsigned char> getHeaderHash();
+    const std::vector<unsigned char>& getHeaderHash() const;
     void setHeaderHash(std::vector<unsigned char> headerHash);
-    std::vector<unsigned char> getPreviousHeaderHash();
+    const std::vector<unsigned char>& getPreviousHeaderHash() const;
     void setPreviousHeaderHash(std::vector<unsigned char> previousHeaderHash);
     const std::vector<unsigned char> getMerkleRootHash();
     void setMerkleRootHash(std::vector<unsigned char> merkleRootHash);
@@ -1,45 +1,196 @@
 
+
 #include "BlockStore.h"
+#include "BlockDatWriter.h"
+#include "Config.h"
 #include "FS/FS.h"
 #include "DB/DB.h"
+#include "streams.h"
+#include "uint256.h"
+#include "Tools/Log.h"
+
+std::mutex BlockStore::mappingsMutex;
+std::map<std::string, BlockDatMappingPtr> BlockStore::mappings;
 
 void BlockStore::insertBlock(Block* block) {
+    BlockDatWriter& blockDatWriter = BlockDatWriter::Instance();
 
-    std::vector<unsigned char> blockDatPath = FS::getBlockDatPath();
+    CDataStream s(SER_DISK, SERIALIZATION_VERSION);
+    s << *block;
 
-    uint64_t bPosition = FS::getEofPosition(blockDatPath);
-    FS::serializeToFile(blockDatPath, *block);
-    uint64_t ePosition = FS::getEofPosition(blockDatPath);
+    std::vector<unsigned char> blockDatPath;
+    uint64_t startPosition;
+    if(!blockDatWriter.append(s.data(), s.size(), block->getHeader()->getBlockHeight(), blockDatPath, startPosition)) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "couldn't store block " << block->getHeader()->getHeaderHash();
+        return;
+    }
 
-    BlockIndex *index = new BlockIndex();
-    index->setBlockDatPath(blockDatPath);
-    index->setStartPosition(bPosition);
-    index->setSize(ePosition - bPosition);
+    BlockIndex index;
+    index.setBlockDatPath(blockDatPath);
+    index.setStartPosition(startPosition);
+    index.setSize(s.size());
 
     DB& db = DB::Instance();
-    db.serializeToDb(DB_BLOCK_INDEX, block->getHeader()->getHeaderHash(), *index);
+    db.serializeToDb(DB_BLOCK_INDEX, block->getHeader()->getHeaderHash(), index);
+    db.putInDB(DB_BLOCK_INDEX, BlockDatWriter::getFileBlockKey(BlockDatWriter::getFileNumber(blockDatPath), block->getHeader()->getHeaderHash()), std::vector<unsigned char>());
 }
 
-Block* BlockStore::getBlock(std::vector<unsigned char> blockHeaderHash) {
+/**
+ * Returns a mapping covering at least minimumSize bytes of the blockdat file, or nullptr
+ * Blocks are only appended, so the file is remapped when a block beyond the current mapping is requested
+ */
+BlockDatMappingPtr BlockStore::getMapping(std::vector<unsigned char> blockDatPath, uint64_t minimumSize) {
+    std::string pathString(blockDatPath.begin(), blockDatPath.end());
+
+    mappingsMutex.lock();
+    auto found = mappings.find(pathString);
+    if(found != mappings.end() && found->second->region.get_size() >= minimumSize) {
+        BlockDatMappingPtr mapping = found->second;
+        mappingsMutex.unlock();
+        return mapping;
+    }
+
+    BlockDatMappingPtr mapping;
+    try {
+        char cPath[512];
+        FS::charPathFromVectorPath(cPath, blockDatPath);
+
+        BlockDatMappingPtr newMapping = std::make_shared<BlockDatMapping>();
+        newMapping->file = boost::interprocess::file_mapping(cPath, boost::interprocess::read_only);
+        newMapping->region = boost::interprocess::mapped_region(newMapping->file, boost::interprocess::read_only);
+
+        if(newMapping->region.get_size() >= minimumSize) {
+            mappings[pathString] = newMapping;
+            mapping = newMapping;
+        } else {
+            Log(LOG_LEVEL_ERROR) << "blockdat file " << cPath << " is smaller than expected";
+        }
+    } catch (const boost::interprocess::interprocess_exception& e) {
+        Log(LOG_LEVEL_ERROR) << "failed to map blockdat file: " << e.what();
+    }
+    mappingsMutex.unlock();
+
+    return mapping;
+}
+
+bool BlockStore::getRawBlockView(std::vector<unsigned char> blockHeaderHash, RawBlockView &view) {
     DB& db = DB::Instance();
 
-    BlockIndex *index = new BlockIndex();
-    db.deserializeFromDb(DB_BLOCK_INDEX, blockHeaderHash, *index);
+    BlockIndex index;
+    if(!db.deserializeFromDb(DB_BLOCK_INDEX, blockHeaderHash, index)) {
+        return false;
+    }
+
+    BlockDatMappingPtr mapping = getMapping(index.getBlockDatPath(), index.getStartPosition() + index.getSize());
+    if(mapping == nullptr) {
+        return false;
+    }
 
-    uint64_t nextPos;
-    bool eof;
+    view.mapping = mapping;
+    view.data = (const char*)mapping->region.get_address() + index.getStartPosition();
+    view.size = index.getSize();
+
+    return true;
+}
 
+Block* BlockStore::getBlock(std::vector<unsigned char> blockHeaderHash) {
     Block* block = new Block();
-    FS::deserializeFromFile(index->getBlockDatPath(), BLOCK_SIZE_MAX, index->getStartPosition(), *block, nextPos , eof);
+
+    RawBlockView view;
+    if(!getRawBlockView(blockHeaderHash, view)) {
+        return block;
+    }
+
+    try {
+        SpanReader reader(SER_DISK, SERIALIZATION_VERSION, view.data, view.size);
+        reader >> *block;
+    } catch (const std::exception& e) {
+        Log(LOG_LEVEL_ERROR) << "failed to deserialize block " << blockHeaderHash << ": " << e.what();
+    }
 
     return block;
 }
 
 std::vector<unsigned char> BlockStore::getRawBlockVector(std::vector<unsigned char> blockHeaderHash) {
+    RawBlockView view;
+    if(!getRawBlockView(blockHeaderHash, view)) {
+        return std::vector<unsigned char>();
+    }
+
+    return std::vector<unsigned char>(view.data, view.data + view.size);
+}
+
+/**
+ * Unindexes the blockdat files whose blocks are buried deeper than the configured prune depth
+ * Has to be called inside the block transaction, the files are deleted by deleteUnlinkedBlockDatFiles() after the commit
+ */
+void BlockStore::pruneBlockDatFiles(uint64_t currentBlockchainHeight) {
+    Config& config = Config::Instance();
+    BlockDatWriter& blockDatWriter = BlockDatWriter::Instance();
     DB& db = DB::Instance();
 
-    BlockIndex *index = new BlockIndex();
-    db.deserializeFromDb(DB_BLOCK_INDEX, blockHeaderHash, *index);
+    if(config.getPruneDepth() == 0 || currentBlockchainHeight <= config.getPruneDepth()) {
+        return;
+    }
+
+    for(uint32_t fileNumber : blockDatWriter.getPrunableFiles(currentBlockchainHeight - config.getPruneDepth())) {
+        std::vector<unsigned char> prefix = BlockDatWriter::getFileBlocksPrefix(fileNumber);
+        uint64_t removedIndexCount = 0;
+
+        DBIterator* it = db.newIterator(DB_BLOCK_INDEX, prefix);
+        for(; it->valid(); it->next()) {
+            std::vector<unsigned char> key(it->key().data(), it->key().data() + it->key().size());
+            if(key.size() != prefix.size() + uint256::size()) {
+                continue;
+            }
+
+            db.removeFromDB(DB_BLOCK_INDEX, std::vector<unsigned char>(key.begin() + prefix.size(), key.end()));
+            db.removeFromDB(DB_BLOCK_INDEX, key);
+            removedIndexCount++;
+        }
+        delete it;
+
+        blockDatWriter.setPruned(fileNumber);
+        Log(LOG_LEVEL_INFO) << "pruned blockdat file " << fileNumber << ", removed " << removedIndexCount << " block index entries";
+    }
+}
+
+/**
+ * Deletes pruned blockdat files from disk, a file still in use is retried after the next block
+ */
+void BlockStore::deleteUnlinkedBlockDatFiles() {
+    BlockDatWriter& blockDatWriter = BlockDatWriter::Instance();
+
+    for(uint32_t fileNumber : blockDatWriter.getUnlinkedFiles()) {
+        std::vector<unsigned char> blockDatPath = FS::getBlockDatPath(fileNumber);
+
+        mappingsMutex.lock();
+        mappings.erase(std::string(blockDatPath.begin(), blockDatPath.end()));
+        mappingsMutex.unlock();
+
+        if(FS::fileExists(blockDatPath) && !FS::deleteFile(blockDatPath)) {
+            Log(LOG_LEVEL_WARNING) << "couldn't delete pruned blockdat file " << fileNumber;
+            continue;
+        }
+
+        blockDatWriter.setUnlinked(fileNumber);
+    }
+}
+
+/**
+ * Has to be called when a block transaction that inserted or pruned blocks has not been committed
+ */
+void BlockStore::discardUncommittedBlocks() {
+    BlockDatWriter& blockDatWriter = BlockDatWriter::Instance();
+
+    blockDatWriter.revertToStoredPosition();
+}
+
+/**
+ * Blocks below this height have been pruned and can't be served to peers
+ */
+uint64_t BlockStore::getLowestServedBlockHeight() {
+    BlockDatWriter& blockDatWriter = BlockDatWriter::Instance();
 
-    return FS::readFile(index->getBlockDatPath(), index->getStartPosition(), index->getSize());
+    return blockDatWriter.getPrunedBlockHeight() + 1;
 }
\ No newline at end of file
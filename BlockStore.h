@@ -2,13 +2,48 @@
 #ifndef TX_BLOCKSTORE_H
 #define TX_BLOCKSTORE_H
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include "Block.h"
 
+/**
+ * Read-only mapping of a whole blockdat file
+ * It is replaced by a new mapping once the file grew past it, readers still holding the old one keep it alive
+ */
+struct BlockDatMapping {
+    boost::interprocess::file_mapping file;
+    boost::interprocess::mapped_region region;
+};
+
+typedef std::shared_ptr<BlockDatMapping> BlockDatMappingPtr;
+
+/**
+ * Serialized block inside a blockdat mapping, the bytes stay valid as long as the view exists
+ */
+struct RawBlockView {
+    BlockDatMappingPtr mapping;
+    const char* data = nullptr;
+    uint64_t size = 0;
+};
+
 class BlockStore {
+private:
+    static std::mutex mappingsMutex;
+    static std::map<std::string, BlockDatMappingPtr> mappings; // blockdat path -> mapping
+    static BlockDatMappingPtr getMapping(std::vector<unsigned char> blockDatPath, uint64_t minimumSize);
 public:
     static void insertBlock(Block* block);
     static Block* getBlock(std::vector<unsigned char> blockHeaderHash);
+    static bool getRawBlockView(std::vector<unsigned char> blockHeaderHash, RawBlockView &view);
     static std::vector<unsigned char> getRawBlockVector(std::vector<unsigned char> blockHeaderHash);
+    static void pruneBlockDatFiles(uint64_t currentBlockchainHeight);
+    static void deleteUnlinkedBlockDatFiles();
+    static void discardUncommittedBlocks();
+    static uint64_t getLowestServedBlockHeight();
 };
 
 class BlockIndex {
@@ -0,0 +1,66 @@
+#include "BlockUndo.h"
+#include "DB/DB.h"
+#include "CertStore/CertStore.h"
+#include "PathSum/PathSum.h"
+#include "Consensus/VoteStore.h"
+#include "Tools/Log.h"
+
+/**
+ * Has to be called after the block has been applied and before its block transaction is committed
+ */
+BlockUndo BlockUndoHelper::createBlockUndo() {
+    DB& db = DB::Instance();
+    CertStore& certStore = CertStore::Instance();
+
+    std::vector<StoreValueUndo> storeValues;
+    for(auto &store : db.getPriorValues()) {
+        for(auto &priorValue : store.second) {
+            StoreValueUndo storeValueUndo;
+            storeValueUndo.store = store.first;
+            storeValueUndo.key = std::vector<unsigned char>(priorValue.first.begin(), priorValue.first.end());
+            storeValueUndo.wasPresent = priorValue.second.first;
+            storeValueUndo.value = std::vector<unsigned char>(priorValue.second.second.begin(), priorValue.second.second.end());
+            storeValues.emplace_back(storeValueUndo);
+        }
+    }
+
+    BlockUndo blockUndo;
+    blockUndo.setStoreValues(storeValues);
+    blockUndo.setCerts(certStore.endUndoRecording());
+
+    return blockUndo;
+}
+
+/**
+ * Has to be called inside a block transaction
+ */
+bool BlockUndoHelper::applyBlockUndo(BlockUndo* blockUndo) {
+    DB& db = DB::Instance();
+    CertStore& certStore = CertStore::Instance();
+    bool success = true;
+
+    for(StoreValueUndo storeValueUndo : blockUndo->getStoreValues()) {
+        if(storeValueUndo.wasPresent) {
+            success = db.putInDB(storeValueUndo.store, storeValueUndo.key, storeValueUndo.value) && success;
+        } else {
+            success = db.removeFromDB(storeValueUndo.store, storeValueUndo.key) && success;
+        }
+    }
+
+    for(CertUndo certUndo : blockUndo->getCerts()) {
+        if(!certStore.restoreCert(certUndo)) {
+            Log(LOG_LEVEL_ERROR) << "Failed to restore certificate: " << certUndo.certId;
+            success = false;
+        }
+    }
+
+    // undo payouts to PathSum
+    PathSum& pathSum = PathSum::Instance();
+    success = pathSum.popValue(1) && success;
+
+    // delegates are kept in memory and have to be reloaded from the restored store
+    VoteStore& voteStore = VoteStore::Instance();
+    voteStore.reloadDelegates();
+
+    return success;
+}
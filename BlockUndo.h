@@ -0,0 +1,71 @@
+
+#ifndef TX_BLOCKUNDO_H
+#define TX_BLOCKUNDO_H
+
+#include <cstdint>
+#include <vector>
+#include "serialize.h"
+#include "CertStore/CertUndo.h"
+
+/**
+ * Value a key of a chain state store had before a block modified it
+ */
+struct StoreValueUndo {
+    uint8_t store;
+    std::vector<unsigned char> key;
+    bool wasPresent = false;
+    std::vector<unsigned char> value;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(store);
+        READWRITE(key);
+        READWRITE(wasPresent);
+        READWRITE(value);
+    }
+};
+
+/**
+ * Written alongside every connected block to DB_BLOCK_UNDO.
+ * Holds everything needed to restore the state the block found when it was connected.
+ */
+class BlockUndo {
+private:
+    std::vector<StoreValueUndo> storeValues; // AddressStore, NTPSK used set, DSC counters and delegates
+    std::vector<CertUndo> certs;
+public:
+    std::vector<StoreValueUndo> getStoreValues() {
+        return storeValues;
+    }
+
+    void setStoreValues(std::vector<StoreValueUndo> storeValues) {
+        BlockUndo::storeValues = storeValues;
+    }
+
+    std::vector<CertUndo> getCerts() {
+        return certs;
+    }
+
+    void setCerts(std::vector<CertUndo> certs) {
+        BlockUndo::certs = certs;
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(storeValues);
+        READWRITE(certs);
+    }
+};
+
+class BlockUndoHelper {
+public:
+    static BlockUndo createBlockUndo();
+    static bool applyBlockUndo(BlockUndo* blockUndo);
+};
+
+
+#endif //TX_BLOCKUNDO_H
@@ -64,10 +64,10 @@ bool CertStore::undoLastActionOnCSCA(std::vector<unsigned char> certId, bool act
             statuses.pop_back();
             foundCert->setStatusList(statuses);
             foundCert->setNonce(foundCert->getNonce() - 1);
-            this->CSCAList[certId] = *foundCert;
+            this->CSCAList[uint160(certId)] = *foundCert;
             this->persistToFS("CSCA", certId);
         } else {
-            std::map<std::vector<unsigned char>, Cert>::iterator it = this->CSCAList.find(certId);
+            std::map<uint160, Cert>::iterator it = this->CSCAList.find(uint160(certId));
             this->CSCAList.erase(it);
 
             std::vector<unsigned char> path;
@@ -100,11 +100,12 @@ bool CertStore::undoLastActionOnDSC(std::vector<unsigned char> certId, bool acti
             statuses.pop_back();
             foundCert->setStatusList(statuses);
             foundCert->setNonce(foundCert->getNonce() - 1);
-            this->DSCList[Hexdump::vectorToHexString(certId)] = *foundCert;
+            this->DSCList[uint160(certId)] = *foundCert;
             this->persistToFS("DSC", certId);
         } else {
 
-            std::unordered_map<std::string, Cert>::iterator it = this->DSCList.find(Hexdump::vectorToHexString(certId));
+            std::unordered_map<uint160, Cert, BlobHasher>::iterator it = this->DSCList.find(uint160(certId));
+            this->removeFromDSCExpirationIndex(it->second.getExpirationDate(), it->first);
             this->DSCList.erase(it);
 
             std::vector<unsigned char> path;
@@ -208,6 +209,8 @@ bool CertStore::isCertSignedByCSCA(Cert* cert, uint32_t blockHeight) {
 }
 
 bool CertStore::addCSCA(Cert* cert, uint32_t blockHeight) {
+    this->recordUndo(TYPE_CSCA, cert->getId());
+
     if(this->isCertSignedByUBICrootCert(cert, true, TYPE_CSCA)) {
 
         Cert* existingCert = this->getCscaCertWithCertId(cert->getId());
@@ -216,7 +219,7 @@ bool CertStore::addCSCA(Cert* cert, uint32_t blockHeight) {
             if(!existingCert->isCertAtive()) {
                 existingCert->appendStatusList(std::pair<uint32_t, bool>(blockHeight, true));
                 existingCert->setNonce(cert->getNonce() + 1);
-                this->CSCAList[cert->getId()] = *existingCert;
+                this->CSCAList[uint160(cert->getId())] = *existingCert;
                 Log(LOG_LEVEL_INFO) << "reactivated CSCA: " << cert->getId();
                 return true;
             } else {
@@ -226,7 +229,7 @@ bool CertStore::addCSCA(Cert* cert, uint32_t blockHeight) {
         }
         cert->setNonce(cert->getNonce() + 1);
         cert->appendStatusList(std::pair<uint32_t, bool>(blockHeight, true));
-        this->CSCAList[cert->getId()] = *cert;
+        this->CSCAList[uint160(cert->getId())] = *cert;
         Log(LOG_LEVEL_INFO) << "added new CSCA: " << cert->getId();
 
 
@@ -238,6 +241,8 @@ bool CertStore::addCSCA(Cert* cert, uint32_t blockHeight) {
 }
 
 bool CertStore::addDSC(Cert* cert, uint32_t blockHeight) {
+    this->recordUndo(TYPE_DSC, cert->getId());
+
     if(this->isCertSignedByUBICrootCert(cert, true, TYPE_DSC)) {
         if(this->isCertSignedByCSCA(cert, blockHeight)) {
 
@@ -247,7 +252,7 @@ bool CertStore::addDSC(Cert* cert, uint32_t blockHeight) {
                 if(!existingCert->isCertAtive()) {
                     existingCert->appendStatusList(std::pair<uint32_t, bool>(blockHeight, true));
                     existingCert->setNonce(cert->getNonce() + 1);
-                    this->DSCList[Hexdump::vectorToHexString(cert->getId())] = *existingCert;
+                    this->DSCList[uint160(cert->getId())] = *existingCert;
                     Log(LOG_LEVEL_INFO) << "reactivated DSC: " << cert->getId();
                     return true;
                 } else {
@@ -259,7 +264,8 @@ bool CertStore::addDSC(Cert* cert, uint32_t blockHeight) {
             cert->appendStatusList(std::pair<uint32_t, bool>(blockHeight, true));
             cert->setNonce(cert->getNonce() + 1);
 
-            this->DSCList[Hexdump::vectorToHexString(cert->getId())] = *cert;
+            this->DSCList[uint160(cert->getId())] = *cert;
+            this->DSCExpirationIndex.insert(std::make_pair(cert->getExpirationDate(), uint160(cert->getId())));
 
             Log(LOG_LEVEL_INFO) << "added new DSC: " << cert->getId();
 
@@ -317,7 +323,13 @@ Cert* CertStore::getDscCertWithCertId(std::vector<unsigned char> certId) {
 
     Log(LOG_LEVEL_INFO) << "DSCList size: " << (int)this->DSCList.size();
 
-    std::unordered_map<std::string, Cert>::iterator it = this->DSCList.find(Hexdump::vectorToHexString(certId));
+    // cert ids of transactions can have any length
+    uint160 certKey;
+    if(!certKey.setFromVector(certId)) {
+        return nullptr;
+    }
+
+    std::unordered_map<uint160, Cert, BlobHasher>::iterator it = this->DSCList.find(certKey);
     if(it != this->DSCList.end()) {
         return &it->second;
     } else {
@@ -330,7 +342,13 @@ Cert* CertStore::getCscaCertWithCertId(std::vector<unsigned char> certId) {
 
     Log(LOG_LEVEL_INFO) << "CSCAList size: " << (int)this->CSCAList.size();
 
-    std::map<std::vector<unsigned char>, Cert>::iterator it = this->CSCAList.find(certId);
+    // cert ids of transactions can have any length
+    uint160 certKey;
+    if(!certKey.setFromVector(certId)) {
+        return nullptr;
+    }
+
+    std::map<uint160, Cert>::iterator it = this->CSCAList.find(certKey);
     if(it != this->CSCAList.end()) {
         return &it->second;
     } else {
@@ -383,13 +401,15 @@ bool CertStore::deactivateRootCert(std::vector<unsigned char> certId, BlockHeade
  * @return
  */
 bool CertStore::deactivateCSCA(std::vector<unsigned char> certId, BlockHeader* blockHeader) {
+    this->recordUndo(TYPE_CSCA, certId);
+
     Cert* existingCert = this->getCscaCertWithCertId(certId);
 
     if(existingCert != nullptr) {
         if(existingCert->isCertAtive()) {
             existingCert->appendStatusList(std::pair<uint64_t, bool>(blockHeader->getBlockHeight(), false));
             existingCert->setNonce(existingCert->getNonce() + 1);
-            this->CSCAList[existingCert->getId()] = *existingCert;
+            this->CSCAList[uint160(existingCert->getId())] = *existingCert;
             Log(LOG_LEVEL_INFO) << "deactivated CSCA cert: " << existingCert->getId();
             this->persistToFS("CSCA", existingCert->getId());
             return true;
@@ -404,6 +424,7 @@ bool CertStore::deactivateCSCA(std::vector<unsigned char> certId, BlockHeader* b
 }
 
 bool CertStore::deactivateDSC(std::vector<unsigned char> certId, BlockHeader* blockHeader) {
+    this->recordUndo(TYPE_DSC, certId);
 
     Cert* existingCert = this->getDscCertWithCertId(certId);
 
@@ -411,7 +432,7 @@ bool CertStore::deactivateDSC(std::vector<unsigned char> certId, BlockHeader* bl
         if(existingCert->isCertAtive()) {
             existingCert->appendStatusList(std::pair<uint64_t, bool>(blockHeader->getBlockHeight(), false));
             existingCert->setNonce(existingCert->getNonce() + 1);
-            this->DSCList[Hexdump::vectorToHexString(existingCert->getId())] = *existingCert;
+            this->DSCList[uint160(existingCert->getId())] = *existingCert;
             Log(LOG_LEVEL_INFO) << "deactivated DSC cert: " << existingCert->getId();
             this->persistToFS("DSC", existingCert->getId());
             return true;
@@ -447,7 +468,7 @@ void CertStore::loadFromFS() {
         Cert* cert = new Cert();
         FS::deserializeFromFile(file, *cert, CERT_SIZE_MAX);
         cert->finishDeserialization("csca");
-        this->CSCAList[cert->getId()] = *cert;
+        this->CSCAList[uint160(cert->getId())] = *cert;
     }
     Log(LOG_LEVEL_INFO) << "Loaded CSCA cert(s)";
 
@@ -459,7 +480,8 @@ void CertStore::loadFromFS() {
         Cert* cert = new Cert();
         FS::deserializeFromFile(file, *cert, CERT_SIZE_MAX);
         cert->finishDeserialization("dsc");
-        this->DSCList[Hexdump::vectorToHexString(cert->getId())] = *cert;
+        this->DSCList[uint160(cert->getId())] = *cert;
+        this->DSCExpirationIndex.insert(std::make_pair(cert->getExpirationDate(), uint160(cert->getId())));
     }
     Log(LOG_LEVEL_INFO) << "Loaded DSC cert(s)";
 }
@@ -583,11 +605,122 @@ std::map<std::vector<unsigned char>, Cert> CertStore::getRootList() {
     return RootList;
 }
 
-std::map<std::vector<unsigned char>, Cert>* CertStore::getCSCAList() {
+std::map<uint160, Cert>* CertStore::getCSCAList() {
     return &CSCAList;
 }
 
-std::unordered_map<std::string, Cert>* CertStore::getDSCList() {
+std::unordered_map<uint160, Cert, BlobHasher>* CertStore::getDSCList() {
     return &DSCList;
 }
 
+/**
+ * Returns the DSCs with after < expiration date <= until, ordered by expiration date
+ */
+std::vector<Cert*> CertStore::getDSCsExpiringBetween(uint64_t after, uint64_t until) {
+    std::vector<Cert*> response;
+
+    if(until <= after) {
+        return response;
+    }
+
+    auto end = this->DSCExpirationIndex.upper_bound(until);
+    for(auto it = this->DSCExpirationIndex.upper_bound(after); it != end; ++it) {
+        auto dsc = this->DSCList.find(it->second);
+        if(dsc != this->DSCList.end()) {
+            response.emplace_back(&dsc->second);
+        }
+    }
+
+    return response;
+}
+
+void CertStore::removeFromDSCExpirationIndex(uint64_t expirationDate, uint160 dscKey) {
+    auto range = this->DSCExpirationIndex.equal_range(expirationDate);
+    for(auto it = range.first; it != range.second; ++it) {
+        if(it->second == dscKey) {
+            this->DSCExpirationIndex.erase(it);
+            return;
+        }
+    }
+}
+
+/**
+ * Until endUndoRecording() is called, the state of every CSCA and DSC is saved before it gets modified
+ */
+void CertStore::beginUndoRecording() {
+    this->certUndos.clear();
+    this->isRecordingUndo = true;
+}
+
+std::vector<CertUndo> CertStore::endUndoRecording() {
+    this->isRecordingUndo = false;
+    std::vector<CertUndo> response = this->certUndos;
+    this->certUndos.clear();
+
+    return response;
+}
+
+void CertStore::recordUndo(uint8_t type, std::vector<unsigned char> certId) {
+    if(!this->isRecordingUndo) {
+        return;
+    }
+
+    // only the state before the first modification matters
+    for(CertUndo &certUndo : this->certUndos) {
+        if(certUndo.type == type && certUndo.certId == certId) {
+            return;
+        }
+    }
+
+    Cert* cert = type == TYPE_CSCA ? this->getCscaCertWithCertId(certId) : this->getDscCertWithCertId(certId);
+
+    CertUndo certUndo;
+    certUndo.type = type;
+    certUndo.certId = certId;
+    certUndo.wasPresent = cert != nullptr;
+    if(cert != nullptr) {
+        certUndo.statusList = cert->getStatusList();
+        certUndo.nonce = cert->getNonce();
+    }
+
+    this->certUndos.emplace_back(certUndo);
+}
+
+bool CertStore::restoreCert(CertUndo certUndo) {
+    const char* type = certUndo.type == TYPE_CSCA ? "CSCA" : "DSC";
+    Cert* cert = certUndo.type == TYPE_CSCA ? this->getCscaCertWithCertId(certUndo.certId) : this->getDscCertWithCertId(certUndo.certId);
+
+    if(!certUndo.wasPresent) {
+        if(cert == nullptr) {
+            return true;
+        }
+
+        if(certUndo.type == TYPE_CSCA) {
+            this->CSCAList.erase(uint160(certUndo.certId));
+        } else {
+            this->removeFromDSCExpirationIndex(cert->getExpirationDate(), uint160(certUndo.certId));
+            this->DSCList.erase(uint160(certUndo.certId));
+        }
+
+        std::vector<unsigned char> path;
+        path = FS::getCertDirectoryPath();
+        path = FS::concatPaths(path, certUndo.type == TYPE_CSCA ? "csca/" : "dsc/");
+        path = FS::concatPaths(path, Hexdump::vectorToHexVector(certUndo.certId));
+
+        FS::deleteFile(path);
+
+        return true;
+    }
+
+    if(cert == nullptr) {
+        Log(LOG_LEVEL_ERROR) << "cannot restore " << type << " cert, not found: " << certUndo.certId;
+        return false;
+    }
+
+    cert->setStatusList(certUndo.statusList);
+    cert->setNonce(certUndo.nonce);
+    this->persistToFS(type, certUndo.certId);
+
+    return true;
+}
+
@@ -14,15 +14,22 @@
 #include "../NtpEsk/NtpEsk.h"
 #include "../Countries/Currency.h"
 #include "Cert.h"
+#include "CertUndo.h"
 #include "../BlockHeader.h"
+#include "../uint256.h"
 
 using namespace std;
 
 class CertStore {
 private:
     std::map<std::vector<unsigned char>, Cert> RootList;
-    std::map<std::vector<unsigned char>, Cert> CSCAList;
-    std::unordered_map<std::string, Cert> DSCList;
+    std::map<uint160, Cert> CSCAList;
+    std::unordered_map<uint160, Cert, BlobHasher> DSCList;
+    std::multimap<uint64_t, uint160> DSCExpirationIndex; // expiration date -> DSCList key
+    void removeFromDSCExpirationIndex(uint64_t expirationDate, uint160 dscKey);
+    bool isRecordingUndo = false;
+    std::vector<CertUndo> certUndos;
+    void recordUndo(uint8_t type, std::vector<unsigned char> certId);
 
 public:
     static CertStore& Instance(){
@@ -52,8 +59,12 @@ public:
     static Cert* certFromFile(char* path);
     static X509 *createX509(const unsigned char* c, const unsigned char* cn1, const unsigned char* cn2, X509* signer,EVP_PKEY *pkey);
     std::map<std::vector<unsigned char>, Cert> getRootList();
-    std::map<std::vector<unsigned char>, Cert>* getCSCAList();
-    std::unordered_map<std::string, Cert>* getDSCList();
+    std::map<uint160, Cert>* getCSCAList();
+    std::unordered_map<uint160, Cert, BlobHasher>* getDSCList();
+    std::vector<Cert*> getDSCsExpiringBetween(uint64_t after, uint64_t until);
+    void beginUndoRecording();
+    std::vector<CertUndo> endUndoRecording();
+    bool restoreCert(CertUndo certUndo);
 };
 
 #endif //PASSPORTREADER_CERTSTORE_H
@@ -0,0 +1,32 @@
+
+#ifndef TX_CERTUNDO_H
+#define TX_CERTUNDO_H
+
+#include <cstdint>
+#include <vector>
+#include "../serialize.h"
+
+/**
+ * State of a CSCA or DSC certificate before a block modified it
+ */
+struct CertUndo {
+    uint8_t type; // TYPE_CSCA or TYPE_DSC
+    std::vector<unsigned char> certId;
+    bool wasPresent = false;
+    std::vector<std::pair<uint32_t, bool> > statusList;
+    uint32_t nonce = 0;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(type);
+        READWRITE(certId);
+        READWRITE(wasPresent);
+        READWRITE(statusList);
+        READWRITE(nonce);
+    }
+};
+
+
+#endif //TX_CERTUNDO_H
@@ -1,32 +1,122 @@
 
 #include "Chain.h"
 #include "BlockStore.h"
+#include "BlockUndo.h"
+#include "PathSum/PathSum.h"
+#include "Consensus/VoteStore.h"
+#include "AddressStore.h"
+#include "CertStore/CertStore.h"
 #include "Tools/Log.h"
 #include "FS/FS.h"
 #include "DB/DB.h"
 #include "TxPool.h"
 #include "Network/BanList.h"
 #include "Network/BlockCache.h"
+#include "Network/RawBlockCache.h"
 #include "App.h"
 #include "Network/Network.h"
+#include "Snapshot.h"
 
 std::mutex Chain::connectBlockMutex;
 
 void Chain::setBlockHashAndHeightMap(uint64_t position, std::vector<unsigned char> headerHash) {
     DB &db = DB::Instance();
     db.putInDB(DB_BLOCK_HEADERS, position, headerHash);
+
+    headerIndexMutex.lock();
+    auto found = this->headerIndex.find(uint256(headerHash));
+    if(found != this->headerIndex.end()) {
+        if(this->activeChain.size() <= position) {
+            this->activeChain.resize(position + 1, nullptr);
+        }
+        this->activeChain[position] = &found->second;
+    }
+    headerIndexMutex.unlock();
 }
 
 bool Chain::disconnectBlock(std::vector<unsigned char> blockHeaderHash) {
     TxPool& txPool = TxPool::Instance();
+    DB &db = DB::Instance();
+
+    // getBlock() returns an empty block when the body isn't stored, below a snapshot or in a pruned blockdat file
     Block* block = BlockStore::getBlock(blockHeaderHash);
+    bool hasBody = block->getHeader()->getHeaderHash() == blockHeaderHash;
+
+    BlockUndo blockUndo;
+    bool hasUndo = db.deserializeFromDb(DB_BLOCK_UNDO, blockHeaderHash, blockUndo);
+
+    BlockHeaderIndexEntry* header = this->getBlockHeader(blockHeaderHash);
+    if(header == nullptr || (!hasUndo && !hasBody)) {
+        Log(LOG_LEVEL_ERROR) << "Cannot disconnect block:" << blockHeaderHash << " because neither its undo record nor its body is stored";
+        delete block;
+        return false;
+    }
+    uint32_t height = header->getBlockHeight();
 
-    if(block == nullptr) {
-        Log(LOG_LEVEL_ERROR) << "Cannot disconnect block:" << blockHeaderHash << " because block was not found in block store";
+    // the best block headers are persisted with their votes, the index doesn't hold them
+    BlockHeader parentHeader;
+    if(header->previous != nullptr && !this->readBlockHeader(header->getPreviousHeaderHash(), parentHeader)) {
+        Log(LOG_LEVEL_ERROR) << "Cannot disconnect block:" << blockHeaderHash << " because its parent header can't be read";
+        delete block;
         return false;
     }
 
-    bool success = BlockHelper::undoBlock(block);
+    bool success;
+    uint32_t previousBestBlockHeight = this->bestBlockHeight;
+    std::vector<BlockHeader> previousBestBlocks = this->bestBlocks;
+
+    db.beginBlockTransaction();
+    if(hasUndo) {
+        // restore exactly the state the block found when it was connected
+        success = BlockUndoHelper::applyBlockUndo(&blockUndo);
+        db.removeFromDB(DB_BLOCK_UNDO, blockHeaderHash);
+    } else {
+        // block has been connected before undo records existed, recompute its effects in reverse
+        Log(LOG_LEVEL_INFO) << "No undo record for block:" << blockHeaderHash << " undoing it transaction by transaction";
+        success = BlockHelper::undoBlock(block);
+    }
+    AddressStore& addressStore = AddressStore::Instance();
+    success = addressStore.flushCache() && success;
+
+    // the parent becomes the best block, a restart must not resume from the disconnected one
+    this->bestBlockHeight = height - 1;
+    this->bestBlocks.clear();
+    if(header->previous != nullptr) {
+        this->bestBlocks.emplace_back(parentHeader);
+    }
+    success = this->persistBestBlockHeaders() && success;
+    success = db.removeFromDB(DB_BLOCK_HEADERS, (uint64_t)height) && success;
+
+    if(success) {
+        success = db.commitBlockTransaction();
+    } else {
+        db.abortBlockTransaction();
+    }
+
+    // the undo record restored addresses without going through the address cache
+    addressStore.clearCache();
+
+    if(!success) {
+        this->bestBlockHeight = previousBestBlockHeight;
+        this->bestBlocks = previousBestBlocks;
+
+        // certificates and PathSum have already been reverted in memory, only the committed state can be trusted
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to disconnect block:" << blockHeaderHash << ", terminating";
+        App& app = App::Instance();
+        app.terminate();
+        return false;
+    }
+
+    // the disconnected block is no longer part of the active chain
+    headerIndexMutex.lock();
+    if(this->activeChain.size() > height) {
+        this->activeChain.resize(height);
+    }
+    headerIndexMutex.unlock();
+
+    RawBlockCache& rawBlockCache = RawBlockCache::Instance();
+    rawBlockCache.invalidateFromHeight(height);
+
     // put transactions from Block back into TxPool
     txPool.appendTransactionsFromBlock(block);
     return success;
@@ -71,7 +161,7 @@ bool Chain::connectBlock(Block* block, bool isRecursion) {
                         << "transaction count:"
                         << (uint32_t)block->getTransactions().size();
 
-    BlockHeader* previousHeader = getBlockHeader(header->getPreviousHeaderHash());
+    BlockHeaderIndexEntry* previousHeader = getBlockHeader(header->getPreviousHeaderHash());
     if(previousHeader == nullptr) {
         if(header->getPreviousHeaderHash().empty()) {
             if(header->getBlockHeight() != 1) {
@@ -102,12 +192,21 @@ bool Chain::connectBlock(Block* block, bool isRecursion) {
         Log(LOG_LEVEL_INFO) << "Detected a fork, block: " << header->getHeaderHash() << " at height: " << header->getBlockHeight();
 
         //add block to chain
+        db.beginBlockTransaction();
         BlockStore::insertBlock(block);
         db.serializeToDb(DB_BLOCK_HEADERS, header->getHeaderHash(), *header);
+        if(!db.commitBlockTransaction()) {
+            BlockStore::discardUncommittedBlocks();
+            Log(LOG_LEVEL_ERROR) << "couldn't store fork block " << header->getHeaderHash();
+            connectBlockMutex.unlock();
+            return false;
+        }
+        this->indexBlockHeader(header);
 
         // If block has the same height as the other highest block
         if(this->bestBlockHeight == header->getBlockHeight()) {
             this->bestBlocks.emplace_back(*header);
+            this->persistBestBlockHeaders();
         }
 
         connectBlockMutex.unlock();
@@ -131,8 +230,8 @@ bool Chain::connectBlock(Block* block, bool isRecursion) {
                 toUndo.emplace_back(currentChainHeaderHash);
                 toDo.emplace_back(newChainHeaderHash);
 
-                BlockHeader* currentChainHeader = this->getBlockHeader(currentChainHeaderHash);
-                BlockHeader* newChainHeader = this->getBlockHeader(newChainHeaderHash);
+                BlockHeaderIndexEntry* currentChainHeader = this->getBlockHeader(currentChainHeaderHash);
+                BlockHeaderIndexEntry* newChainHeader = this->getBlockHeader(newChainHeaderHash);
                 if(currentChainHeader == nullptr || newChainHeader == nullptr) {
                     Log(LOG_LEVEL_ERROR) << "Something went wrong, reverting fork";
                     forkFailed = true;
@@ -183,14 +282,13 @@ bool Chain::connectBlock(Block* block, bool isRecursion) {
             // disconnect all blocks until last common block
             for (std::vector<std::vector<unsigned char>>::iterator it = toUndo.begin(); it != toUndo.end(); it++) {
                 Log(LOG_LEVEL_INFO) << "Disconnecting: " << *it;
-                this->disconnectBlock(*it);
+                if(!this->disconnectBlock(*it)) {
+                    connectBlockMutex.unlock();
+                    return false;
+                }
             }
 
-            std::vector<BlockHeader> newBestBlockHeader;
-            BlockHeader commonBlock = *this->getBlockHeader(commonHeaderHash);
-            newBestBlockHeader.emplace_back(commonBlock);
-            this->setBestBlockHeaders(newBestBlockHeader);
-            this->bestBlockHeight = commonBlock.getBlockHeight();
+            // disconnectBlock() already made the common block the best block
 
             Log(LOG_LEVEL_INFO) << "Blocks are now disconnected";
             Log(LOG_LEVEL_INFO) << "Will apply " << (uint64_t)toDo.size() << " new blocks";
@@ -208,11 +306,11 @@ bool Chain::connectBlock(Block* block, bool isRecursion) {
                     if(this->connectBlock(blockFromStore, true)) {
                         appliedTodos.emplace_back(*it);
                     } else {
-                        banList.appendBan(blockCache.getIpForBlock(*it), BAN_INC_INSTA_BAN);
+                        banList.appendBan(blockCache.getIpForBlock(hash_t(*it)), BAN_INC_INSTA_BAN);
                         forkFailed = true;
                     }
                 } else {
-                    banList.appendBan(blockCache.getIpForBlock(*it), BAN_INC_INSTA_BAN);
+                    banList.appendBan(blockCache.getIpForBlock(hash_t(*it)), BAN_INC_INSTA_BAN);
                     forkFailed = true;
                 }
             }
@@ -227,7 +325,10 @@ bool Chain::connectBlock(Block* block, bool isRecursion) {
                 // rollback all applied todos
                 for (std::vector<std::vector<unsigned char>>::iterator it = appliedTodos.begin(); it != appliedTodos.end(); it++) {
                     Log(LOG_LEVEL_INFO) << "Rollback: " << *it;
-                    this->disconnectBlock(*it);
+                    if(!this->disconnectBlock(*it)) {
+                        connectBlockMutex.unlock();
+                        return false;
+                    }
                 }
 
                 // reapply all untodos
@@ -255,23 +356,67 @@ bool Chain::connectBlock(Block* block, bool isRecursion) {
         return false;
     }
 
+    // all state changes of this block are buffered and written at once, a crash never leaves a half applied block
+    uint32_t previousBestBlockHeight = this->bestBlockHeight;
+    std::vector<BlockHeader> previousBestBlocks = this->bestBlocks;
+    PathSum& pathSum = PathSum::Instance();
+    uint64_t previousPathSumHeight = pathSum.getStackHeight();
+
+    db.beginBlockTransaction();
+    CertStore& certStore = CertStore::Instance();
+    certStore.beginUndoRecording();
+
     //add block to chain
     BlockStore::insertBlock(block);
     db.serializeToDb(DB_BLOCK_HEADERS, header->getHeaderHash(), *header);
 
     // Apply blocks
-    BlockHelper::applyBlock(block);
+    bool success = BlockHelper::applyBlock(block);
+    AddressStore& addressStore = AddressStore::Instance();
+    success = addressStore.flushCache() && success;
+
+    if(!success) {
+        // nothing of the block has been written, the in memory state is put back to where it was
+        db.abortBlockTransaction();
+        BlockStore::discardUncommittedBlocks();
+        addressStore.clearCache();
+        for(CertUndo certUndo : certStore.endUndoRecording()) {
+            certStore.restoreCert(certUndo);
+        }
+        pathSum.popValue(pathSum.getStackHeight() - previousPathSumHeight);
+        VoteStore& voteStore = VoteStore::Instance();
+        voteStore.reloadDelegates();
+
+        Log(LOG_LEVEL_ERROR) << "couldn't connect block " << header->getHeaderHash() << " to chain, applying it failed";
+        connectBlockMutex.unlock();
+        return false;
+    }
 
     //update best blocks
     this->bestBlockHeight = header->getBlockHeight();
     this->bestBlocks.clear();
     this->bestBlocks.emplace_back(*header);
     db.putInDB(DB_BLOCK_HEADERS, header->getBlockHeight(), header->getHeaderHash());
-
-    FS::clearFile(FS::getBestBlockHeadersPath());
-    for(BlockHeader bestHeader: this->bestBlocks) {
-        FS::serializeToFile(FS::getBestBlockHeadersPath(), bestHeader);
+    this->persistBestBlockHeaders();
+
+    BlockUndo blockUndo = BlockUndoHelper::createBlockUndo();
+    db.serializeToDb(DB_BLOCK_UNDO, header->getHeaderHash(), blockUndo);
+    BlockStore::pruneBlockDatFiles(header->getBlockHeight());
+
+    if(!db.commitBlockTransaction()) {
+        // the stores might be partially written, the journal completes them at the next start
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to persist state of block " << header->getHeaderHash() << ", terminating";
+        this->bestBlockHeight = previousBestBlockHeight;
+        this->bestBlocks = previousBestBlocks;
+        App& app = App::Instance();
+        app.terminate();
+        connectBlockMutex.unlock();
+        return false;
     }
+    // only a committed header enters the index, entries are never removed again
+    this->setActiveChainTip(this->indexBlockHeader(header));
+    BlockStore::deleteUnlinkedBlockDatFiles();
+    SnapshotHelper::onBlockConnected(header->getBlockHeight());
 
     Log(LOG_LEVEL_INFO) << "added block with hash "
                         << header->getHeaderHash()
@@ -288,7 +433,7 @@ bool Chain::connectBlock(Block* block, bool isRecursion) {
 }
 
 uint32_t Chain::getBlockHeight(std::vector<unsigned char> blockHeaderHash) {
-    BlockHeader* blockHeader = this->getBlockHeader(blockHeaderHash);
+    BlockHeaderIndexEntry* blockHeader = this->getBlockHeader(blockHeaderHash);
 
     if(blockHeader != nullptr) {
         return blockHeader->getBlockHeight();
@@ -297,46 +442,76 @@ uint32_t Chain::getBlockHeight(std::vector<unsigned char> blockHeaderHash) {
     return 0;
 }
 
-BlockHeader* Chain::getBlockHeader(std::vector<unsigned char> blockHeaderHash) {
+BlockHeaderIndexEntry* Chain::getBlockHeader(const std::vector<unsigned char>& blockHeaderHash) {
 
-    if(blockHeaderHash.empty()) {
+    // hashes sent by other nodes can have any length
+    uint256 headerHash;
+    if(!headerHash.setFromVector(blockHeaderHash)) {
         return nullptr;
     }
 
-    DB &db = DB::Instance();
-    BlockHeader* blockHeader = new BlockHeader();
+    return this->getBlockHeader(headerHash);
+}
+
+BlockHeaderIndexEntry* Chain::getBlockHeader(const uint256& blockHeaderHash) {
+
+    BlockHeaderIndexEntry* blockHeader = nullptr;
 
-    if(db.deserializeFromDb(DB_BLOCK_HEADERS, blockHeaderHash, *blockHeader)) {
-        return blockHeader;
+    headerIndexMutex.lock();
+    auto found = this->headerIndex.find(blockHeaderHash);
+    if(found != this->headerIndex.end()) {
+        blockHeader = &found->second;
     }
+    headerIndexMutex.unlock();
 
-    return nullptr;
+    return blockHeader;
 }
 
-BlockHeader* Chain::getBlockHeader(uint64_t height) {
-    DB &db = DB::Instance();
+BlockHeaderIndexEntry* Chain::getBlockHeader(uint64_t height) {
 
-    std::vector<unsigned char> blockHeaderHash = db.getFromDB(DB_BLOCK_HEADERS, height);
+    BlockHeaderIndexEntry* blockHeader = nullptr;
 
-    if(!blockHeaderHash.empty()) {
-        return this->getBlockHeader(blockHeaderHash);
+    headerIndexMutex.lock();
+    if(height < this->activeChain.size()) {
+        blockHeader = this->activeChain[height];
     }
+    headerIndexMutex.unlock();
 
-    return nullptr;
+    return blockHeader;
 }
 
-bool Chain::doesBlockExist(uint64_t height) {
+/**
+ * Deserializes the full header including its votes from DB_BLOCK_HEADERS, only for indexed headers
+ */
+bool Chain::readBlockHeader(const std::vector<unsigned char>& blockHeaderHash, BlockHeader& blockHeader) {
+    if(!this->doesBlockExist(blockHeaderHash)) {
+        return false;
+    }
+
     DB &db = DB::Instance();
+    return db.deserializeFromDb(DB_BLOCK_HEADERS, blockHeaderHash, blockHeader);
+}
 
-    std::vector<unsigned char> blockHeaderHash = db.getFromDB(DB_BLOCK_HEADERS, height);
+bool Chain::readBlockHeader(uint64_t height, BlockHeader& blockHeader) {
+    BlockHeaderIndexEntry* entry = this->getBlockHeader(height);
+    if(entry == nullptr) {
+        return false;
+    }
 
-    return !blockHeaderHash.empty();
+    DB &db = DB::Instance();
+    return db.deserializeFromDb(DB_BLOCK_HEADERS, entry->getHeaderHash(), blockHeader);
 }
 
-bool Chain::doesBlockExist(std::vector<unsigned char> blockHeaderHash) {
-    DB &db = DB::Instance();
-    
-    return db.isInDB(DB_BLOCK_HEADERS, blockHeaderHash);
+bool Chain::doesBlockExist(uint64_t height) {
+    return this->getBlockHeader(height) != nullptr;
+}
+
+bool Chain::doesBlockExist(const std::vector<unsigned char>& blockHeaderHash) {
+    return this->getBlockHeader(blockHeaderHash) != nullptr;
+}
+
+bool Chain::doesBlockExist(const uint256& blockHeaderHash) {
+    return this->getBlockHeader(blockHeaderHash) != nullptr;
 }
 
 uint32_t Chain::getCurrentBlockchainHeight() {
@@ -355,6 +530,16 @@ std::vector<BlockHeader> Chain::getBestBlockHeaders() {
     return this->bestBlocks;
 }
 
+/**
+ * Replaces the stored best block headers with a single DB write, inside a block transaction it is part of its batch
+ */
+bool Chain::persistBestBlockHeaders() {
+    DB &db = DB::Instance();
+    std::string bestBlockHeadersKey = BEST_BLOCK_HEADERS_KEY;
+
+    return db.serializeToDb(DB_BLOCK_HEADERS, std::vector<unsigned char>(bestBlockHeadersKey.begin(), bestBlockHeadersKey.end()), this->bestBlocks);
+}
+
 BlockHeader* Chain::getBestBlockHeader() {
     if(this->bestBlocks.size() == 0) {
         return nullptr;
@@ -365,4 +550,111 @@ BlockHeader* Chain::getBestBlockHeader() {
 void Chain::insertBlockHeader(BlockHeader blockHeader) {
     DB &db = DB::Instance();
     db.serializeToDb(DB_BLOCK_HEADERS, blockHeader.getHeaderHash(), blockHeader);
+    this->indexBlockHeader(&blockHeader);
+}
+
+BlockHeaderIndexEntry* Chain::indexBlockHeader(BlockHeader* blockHeader) {
+    headerIndexMutex.lock();
+
+    auto inserted = this->headerIndex.emplace(uint256(blockHeader->getHeaderHash()), BlockHeaderIndexEntry());
+    BlockHeaderIndexEntry* entry = &inserted.first->second;
+
+    // existing entries are already handed out, never rewrite them
+    if(inserted.second) {
+        Chain::fillIndexEntry(entry, blockHeader);
+
+        // the genesis block has no previous header hash
+        uint256 previousHeaderHash;
+        auto previous = this->headerIndex.end();
+        if(previousHeaderHash.setFromVector(blockHeader->getPreviousHeaderHash())) {
+            previous = this->headerIndex.find(previousHeaderHash);
+        }
+        if(previous != this->headerIndex.end()) {
+            entry->previous = &previous->second;
+        }
+    }
+
+    headerIndexMutex.unlock();
+
+    return entry;
+}
+
+void Chain::fillIndexEntry(BlockHeaderIndexEntry* entry, BlockHeader* blockHeader) {
+    entry->headerHash = uint256(blockHeader->getHeaderHash());
+    entry->blockHeight = blockHeader->getBlockHeight();
+    entry->timestamp = blockHeader->getTimestamp();
+    entry->issuerPubKey = blockHeader->getIssuerPubKey();
+    entry->payout = blockHeader->getPayout();
+    entry->payoutRemainder = blockHeader->getPayoutRemainder();
+    entry->ubiReceiverCount = blockHeader->getUbiReceiverCount();
+}
+
+void Chain::setActiveChainTip(BlockHeaderIndexEntry* entry) {
+    headerIndexMutex.lock();
+
+    uint32_t height = entry->blockHeight;
+    this->activeChain.resize(height + 1, nullptr);
+    this->activeChain[height] = entry;
+
+    headerIndexMutex.unlock();
+}
+
+/**
+ * Reads all headers once from DB_BLOCK_HEADERS, afterwards header lookups are served from memory
+ * and the DB is only read for the votes and signatures, see readBlockHeader().
+ * Has to be called after the best block headers have been loaded.
+ */
+uint64_t Chain::loadHeaderIndex() {
+    DB &db = DB::Instance();
+
+    headerIndexMutex.lock();
+
+    this->headerIndex.clear();
+    this->activeChain.clear();
+
+    std::vector<std::pair<BlockHeaderIndexEntry*, uint256> > previousHeaderHashes;
+    DBIterator* it = db.newIterator(DB_BLOCK_HEADERS);
+    for(; it->valid(); it->next()) {
+        // DB_BLOCK_HEADERS also maps integer keys of heights to header hashes, only 32 bytes keys are header hashes
+        leveldb::Slice key = it->key();
+        if(key.size() != uint256::size()) {
+            continue;
+        }
+
+        BlockHeader header;
+        if(it->deserializeValue(header)) {
+            auto inserted = this->headerIndex.emplace(uint256((const unsigned char*)key.data()), BlockHeaderIndexEntry());
+            Chain::fillIndexEntry(&inserted.first->second, &header);
+
+            // previous pointers are linked once all entries exist
+            uint256 previousHeaderHash;
+            if(previousHeaderHash.setFromVector(header.getPreviousHeaderHash())) {
+                previousHeaderHashes.emplace_back(&inserted.first->second, previousHeaderHash);
+            }
+        }
+    }
+    delete it;
+
+    for(auto &link : previousHeaderHashes) {
+        auto previous = this->headerIndex.find(link.second);
+        if(previous != this->headerIndex.end()) {
+            link.first->previous = &previous->second;
+        }
+    }
+
+    if(!this->bestBlocks.empty()) {
+        auto best = this->headerIndex.find(uint256(this->bestBlocks[0].getHeaderHash()));
+        if(best != this->headerIndex.end()) {
+            this->activeChain.resize(best->second.blockHeight + 1, nullptr);
+            for(BlockHeaderIndexEntry* entry = &best->second; entry != nullptr; entry = entry->previous) {
+                this->activeChain[entry->blockHeight] = entry;
+            }
+        }
+    }
+
+    uint64_t headerCount = this->headerIndex.size();
+
+    headerIndexMutex.unlock();
+
+    return headerCount;
 }
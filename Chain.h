@@ -6,11 +6,72 @@
 #include <mutex>
 #include <unordered_map>
 #include "Block.h"
+#include "uint256.h"
+
+// DB_BLOCK_HEADERS key of the best block headers, written in the same batch as the header of a new best block
+#define BEST_BLOCK_HEADERS_KEY "bestBlockHeaders"
+
+/**
+ * Resident entry of the header index, entries are never removed so pointers to them stay valid
+ * Only the fields chain validation reads are kept, votes and signatures stay in DB_BLOCK_HEADERS, see Chain::readBlockHeader()
+ */
+struct BlockHeaderIndexEntry {
+    uint256 headerHash;
+    BlockHeaderIndexEntry* previous = nullptr;
+    uint32_t blockHeight = 0;
+    uint32_t timestamp = 0;
+    std::vector<unsigned char> issuerPubKey;
+    UAmount payout;
+    UAmount payoutRemainder;
+    UAmount32 ubiReceiverCount;
+
+    std::vector<unsigned char> getHeaderHash() const {
+        return headerHash.toVector();
+    }
+
+    // empty for the genesis block
+    std::vector<unsigned char> getPreviousHeaderHash() const {
+        if(previous == nullptr) {
+            return std::vector<unsigned char>();
+        }
+        return previous->headerHash.toVector();
+    }
+
+    uint32_t getBlockHeight() const {
+        return blockHeight;
+    }
+
+    uint32_t getTimestamp() const {
+        return timestamp;
+    }
+
+    const std::vector<unsigned char>& getIssuerPubKey() const {
+        return issuerPubKey;
+    }
+
+    const UAmount& getPayout() const {
+        return payout;
+    }
+
+    const UAmount& getPayoutRemainder() const {
+        return payoutRemainder;
+    }
+
+    const UAmount32& getUbiReceiverCount() const {
+        return ubiReceiverCount;
+    }
+};
 
 class Chain {
 private:
     uint32_t bestBlockHeight = 0;
     std::vector<BlockHeader> bestBlocks; // Blocks that are on the top of the chain
+    std::mutex headerIndexMutex;
+    std::unordered_map<uint256, BlockHeaderIndexEntry, BlobHasher> headerIndex; // All known headers including forks
+    std::vector<BlockHeaderIndexEntry*> activeChain; // activeChain[height], position 0 is unused
+    BlockHeaderIndexEntry* indexBlockHeader(BlockHeader* blockHeader);
+    static void fillIndexEntry(BlockHeaderIndexEntry* entry, BlockHeader* blockHeader);
+    void setActiveChainTip(BlockHeaderIndexEntry* entry);
 public:
     static std::mutex connectBlockMutex;
     static Chain& Instance(){
@@ -22,16 +83,22 @@ public:
     bool connectBlock(Block* block);
     bool connectBlock(Block* block, bool isRecursion);
     uint32_t getBlockHeight(std::vector<unsigned char> blockHeaderHash);
-    BlockHeader* getBlockHeader(std::vector<unsigned char> blockHeaderHash);
-    BlockHeader* getBlockHeader(uint64_t height);
+    BlockHeaderIndexEntry* getBlockHeader(const std::vector<unsigned char>& blockHeaderHash);
+    BlockHeaderIndexEntry* getBlockHeader(const uint256& blockHeaderHash);
+    BlockHeaderIndexEntry* getBlockHeader(uint64_t height);
+    bool readBlockHeader(const std::vector<unsigned char>& blockHeaderHash, BlockHeader& blockHeader);
+    bool readBlockHeader(uint64_t height, BlockHeader& blockHeader);
     bool doesBlockExist(uint64_t height);
-    bool doesBlockExist(std::vector<unsigned char> blockHeaderHash);
+    bool doesBlockExist(const std::vector<unsigned char>& blockHeaderHash);
+    bool doesBlockExist(const uint256& blockHeaderHash);
     uint32_t getCurrentBlockchainHeight();
     void setCurrentBlockchainHeight(uint32_t bestHeight);
     void setBestBlockHeaders(std::vector<BlockHeader> bestBlocks);
     std::vector<BlockHeader> getBestBlockHeaders();
+    bool persistBestBlockHeaders();
     BlockHeader* getBestBlockHeader();
     void insertBlockHeader(BlockHeader blockHeader);
+    uint64_t loadHeaderIndex();
 };
 
 
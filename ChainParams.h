@@ -36,6 +36,35 @@
 #define CURRENCY_MONACO 24
 #define CURRENCY_LIECHTENSTEIN 25
 
+/* every currency needs an entry here and an _EMISSION_RATE, _DELEGATE_PAYOUT and _DEVELOPMENT_PAYOUT below */
+#define CURRENCY_COUNT 25
+#define FOR_EACH_CURRENCY(CURRENCY) \
+        CURRENCY(SWITZERLAND) \
+        CURRENCY(GERMANY) \
+        CURRENCY(AUSTRIA) \
+        CURRENCY(UNITED_KINGDOM) \
+        CURRENCY(IRELAND) \
+        CURRENCY(USA) \
+        CURRENCY(AUSTRALIA) \
+        CURRENCY(CHINA) \
+        CURRENCY(SWEDEN) \
+        CURRENCY(FRANCE) \
+        CURRENCY(CANADA) \
+        CURRENCY(JAPAN) \
+        CURRENCY(THAILAND) \
+        CURRENCY(NEW_ZEALAND) \
+        CURRENCY(UNITED_ARAB_EMIRATES) \
+        CURRENCY(FINLAND) \
+        CURRENCY(LUXEMBOURG) \
+        CURRENCY(SINGAPORE) \
+        CURRENCY(HUNGARY) \
+        CURRENCY(CZECH_REPUBLIC) \
+        CURRENCY(MALAYSIA) \
+        CURRENCY(UKRAINE) \
+        CURRENCY(ESTONIA) \
+        CURRENCY(MONACO) \
+        CURRENCY(LIECHTENSTEIN)
+
 #define CURRENCY_SWITZERLAND_EMISSION_RATE 19400000
 #define CURRENCY_GERMANY_EMISSION_RATE 191400000
 #define CURRENCY_AUSTRIA_EMISSION_RATE 20200000
@@ -134,6 +163,8 @@
 #define NET_TEST 0x02
 #define NET_CURRENT 0x01
 
+#define ADDRESS_CACHE_SIZE 100000 /* in addresses, modified ones are kept until the end of the block */
+
 #define DB_ADDRESS_STORE 0
 #define DB_BLOCK_INDEX 1
 #define DB_NTPSK_ALREADY_USED 2
@@ -141,8 +172,20 @@
 #define DB_BLOCK_HEADERS 4
 #define DB_MY_TRANSACTIONS 5
 #define DB_VOTES 6
+#define DB_BLOCK_UNDO 7
+#define DB_PATH_SUM 8
+#define DB_STORE_COUNT 9
+
+#define DB_SINGLE_DATABASE true /* all stores in one LevelDB, their keys are prefixed with the store id, blocks are committed with one atomic batch, switching migrates the data */
+#define DB_BLOCK_CACHE_SIZE_MB 64 /* one LRU cache shared by all stores */
+#define DB_MAX_SIZE_MB 16384 /* upper bound of the configurable cache and write buffer sizes */
 
 #define BLOCK_FILES_MAX_SIZE (1800 * 1000 * 1000) /* in bytes */
+#define BLOCK_FILES_PREALLOCATION_CHUNK_SIZE (16 * 1000 * 1000) /* in bytes */
+#define BLOCK_FILES_PREALLOCATE true
+#define BLOCK_FILES_SYNC_INTERVAL 1 /* in blocks, 1 syncs each block before it is indexed, 0 leaves syncing to the OS */
+#define PRUNE_DEPTH 0 /* in blocks, 0 keeps all blockdat files */
+#define PRUNE_MIN_DEPTH 2000 /* in blocks, pruned blocks can't be disconnected anymore */
 
 #define SERIALIZATION_VERSION 1
 #define BLOCK_SIZE_MAX 1900000
@@ -157,6 +200,10 @@
 #define CSCA_MATURATION_SUSPENSIONTIME_IN_BLOCKS 100 /* during the first 100 blocks maturation is ignored */
 #define TXFEE_FACTOR 1
 
+/* ancestors of this block skip signature and NtpRsk/NtpEsk proof verification during sync, an empty hash disables it */
+#define ASSUME_VALID_BLOCK_HASH ""
+#define ASSUME_VALID_BLOCK_HEIGHT 0
+
 #define VOTES_INTERVAL 0
 #define MAXIMUM_DELEGATE_COUNT 51
 #define MINIMUM_DELEGATE_VOTES 7
@@ -1,8 +1,76 @@
 
+#include <algorithm>
+#include <cstdint>
 #include <boost/property_tree/ini_parser.hpp>
 #include "Config.h"
 #include "FS/FS.h"
 #include "App.h"
+#include "ChainParams.h"
+#include "Tools/Hexdump.h"
+
+#define MEBIBYTE ((size_t)1024 * 1024)
+
+/**
+ * Defaults follow the access pattern of each store:
+ * stores hit by point lookups for mostly missing keys (new addresses, unused NTPSK proofs) get bloom filters,
+ * stores that are only iterated or read on disconnect get small write buffers and no filter
+ * The block cache is shared by all stores, so it goes to the blocks that are actually read
+ */
+static const struct {
+    uint8_t store;
+    const char* section;
+    DBStoreOptions defaults;
+} dbStoreDefaults[] = {
+        {DB_ADDRESS_STORE, "AddressStore", {10, 8 * MEBIBYTE, 256, true}},
+        {DB_BLOCK_INDEX, "BlockIndexStore", {10, 4 * MEBIBYTE, 64, true}},
+        {DB_NTPSK_ALREADY_USED, "NTPSKStore", {14, 4 * MEBIBYTE, 128, false}}, // keys and values are hashes, they don't compress
+        {DB_DSC_ATTACHED_PASSPORTS_COUNTER, "DSCCounterStore", {10, 2 * MEBIBYTE, 64, true}},
+        {DB_BLOCK_HEADERS, "BlockHeadersStore", {10, 8 * MEBIBYTE, 128, true}},
+        {DB_MY_TRANSACTIONS, "MyTransactionsStore", {0, 2 * MEBIBYTE, 32, true}},
+        {DB_VOTES, "VotesStore", {0, 1 * MEBIBYTE, 32, true}},
+        {DB_BLOCK_UNDO, "BlockUndoStore", {0, 8 * MEBIBYTE, 64, true}},
+        {DB_PATH_SUM, "PathSumStore", {0, 2 * MEBIBYTE, 32, true}}, // only read in one sweep at start
+};
+
+static const DBStoreOptions singleDatabaseDefaults = {12, 32 * MEBIBYTE, 512, true};
+
+/**
+ * Reads an optional number, values above maximum are capped
+ */
+static uint64_t readUnsigned(boost::property_tree::ptree& pt, std::string key, uint64_t defaultValue, uint64_t maximum) {
+    uint64_t value = std::stoull(pt.get<std::string>(key, std::to_string(defaultValue)));
+    if(value > maximum) {
+        Log(LOG_LEVEL_WARNING) << key << " " << value << " is too high, using " << maximum;
+        value = maximum;
+    }
+
+    return value;
+}
+
+/**
+ * Reads an optional size given in MB, capped so it fits into a size_t in bytes
+ */
+static size_t readMebibytes(boost::property_tree::ptree& pt, std::string key, size_t defaultValue) {
+    uint64_t maximum = std::min((uint64_t)DB_MAX_SIZE_MB, (uint64_t)(SIZE_MAX / MEBIBYTE));
+
+    return MEBIBYTE * (size_t)readUnsigned(pt, key, defaultValue / MEBIBYTE, maximum);
+}
+
+/**
+ * Reads the optional [section] of config.ini, for example:
+ * [AddressStore]
+ * writeBufferSizeMB = 64
+ * bloomFilterBits = 10
+ */
+static DBStoreOptions readDBStoreOptions(boost::property_tree::ptree& pt, std::string section, DBStoreOptions defaults) {
+    DBStoreOptions options;
+    options.bloomFilterBits = (uint32_t)readUnsigned(pt, section + ".bloomFilterBits", defaults.bloomFilterBits, 64);
+    options.writeBufferSize = readMebibytes(pt, section + ".writeBufferSizeMB", defaults.writeBufferSize);
+    options.maxOpenFiles = (uint32_t)readUnsigned(pt, section + ".maxOpenFiles", defaults.maxOpenFiles, INT32_MAX);
+    options.compression = pt.get<bool>(section + ".compression", defaults.compression);
+
+    return options;
+}
 
 bool Config::loadConfig() {
     char path[512];
@@ -31,6 +99,32 @@ bool Config::loadConfig() {
             this->logLevel = LOG_LEVEL_CRITICAL_ERROR;
         }
 
+        // optional, defaults to the assume-valid block of ChainParams.h
+        this->assumeValidBlockHash = pt.get<std::string>("assumeValidBlockHash", ASSUME_VALID_BLOCK_HASH);
+        this->assumeValidBlockHeight = (uint32_t)std::stoul(pt.get<std::string>("assumeValidBlockHeight", std::to_string(ASSUME_VALID_BLOCK_HEIGHT)));
+
+        // optional, blockdat files are grown in chunks and synced every blockDatSyncInterval blocks
+        // intervals above 1 or 0 can leave indexed blocks missing from the blockdat files after a power loss
+        this->preallocateBlockDatFiles = pt.get<bool>("preallocateBlockDatFiles", BLOCK_FILES_PREALLOCATE);
+        this->blockDatSyncInterval = (uint32_t)std::stoul(pt.get<std::string>("blockDatSyncInterval", std::to_string(BLOCK_FILES_SYNC_INTERVAL)));
+
+        // optional, blockdat files whose blocks are buried deeper than prune blocks are deleted
+        this->pruneDepth = (uint32_t)std::stoul(pt.get<std::string>("prune", std::to_string(PRUNE_DEPTH)));
+        if(this->pruneDepth > 0 && this->pruneDepth < PRUNE_MIN_DEPTH) {
+            Log(LOG_LEVEL_WARNING) << "prune depth " << this->pruneDepth << " is too low, using " << PRUNE_MIN_DEPTH;
+            this->pruneDepth = PRUNE_MIN_DEPTH;
+        }
+
+        // optional, moves all stores into one LevelDB, existing stores are migrated on start
+        this->singleDatabase = pt.get<bool>("singleDatabase", DB_SINGLE_DATABASE);
+
+        // optional, LevelDB tuning per store, the single database is tuned in the [Database] section
+        for(auto& dbStoreDefault : dbStoreDefaults) {
+            this->dbStoreOptions[dbStoreDefault.store] = readDBStoreOptions(pt, dbStoreDefault.section, dbStoreDefault.defaults);
+        }
+        this->singleDatabaseOptions = readDBStoreOptions(pt, "Database", singleDatabaseDefaults);
+        // both layouts use one block cache, a cache per store would multiply the memory used
+        this->dbCacheSize = readMebibytes(pt, "Database.cacheSizeMB", DB_BLOCK_CACHE_SIZE_MB * MEBIBYTE);
 
     } catch (const std::exception& e) {
         Log(LOG_LEVEL_ERROR) << "Config::loadConfig() exception:" << e.what();
@@ -64,4 +158,56 @@ std::string Config::getDonationAddress() {
 
 std::string Config::getApiKey() {
     return this->apiKey;
+}
+
+std::vector<unsigned char> Config::getAssumeValidBlockHash() {
+    return Hexdump::hexStringToVector(this->assumeValidBlockHash);
+}
+
+uint32_t Config::getAssumeValidBlockHeight() {
+    return this->assumeValidBlockHeight;
+}
+
+bool Config::getPreallocateBlockDatFiles() {
+    return this->preallocateBlockDatFiles;
+}
+
+uint32_t Config::getBlockDatSyncInterval() {
+    return this->blockDatSyncInterval;
+}
+
+uint32_t Config::getPruneDepth() {
+    return this->pruneDepth;
+}
+
+bool Config::getSingleDatabase() {
+    return this->singleDatabase;
+}
+
+DBStoreOptions Config::getDBStoreOptions(uint8_t store) {
+    auto found = this->dbStoreOptions.find(store);
+    if(found == this->dbStoreOptions.end()) {
+        return singleDatabaseDefaults;
+    }
+    return found->second;
+}
+
+DBStoreOptions Config::getSingleDatabaseOptions() {
+    return this->singleDatabaseOptions;
+}
+
+size_t Config::getDBCacheSize() {
+    return this->dbCacheSize;
+}
+
+/**
+ * Name of the config.ini section of a store
+ */
+std::string Config::getDBStoreName(uint8_t store) {
+    for(auto& dbStoreDefault : dbStoreDefaults) {
+        if(dbStoreDefault.store == store) {
+            return dbStoreDefault.section;
+        }
+    }
+    return std::to_string(store);
 }
\ No newline at end of file
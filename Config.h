@@ -3,7 +3,20 @@
 #define TX_CONFIG_H
 
 
+#include <map>
 #include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * LevelDB tuning of a store, sizes are in bytes
+ */
+struct DBStoreOptions {
+    uint32_t bloomFilterBits; // bits per key, 0 disables the bloom filter
+    size_t writeBufferSize;
+    uint32_t maxOpenFiles;
+    bool compression;
+};
 
 class Config {
 private:
@@ -13,6 +26,15 @@ private:
     std::string apiKey;
     uint32_t numberOfAdresses;
     uint8_t logLevel;
+    std::string assumeValidBlockHash;
+    uint32_t assumeValidBlockHeight;
+    bool preallocateBlockDatFiles;
+    uint32_t blockDatSyncInterval;
+    uint32_t pruneDepth;
+    bool singleDatabase;
+    std::map<uint8_t, DBStoreOptions> dbStoreOptions;
+    DBStoreOptions singleDatabaseOptions;
+    size_t dbCacheSize;
 public:
     static Config& Instance(){
         static Config instance;
@@ -27,6 +49,16 @@ public:
     uint8_t getLogLevel();
     std::string getDonationAddress();
     std::string getApiKey();
+    std::vector<unsigned char> getAssumeValidBlockHash();
+    uint32_t getAssumeValidBlockHeight();
+    bool getPreallocateBlockDatFiles();
+    uint32_t getBlockDatSyncInterval();
+    uint32_t getPruneDepth();
+    bool getSingleDatabase();
+    DBStoreOptions getDBStoreOptions(uint8_t store);
+    DBStoreOptions getSingleDatabaseOptions();
+    size_t getDBCacheSize();
+    static std::string getDBStoreName(uint8_t store);
 };
 
 
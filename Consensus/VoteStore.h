@@ -56,15 +56,22 @@ public:
         return this->allDelegates;
     }
 
+    bool isKnownDelegate(std::vector<unsigned char> publicKey) {
+        return this->allDelegates.find(publicKey) != this->allDelegates.end();
+    }
+
     bool loadDelegates() {
         DB& db = DB::Instance();
-        for(std::vector<unsigned char> key : db.getAllKeys(DB_VOTES)) {
-            Delegate* delegate = new Delegate();
-            if(!db.deserializeFromDb(DB_VOTES, key, *delegate)) {
+        DBIterator* it = db.newIterator(DB_VOTES);
+        for(; it->valid(); it->next()) {
+            Delegate delegate;
+            if(!it->deserializeValue(delegate)) {
+                delete it;
                 return false;
             }
-            this->allDelegates.insert(std::make_pair(delegate->getPublicKey(), *delegate));
+            this->allDelegates.insert(std::make_pair(delegate.getPublicKey(), delegate));
         }
+        delete it;
 
         Log(LOG_LEVEL_INFO) << "this->allDelegates.size(): " << (uint64_t)this->allDelegates.size();
 
@@ -107,6 +114,12 @@ public:
         return true;
     }
 
+    bool reloadDelegates() {
+        this->allDelegates.clear();
+        this->activeDelegates.clear();
+        return loadDelegates();
+    }
+
     bool verifyVote(Vote* vote) {
         Chain& chain = Chain::Instance();
         auto fromDelegate = this->activeDelegates.find(vote->getFromPubKey());
@@ -3,11 +3,75 @@
 #include "../ChainParams.h"
 #include "../Tools/Log.h"
 #include "../FS/FS.h"
+#include "../Config.h"
+
+static const uint8_t allStores[] = {
+        DB_ADDRESS_STORE,
+        DB_BLOCK_INDEX,
+        DB_NTPSK_ALREADY_USED,
+        DB_DSC_ATTACHED_PASSPORTS_COUNTER,
+        DB_BLOCK_HEADERS,
+        DB_MY_TRANSACTIONS,
+        DB_VOTES,
+        DB_BLOCK_UNDO,
+        DB_PATH_SUM
+};
+
+static std::vector<unsigned char> getStorePath(uint8_t store) {
+    switch (store) {
+        case DB_ADDRESS_STORE:
+            return FS::getAddressStorePath();
+        case DB_BLOCK_INDEX:
+            return FS::getBlockIndexStorePath();
+        case DB_NTPSK_ALREADY_USED:
+            return FS::getNTPSKStorePath();
+        case DB_DSC_ATTACHED_PASSPORTS_COUNTER:
+            return FS::getDSCCounterStorePath();
+        case DB_BLOCK_HEADERS:
+            return FS::getBlockHeadersPath();
+        case DB_MY_TRANSACTIONS:
+            return FS::getMyTransactionsPath();
+        case DB_VOTES:
+            return FS::getVotesPath();
+        case DB_BLOCK_UNDO:
+            return FS::getBlockUndoStorePath();
+        case DB_PATH_SUM:
+            return FS::getPathSumStorePath();
+        default:
+            return std::vector<unsigned char>();
+    }
+}
 
 DB::DB() {
+    Config& config = Config::Instance();
 
-    leveldb::Options options;
-    options.create_if_missing = true;
+    if(config.getDBCacheSize() > 0) {
+        this->blockCache = leveldb::NewLRUCache(config.getDBCacheSize());
+    }
+
+    if(config.getSingleDatabase()) {
+        this->singleDatabase = true;
+
+        char pDatabase[512];
+        FS::charPathFromVectorPath(pDatabase, FS::getDatabasePath());
+
+        leveldb::Status statusDatabase = leveldb::DB::Open(this->getLevelDBOptions(config.getSingleDatabaseOptions()), pDatabase, &this->dbSingle);
+        if(!statusDatabase.ok()) {
+            Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to open database " << pDatabase << ": " << statusDatabase.ToString();
+            return;
+        }
+
+        // the old stores are only read once, they don't need a cache or a bloom filter
+        leveldb::Options migrationOptions;
+        migrationOptions.max_open_files = 64;
+        for(uint8_t store : allStores) {
+            this->migrateToSingleDatabase(store, getStorePath(store), migrationOptions);
+        }
+        this->migrateIntegerKeys(DB_BLOCK_HEADERS);
+        this->migrateIntegerKeys(DB_MY_TRANSACTIONS);
+        this->opened = true;
+        return;
+    }
 
     /*
      * AddressStore
@@ -15,7 +79,7 @@ DB::DB() {
     char pAddressStore[512];
     FS::charPathFromVectorPath(pAddressStore, FS::getAddressStorePath());
 
-    leveldb::Status statusAddressStore = leveldb::DB::Open(options, pAddressStore, &this->dbAddressStore);
+    leveldb::Status statusAddressStore = leveldb::DB::Open(this->getLevelDBOptions(config.getDBStoreOptions(DB_ADDRESS_STORE)), pAddressStore, &this->dbAddressStore);
 
     /*
      * BlockIndexStore
@@ -23,7 +87,7 @@ DB::DB() {
     char pBlockIndexStore[512];
     FS::charPathFromVectorPath(pBlockIndexStore, FS::getBlockIndexStorePath());
 
-    leveldb::Status statusBlockIndexStore = leveldb::DB::Open(options, pBlockIndexStore, &this->dbBlockIndexStore);
+    leveldb::Status statusBlockIndexStore = leveldb::DB::Open(this->getLevelDBOptions(config.getDBStoreOptions(DB_BLOCK_INDEX)), pBlockIndexStore, &this->dbBlockIndexStore);
 
     /*
      * NTPSKStore
@@ -31,7 +95,7 @@ DB::DB() {
     char pNTPSKStore[512];
     FS::charPathFromVectorPath(pNTPSKStore, FS::getNTPSKStorePath());
 
-    leveldb::Status statusNTPSKStore = leveldb::DB::Open(options, pNTPSKStore, &this->dbNTPSKStore);
+    leveldb::Status statusNTPSKStore = leveldb::DB::Open(this->getLevelDBOptions(config.getDBStoreOptions(DB_NTPSK_ALREADY_USED)), pNTPSKStore, &this->dbNTPSKStore);
 
     /*
      * DSCCounterStore
@@ -39,7 +103,7 @@ DB::DB() {
     char pDSCCounterStore[512];
     FS::charPathFromVectorPath(pDSCCounterStore, FS::getDSCCounterStorePath());
 
-    leveldb::Status statusDSCCounterStore = leveldb::DB::Open(options, pDSCCounterStore, &this->dbDSCCounterStore);
+    leveldb::Status statusDSCCounterStore = leveldb::DB::Open(this->getLevelDBOptions(config.getDBStoreOptions(DB_DSC_ATTACHED_PASSPORTS_COUNTER)), pDSCCounterStore, &this->dbDSCCounterStore);
 
     /*
      * BlockHeadersStore
@@ -47,7 +111,7 @@ DB::DB() {
     char pBlockHeadersStore[512];
     FS::charPathFromVectorPath(pBlockHeadersStore, FS::getBlockHeadersPath());
 
-    leveldb::Status statusBlockHeadersStore = leveldb::DB::Open(options, pBlockHeadersStore, &this->dbBlockHeadersStore);
+    leveldb::Status statusBlockHeadersStore = leveldb::DB::Open(this->getLevelDBOptions(config.getDBStoreOptions(DB_BLOCK_HEADERS)), pBlockHeadersStore, &this->dbBlockHeadersStore);
 
     /*
      * MyTransactionsStore
@@ -55,7 +119,7 @@ DB::DB() {
     char pMyTransactions[512];
     FS::charPathFromVectorPath(pMyTransactions, FS::getMyTransactionsPath());
 
-    leveldb::Status statusMyTransactions = leveldb::DB::Open(options, pMyTransactions, &this->dbMyTransactions);
+    leveldb::Status statusMyTransactions = leveldb::DB::Open(this->getLevelDBOptions(config.getDBStoreOptions(DB_MY_TRANSACTIONS)), pMyTransactions, &this->dbMyTransactions);
 
     /*
      * Votes
@@ -63,10 +127,296 @@ DB::DB() {
     char pVotes[512];
     FS::charPathFromVectorPath(pVotes, FS::getVotesPath());
 
-    leveldb::Status statusVotes = leveldb::DB::Open(options, pVotes, &this->dbVotes);
+    leveldb::Status statusVotes = leveldb::DB::Open(this->getLevelDBOptions(config.getDBStoreOptions(DB_VOTES)), pVotes, &this->dbVotes);
+
+    /*
+     * BlockUndoStore
+     */
+    char pBlockUndoStore[512];
+    FS::charPathFromVectorPath(pBlockUndoStore, FS::getBlockUndoStorePath());
+
+    leveldb::Status statusBlockUndoStore = leveldb::DB::Open(this->getLevelDBOptions(config.getDBStoreOptions(DB_BLOCK_UNDO)), pBlockUndoStore, &this->dbBlockUndoStore);
+
+    /*
+     * PathSumStore
+     */
+    char pPathSumStore[512];
+    FS::charPathFromVectorPath(pPathSumStore, FS::getPathSumStorePath());
+
+    leveldb::Status statusPathSumStore = leveldb::DB::Open(this->getLevelDBOptions(config.getDBStoreOptions(DB_PATH_SUM)), pPathSumStore, &this->dbPathSumStore);
+
+    for(uint8_t store : allStores) {
+        if(this->getDbForStore(store) == nullptr) {
+            Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to open Store: " << store;
+            return;
+        }
+    }
+
+    // the stores are empty if singleDatabase was turned off after they had been merged
+    if(!this->migrateFromSingleDatabase()) {
+        return;
+    }
+
+    // the stores are half written if an interrupted block transaction can't be finished
+    if(!this->replayBlockTransactionJournal()) {
+        return;
+    }
+
+    this->migrateIntegerKeys(DB_BLOCK_HEADERS);
+    this->migrateIntegerKeys(DB_MY_TRANSACTIONS);
+    this->opened = true;
+}
+
+/**
+ * False if a store couldn't be opened or migrated, the node must not start on empty or partial stores
+ */
+bool DB::isOpen() {
+    return this->opened;
+}
+
+/**
+ * The shared cache and the bloom filter are owned by the DB, a store without bloom filter bits gets none
+ */
+leveldb::Options DB::getLevelDBOptions(DBStoreOptions storeOptions) {
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.write_buffer_size = storeOptions.writeBufferSize;
+    options.max_open_files = (int)storeOptions.maxOpenFiles;
+    options.compression = storeOptions.compression ? leveldb::kSnappyCompression : leveldb::kNoCompression;
+
+    options.block_cache = this->blockCache;
+
+    if(storeOptions.bloomFilterBits > 0) {
+        options.filter_policy = leveldb::NewBloomFilterPolicy((int)storeOptions.bloomFilterBits);
+        this->filterPolicies.emplace_back(options.filter_policy);
+    }
+
+    return options;
+}
+
+/**
+ * Copies a store of the old layout into the single database and deletes it afterwards
+ * An interrupted migration is repeated on the next start, the copied keys are simply written again
+ */
+bool DB::migrateToSingleDatabase(uint8_t store, std::vector<unsigned char> path, leveldb::Options options) {
+    if(!FS::fileExists(FS::concatPaths(path, "/CURRENT"))) {
+        return true;
+    }
+
+    char pStore[512];
+    FS::charPathFromVectorPath(pStore, path);
+
+    options.create_if_missing = false;
+    leveldb::DB* storeDb = nullptr;
+    leveldb::Status status = leveldb::DB::Open(options, pStore, &storeDb);
+    if(!status.ok()) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to open " << pStore << " for migration: " << status.ToString();
+        return false;
+    }
+
+    bool success = true;
+    uint64_t keyCount = 0;
+    uint64_t batchCount = 0;
+    leveldb::WriteBatch batch;
+    leveldb::Iterator* it = storeDb->NewIterator(leveldb::ReadOptions());
+    for (it->SeekToFirst(); it->Valid() && success; it->Next()) {
+        batch.Put(this->getStoreKey(store, it->key().ToString()), it->value());
+        keyCount++;
+        batchCount++;
+
+        if(batchCount == 10000) {
+            success = this->dbSingle->Write(leveldb::WriteOptions(), &batch).ok();
+            batch.Clear();
+            batchCount = 0;
+        }
+    }
+    success = success && it->status().ok();
+    delete it;
+    delete storeDb;
+
+    leveldb::WriteOptions syncOptions;
+    syncOptions.sync = true;
+    success = success && this->dbSingle->Write(syncOptions, &batch).ok();
+
+    if(!success) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to migrate " << pStore << " to the single database";
+        return false;
+    }
+
+    FS::deleteDirectory(path);
+    Log(LOG_LEVEL_INFO) << "Migrated " << keyCount << " key(s) of " << pStore << " to the single database";
+
+    return true;
+}
+
+/**
+ * Copies the stores out of the single database into their own leveldbs and deletes it afterwards
+ * An interrupted migration is repeated on the next start, the copied keys are simply written again
+ */
+bool DB::migrateFromSingleDatabase() {
+    std::vector<unsigned char> path = FS::getDatabasePath();
+    if(!FS::fileExists(FS::concatPaths(path, "/CURRENT"))) {
+        return true;
+    }
+
+    char pDatabase[512];
+    FS::charPathFromVectorPath(pDatabase, path);
+
+    leveldb::Options options;
+    options.max_open_files = 64;
+    leveldb::DB* singleDb = nullptr;
+    leveldb::Status status = leveldb::DB::Open(options, pDatabase, &singleDb);
+    if(!status.ok()) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to open " << pDatabase << " for migration: " << status.ToString()
+                                      << ", set singleDatabase to true to keep using it";
+        return false;
+    }
+
+    leveldb::WriteOptions syncOptions;
+    syncOptions.sync = true;
+
+    bool success = true;
+    uint64_t keyCount = 0;
+    for(uint8_t store : allStores) {
+        leveldb::DB* storeDb = this->getDbForStore(store);
+        std::string prefix(1, (char)store);
+
+        uint64_t batchCount = 0;
+        leveldb::WriteBatch batch;
+        leveldb::Iterator* it = singleDb->NewIterator(leveldb::ReadOptions());
+        for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix) && success; it->Next()) {
+            batch.Put(leveldb::Slice(it->key().data() + prefix.size(), it->key().size() - prefix.size()), it->value());
+            keyCount++;
+            batchCount++;
+            if(batchCount == 10000) {
+                success = storeDb->Write(leveldb::WriteOptions(), &batch).ok();
+                batch.Clear();
+                batchCount = 0;
+            }
+        }
+        success = success && it->status().ok();
+        delete it;
+
+        success = success && storeDb->Write(syncOptions, &batch).ok();
+        if(!success) {
+            break;
+        }
+    }
+    delete singleDb;
+
+    if(!success) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to migrate " << pDatabase << " back to one database per store"
+                                      << ", set singleDatabase to true to keep using it";
+        return false;
+    }
+
+    FS::deleteDirectory(path);
+    Log(LOG_LEVEL_INFO) << "Migrated " << keyCount << " key(s) of " << pDatabase << " back to one database per store";
+
+    return true;
+}
+
+std::string DB::integerKey(uint64_t key) {
+    std::string keyString(DB_INTEGER_KEY_SIZE, (char)DB_INTEGER_KEY_TAG);
+    for(int i = DB_INTEGER_KEY_SIZE - 1; i > 0; i--) {
+        keyString[i] = (char)(key & 0xff);
+        key >>= 8;
+    }
+
+    return keyString;
+}
+
+bool DB::parseIntegerKey(std::string key, uint64_t &value) {
+    if(key.size() != DB_INTEGER_KEY_SIZE || (uint8_t)key[0] != DB_INTEGER_KEY_TAG) {
+        return false;
+    }
+
+    value = 0;
+    for(int i = 1; i < DB_INTEGER_KEY_SIZE; i++) {
+        value = (value << 8) | (uint8_t)key[i];
+    }
+
+    return true;
+}
+
+/**
+ * Integer keys used to be written as decimal strings, they are rewritten as integer keys
+ * Only keys starting with a digit are visited, running it again on a migrated store is cheap
+ */
+bool DB::migrateIntegerKeys(uint8_t store) {
+    leveldb::DB* db = this->getDbForStore(store);
+    if(db == nullptr) {
+        return false;
+    }
+
+    uint64_t keyCount = 0;
+    if(!DB::migrateIntegerKeys(db, this->getStoreKey(store, ""), keyCount)) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to migrate the integer keys of Store: " << store;
+        return false;
+    }
+
+    if(keyCount > 0) {
+        Log(LOG_LEVEL_INFO) << "Migrated " << keyCount << " integer key(s) of Store: " << store;
+    }
+
+    return true;
+}
+
+/**
+ * Migrates the keys below prefix of any leveldb, written with one synced batch
+ */
+bool DB::migrateIntegerKeys(leveldb::DB* db, std::string prefix, uint64_t &keyCount) {
+    keyCount = 0;
+    leveldb::WriteBatch batch;
+    leveldb::Iterator* it = db->NewIterator(leveldb::ReadOptions());
+    for (it->Seek(prefix + "0"); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        std::string key(it->key().data() + prefix.size(), it->key().size() - prefix.size());
+        if(key.empty() || key[0] > '9') {
+            break;
+        }
+
+        // hash keys can start with a digit too, a uint64_t has at most 20 digits
+        if(key.size() > 20 || key.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+
+        batch.Put(prefix + DB::integerKey(std::stoull(key)), it->value());
+        batch.Delete(it->key());
+        keyCount++;
+    }
+    bool success = it->status().ok();
+    delete it;
+
+    if(keyCount == 0) {
+        return success;
+    }
+
+    leveldb::WriteOptions syncOptions;
+    syncOptions.sync = true;
+
+    return success && db->Write(syncOptions, &batch).ok();
+}
+
+/**
+ * Key of an entry in its leveldb, prefixed with the store id in single database mode
+ */
+std::string DB::getStoreKey(uint8_t store, std::string key) {
+    if(!this->singleDatabase) {
+        return key;
+    }
+
+    return std::string(1, (char)store) + key;
 }
 
 leveldb::DB* DB::getDbForStore(uint8_t store) {
+    if(this->singleDatabase) {
+        if(getStorePath(store).empty()) {
+            Log(LOG_LEVEL_CRITICAL_ERROR) << "Unknown db store " << store;
+            return nullptr;
+        }
+        return this->dbSingle;
+    }
+
     leveldb::DB* db;
     switch (store) {
         case DB_ADDRESS_STORE:
@@ -90,6 +440,12 @@ leveldb::DB* DB::getDbForStore(uint8_t store) {
         case DB_VOTES:
             db = this->dbVotes;
             break;
+        case DB_BLOCK_UNDO:
+            db = this->dbBlockUndoStore;
+            break;
+        case DB_PATH_SUM:
+            db = this->dbPathSumStore;
+            break;
         default:
             Log(LOG_LEVEL_CRITICAL_ERROR) << "Unknown db store " << store;
             return nullptr;
@@ -98,19 +454,425 @@ leveldb::DB* DB::getDbForStore(uint8_t store) {
     return db;
 }
 
-std::vector< std::vector<unsigned char> > DB::getAllKeys(uint8_t store) {
+/**
+ * Starts buffering all writes and removals of the calling thread in memory until commitBlockTransaction() is called,
+ * its reads see the buffered state. Calls can be nested, only the outermost commit writes.
+ * A block transaction opened by another thread has to be committed or aborted first.
+ */
+void DB::beginBlockTransaction() {
+    pendingWritesMutex.lock();
+    if(this->isBlockTransactionThread()) {
+        this->blockTransactionDepth++;
+        pendingWritesMutex.unlock();
+        return;
+    }
+    pendingWritesMutex.unlock();
 
+    blockTransactionMutex.lock();
+
+    pendingWritesMutex.lock();
+    this->blockTransactionThread = std::this_thread::get_id();
+    this->blockTransactionDepth = 1;
+    pendingWritesMutex.unlock();
+}
+
+/**
+ * Has to be called with pendingWritesMutex locked
+ */
+bool DB::isBlockTransactionThread() {
+    return this->blockTransactionDepth > 0 && this->blockTransactionThread == std::this_thread::get_id();
+}
+
+/**
+ * Has to be called with pendingWritesMutex locked by the thread owning the block transaction, unlocks it
+ */
+void DB::endBlockTransaction() {
+    this->pendingWrites.clear();
+    this->priorValues.clear();
+    this->blockTransactionDepth = 0;
+    this->blockTransactionThread = std::thread::id();
+    pendingWritesMutex.unlock();
+
+    blockTransactionMutex.unlock();
+}
+
+/**
+ * Writes everything buffered since beginBlockTransaction(), the buffered writes are discarded if it fails
+ */
+bool DB::commitBlockTransaction() {
+    pendingWritesMutex.lock();
+
+    if(!this->isBlockTransactionThread()) {
+        pendingWritesMutex.unlock();
+        Log(LOG_LEVEL_ERROR) << "Cannot commit, no block transaction is open";
+        return false;
+    }
+
+    this->blockTransactionDepth--;
+    if(this->blockTransactionDepth > 0) {
+        pendingWritesMutex.unlock();
+        return true;
+    }
+
+    uint64_t writeCount = 0;
+    for(auto &pendingStore : this->pendingWrites) {
+        writeCount += pendingStore.second.size();
+    }
+
+    bool success = this->writeBlockTransaction();
+    this->endBlockTransaction();
+
+    if(!success) {
+        return false;
+    }
+
+    Log(LOG_LEVEL_INFO) << "committed block transaction with " << writeCount << " write(s)";
+
+    return true;
+}
+
+/**
+ * Discards everything buffered since the outermost beginBlockTransaction(), nested transactions included
+ */
+void DB::abortBlockTransaction() {
+    pendingWritesMutex.lock();
+
+    if(!this->isBlockTransactionThread()) {
+        pendingWritesMutex.unlock();
+        Log(LOG_LEVEL_ERROR) << "Cannot abort, no block transaction is open";
+        return;
+    }
+
+    this->endBlockTransaction();
+
+    Log(LOG_LEVEL_INFO) << "aborted block transaction";
+}
+
+/**
+ * Has to be called with pendingWritesMutex locked
+ */
+void DB::appendToBatch(leveldb::WriteBatch &batch, uint8_t store) {
+    for(auto &pendingWrite : this->pendingWrites[store]) {
+        std::string storeKey = this->getStoreKey(store, pendingWrite.first);
+        if(pendingWrite.second.first) {
+            batch.Put(storeKey, pendingWrite.second.second);
+        } else {
+            batch.Delete(storeKey);
+        }
+    }
+}
+
+/**
+ * Has to be called with pendingWritesMutex locked
+ * A block is committed with one synced write in both layouts, everything else is written without sync.
+ * In single database mode all stores are written with that one batch, atomically.
+ * With one leveldb per store the whole transaction is first written to a journal, the stores are written after it
+ * and the journal is removed with the last of them. A crash in between is repaired by replaying the journal at start.
+ * The unsynced store writes of earlier blocks can still be lost to a power failure, which is why the single database is the default.
+ */
+bool DB::writeBlockTransaction() {
+    if(this->pendingWrites.empty()) {
+        return true;
+    }
+
+    leveldb::WriteOptions syncOptions;
+    syncOptions.sync = true;
+
+    if(this->singleDatabase) {
+        leveldb::WriteBatch batch;
+        for(auto &pendingStore : this->pendingWrites) {
+            this->appendToBatch(batch, pendingStore.first);
+        }
+
+        if(!this->dbSingle->Write(syncOptions, &batch).ok()) {
+            Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to write block transaction to the single database";
+            return false;
+        }
+        return true;
+    }
+
+    // a single store is written atomically without a journal
+    if(this->pendingWrites.size() == 1) {
+        uint8_t store = this->pendingWrites.begin()->first;
+        leveldb::WriteBatch batch;
+        this->appendToBatch(batch, store);
+        if(!this->getDbForStore(store)->Write(syncOptions, &batch).ok()) {
+            Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to write block transaction to Store: " << store;
+            return false;
+        }
+        return true;
+    }
+
+    CDataStream journal(SER_DISK, 1);
+    journal << this->pendingWrites;
+    leveldb::DB* journalDb = this->getDbForStore(DB_BLOCK_HEADERS);
+    if(!journalDb->Put(syncOptions, DB_BLOCK_TRANSACTION_JOURNAL_KEY, leveldb::Slice(journal.data(), journal.size())).ok()) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to write the block transaction journal";
+        return false;
+    }
+
+    // block headers are written last so a height is only mapped to a block once its state is written
+    for(auto &pendingStore : this->pendingWrites) {
+        if(pendingStore.first == DB_BLOCK_HEADERS) {
+            continue;
+        }
+
+        leveldb::WriteBatch batch;
+        this->appendToBatch(batch, pendingStore.first);
+        if(!this->getDbForStore(pendingStore.first)->Write(leveldb::WriteOptions(), &batch).ok()) {
+            Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to write block transaction to Store: " << pendingStore.first;
+            return false;
+        }
+    }
+
+    leveldb::WriteBatch batch;
+    this->appendToBatch(batch, DB_BLOCK_HEADERS);
+    batch.Delete(DB_BLOCK_TRANSACTION_JOURNAL_KEY);
+    if(!journalDb->Write(leveldb::WriteOptions(), &batch).ok()) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to write block transaction to Store: " << DB_BLOCK_HEADERS;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Finishes a block transaction whose commit has been interrupted, writing its entries again is harmless
+ */
+bool DB::replayBlockTransactionJournal() {
+    leveldb::DB* journalDb = this->getDbForStore(DB_BLOCK_HEADERS);
+    if(journalDb == nullptr) {
+        return false;
+    }
+
+    std::string journalValue;
+    if(!journalDb->Get(leveldb::ReadOptions(), DB_BLOCK_TRANSACTION_JOURNAL_KEY, &journalValue).ok()) {
+        return true;
+    }
+
+    try {
+        CDataStream journal(SER_DISK, 1);
+        journal.write(journalValue.data(), journalValue.size());
+        journal >> this->pendingWrites;
+    } catch (const std::exception& e) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to read the block transaction journal: " << e.what();
+        this->pendingWrites.clear();
+        return false;
+    }
+
+    Log(LOG_LEVEL_INFO) << "replaying interrupted block transaction";
+
+    pendingWritesMutex.lock();
+    bool success = this->writeBlockTransaction();
+    this->pendingWrites.clear();
+    pendingWritesMutex.unlock();
+
+    if(!success) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to replay the block transaction journal";
+    }
+
+    return success;
+}
+
+/**
+ * Has to be called with pendingWritesMutex locked and before the key is added to pendingWrites.
+ * Only chain state is recorded, blocks, headers and my transactions stay when a block is disconnected.
+ */
+void DB::recordPriorValue(uint8_t store, std::string key) {
+    switch(store) {
+        case DB_ADDRESS_STORE:
+        case DB_NTPSK_ALREADY_USED:
+        case DB_DSC_ATTACHED_PASSPORTS_COUNTER:
+        case DB_VOTES:
+            break;
+        default:
+            return;
+    }
+
+    if(this->pendingWrites[store].count(key) > 0) {
+        return;
+    }
+
+    std::string value;
+    leveldb::Status status = this->getDbForStore(store)->Get(leveldb::ReadOptions(), this->getStoreKey(store, key), &value);
+    this->priorValues[store][key] = std::make_pair(status.ok(), value);
+}
+
+/**
+ * Returns the values the chain state keys had before the open block transaction modified them,
+ * writing them back reverts the block transaction
+ */
+std::map<uint8_t, std::map<std::string, std::pair<bool, std::string> > > DB::getPriorValues() {
+    pendingWritesMutex.lock();
+    std::map<uint8_t, std::map<std::string, std::pair<bool, std::string> > > response = this->priorValues;
+    pendingWritesMutex.unlock();
+
+    return response;
+}
+
+bool DB::getPendingWrite(uint8_t store, std::string key, bool &isPresent, std::string &value) {
+    pendingWritesMutex.lock();
+
+    bool found = false;
+    auto pendingStore = this->pendingWrites.find(store);
+    if(this->isBlockTransactionThread() && pendingStore != this->pendingWrites.end()) {
+        auto pendingWrite = pendingStore->second.find(key);
+        if(pendingWrite != pendingStore->second.end()) {
+            found = true;
+            isPresent = pendingWrite->second.first;
+            value = pendingWrite->second.second;
+        }
+    }
+
+    pendingWritesMutex.unlock();
+
+    return found;
+}
+
+/**
+ * Point lookup through the open block transaction and the leveldb, counted in the store statistics
+ */
+bool DB::lookup(uint8_t store, std::string key, std::string &value) {
+    bool isPresent = false;
+    if(this->getPendingWrite(store, key, isPresent, value)) {
+        this->pendingHits[store]++;
+        return isPresent;
+    }
+
+    leveldb::Status status = this->getDbForStore(store)->Get(leveldb::ReadOptions(), this->getStoreKey(store, key), &value);
+    if(!status.ok()) {
+        this->misses[store]++;
+        return false;
+    }
+
+    this->hits[store]++;
+    return true;
+}
+
+DBStoreStatistics DB::getStatistics(uint8_t store) {
+    DBStoreStatistics statistics;
+    if(store >= DB_STORE_COUNT) {
+        return statistics;
+    }
+
+    statistics.hits = this->hits[store];
+    statistics.misses = this->misses[store];
+    statistics.pendingHits = this->pendingHits[store];
+
+    return statistics;
+}
+
+/**
+ * Removes every entry of a store, it can't be called while a block transaction is open
+ */
+bool DB::clearStore(uint8_t store) {
     leveldb::DB* db = this->getDbForStore(store);
-    std::vector< std::vector<unsigned char> > response;
+    if(db == nullptr) {
+        return false;
+    }
 
+    bool success = true;
+    uint64_t batchCount = 0;
+    leveldb::WriteBatch batch;
+    std::string prefix = this->getStoreKey(store, "");
     leveldb::Iterator* it = db->NewIterator(leveldb::ReadOptions());
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        leveldb::Slice key = it->key();
-        response.emplace_back(std::vector<unsigned char>(key.data(), key.data() + key.size()));
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        batch.Delete(it->key());
+        batchCount++;
+
+        if(batchCount == 10000) {
+            success = db->Write(leveldb::WriteOptions(), &batch).ok() && success;
+            batch.Clear();
+            batchCount = 0;
+        }
+    }
+    success = it->status().ok() && success;
+    delete it;
+
+    success = db->Write(leveldb::WriteOptions(), &batch).ok() && success;
+
+    if(!success) {
+        Log(LOG_LEVEL_ERROR) << "Failed to clear Store: " << store;
+    }
+
+    return success;
+}
+
+/**
+ * Iterator over all committed entries of a store, the caller has to delete it
+ */
+DBIterator* DB::newIterator(uint8_t store) {
+    return this->newIterator(store, std::vector<unsigned char>());
+}
+
+/**
+ * Iterator over the committed entries whose key starts with prefix, the caller has to delete it
+ */
+DBIterator* DB::newIterator(uint8_t store, std::vector<unsigned char> prefix) {
+    leveldb::DB* db = this->getDbForStore(store);
+    if(db == nullptr) {
+        return nullptr;
+    }
+
+    std::string storePrefix = this->getStoreKey(store, "");
+    std::string keyPrefix = storePrefix + std::string(prefix.begin(), prefix.end());
+
+    return new DBIterator(db, storePrefix, keyPrefix, keyPrefix, "", false);
+}
+
+/**
+ * Iterator over the committed integer keys from and to inclusive in numerical order, the caller has to delete it
+ */
+DBIterator* DB::newIterator(uint8_t store, uint64_t from, uint64_t to) {
+    leveldb::DB* db = this->getDbForStore(store);
+    if(db == nullptr) {
+        return nullptr;
+    }
+
+    std::string storePrefix = this->getStoreKey(store, "");
+
+    return new DBIterator(db, storePrefix, storePrefix, storePrefix + DB::integerKey(from), storePrefix + DB::integerKey(to), true);
+}
+
+/**
+ * Values of the integer keys from and to inclusive, read with one iterator sweep
+ */
+std::map<uint64_t, std::vector<unsigned char> > DB::getRange(uint8_t store, uint64_t from, uint64_t to) {
+    std::map<uint64_t, std::vector<unsigned char> > response;
+
+    if(from > to) {
+        return response;
+    }
+
+    DBIterator* it = this->newIterator(store, from, to);
+    if(it == nullptr) {
+        return response;
+    }
+
+    for(; it->valid(); it->next()) {
+        leveldb::Slice value = it->value();
+        response[it->integerKey()] = std::vector<unsigned char>(value.data(), value.data() + value.size());
     }
-    assert(it->status().ok());  // Check for any errors found during the scan
     delete it;
 
+    pendingWritesMutex.lock();
+    auto pendingStore = this->pendingWrites.find(store);
+    if(this->isBlockTransactionThread() && pendingStore != this->pendingWrites.end()) {
+        for(auto &pendingWrite : pendingStore->second) {
+            uint64_t key;
+            if(!DB::parseIntegerKey(pendingWrite.first, key) || key < from || key > to) {
+                continue;
+            }
+
+            if(pendingWrite.second.first) {
+                response[key] = std::vector<unsigned char>(pendingWrite.second.second.begin(), pendingWrite.second.second.end());
+            } else {
+                response.erase(key);
+            }
+        }
+    }
+    pendingWritesMutex.unlock();
+
     return response;
 }
 
@@ -125,7 +887,16 @@ bool DB::putInDB(uint8_t store, std::string key, std::vector<unsigned char> valu
         return false;
     }
 
-    leveldb::Status status = db->Put(writeOptions, key, valueString);
+    pendingWritesMutex.lock();
+    if(this->isBlockTransactionThread()) {
+        this->recordPriorValue(store, key);
+        this->pendingWrites[store][key] = std::make_pair(true, valueString);
+        pendingWritesMutex.unlock();
+        return true;
+    }
+    pendingWritesMutex.unlock();
+
+    leveldb::Status status = db->Put(writeOptions, this->getStoreKey(store, key), valueString);
 
     if(!status.ok()) {
         Log(LOG_LEVEL_ERROR) << "Failed to write to Store: " << store;
@@ -144,7 +915,7 @@ bool DB::putInDB(uint8_t store, std::vector<unsigned char> key, std::vector<unsi
 }
 
 bool DB::putInDB(uint8_t store, uint64_t key, std::vector<unsigned char> value) {
-    std::string nKey = std::to_string(key);
+    std::string nKey = DB::integerKey(key);
 
     return this->putInDB(store, nKey, value);
 }
@@ -152,16 +923,16 @@ bool DB::putInDB(uint8_t store, uint64_t key, std::vector<unsigned char> value)
 std::vector<unsigned char> DB::getFromDB(uint8_t store, std::string keyString) {
     std::string valueString;
 
-    leveldb::ReadOptions readOptions;
-
     leveldb::DB* db = this->getDbForStore(store);
     if(db == nullptr) {
         return std::vector<unsigned char>();
     }
 
-    leveldb::Status status = db->Get(readOptions, keyString, &valueString);
+    if(!this->lookup(store, keyString, valueString)) {
+        return std::vector<unsigned char>();
+    }
 
-    if(valueString.empty() || !status.ok()) {
+    if(valueString.empty()) {
         return std::vector<unsigned char>();
     }
 
@@ -180,7 +951,7 @@ std::vector<unsigned char> DB::getFromDB(uint8_t store, std::vector<unsigned cha
 }
 
 std::vector<unsigned char> DB::getFromDB(uint8_t store, uint64_t key) {
-    std::string keyString = std::to_string(key);
+    std::string keyString = DB::integerKey(key);
 
     return this->getFromDB(store, keyString);
 }
@@ -190,17 +961,12 @@ bool DB::isInDB(uint8_t store, std::vector<unsigned char> key) {
     std::string keyString((char*)key.data(), key.size());
     std::string valueString;
 
-    leveldb::ReadOptions readOptions;
-
     leveldb::DB* db = this->getDbForStore(store);
     if(db == nullptr) {
         return false;
     }
 
-    leveldb::Status status = db->Get(readOptions, keyString, &valueString);
-
-
-    return status.ok();
+    return this->lookup(store, keyString, valueString);
 }
 
 bool DB::removeFromDB(uint8_t store, std::vector<unsigned char> key) {
@@ -214,7 +980,22 @@ bool DB::removeFromDB(uint8_t store, std::vector<unsigned char> key) {
         return false;
     }
 
-    leveldb::Status status = db->Delete(writeOptions, keyString);
+    pendingWritesMutex.lock();
+    if(this->isBlockTransactionThread()) {
+        this->recordPriorValue(store, keyString);
+        this->pendingWrites[store][keyString] = std::make_pair(false, std::string());
+        pendingWritesMutex.unlock();
+        return true;
+    }
+    pendingWritesMutex.unlock();
+
+    leveldb::Status status = db->Delete(writeOptions, this->getStoreKey(store, keyString));
 
     return status.ok();
 }
+
+bool DB::removeFromDB(uint8_t store, uint64_t key) {
+    std::string keyString = DB::integerKey(key);
+
+    return this->removeFromDB(store, std::vector<unsigned char>(keyString.begin(), keyString.end()));
+}
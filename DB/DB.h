@@ -2,11 +2,37 @@
 #ifndef TX_DB_H
 #define TX_DB_H
 
+#include <atomic>
+#include <leveldb/cache.h>
 #include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <leveldb/status.h>
+#include <leveldb/write_batch.h>
 #include "../streams.h"
+#include "../ChainParams.h"
+#include "../Config.h"
 #include "../Tools/Hexdump.h"
+#include "DBIterator.h"
+
+/**
+ * Point lookups since start, misses are answered by the bloom filter most of the time without reading a table file
+ */
+struct DBStoreStatistics {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t pendingHits = 0; // answered by the open block transaction
+};
+
+// integer keys are the tag followed by the big endian value so leveldb orders them numerically
+#define DB_INTEGER_KEY_TAG 0x00
+#define DB_INTEGER_KEY_SIZE 9
+
+// written to DB_BLOCK_HEADERS before a block transaction is spread over the stores, replayed at start if it is still there
+#define DB_BLOCK_TRANSACTION_JOURNAL_KEY "blockTransactionJournal"
 
 class DB {
 private:
@@ -17,6 +43,45 @@ private:
     leveldb::DB* dbBlockHeadersStore = nullptr;
     leveldb::DB* dbMyTransactions = nullptr;
     leveldb::DB* dbVotes = nullptr;
+    leveldb::DB* dbBlockUndoStore = nullptr;
+    leveldb::DB* dbPathSumStore = nullptr;
+
+    // in single database mode all stores share dbSingle, keys are prefixed with the store id
+    bool singleDatabase = false;
+    leveldb::DB* dbSingle = nullptr;
+    bool opened = false;
+
+    // the cache and bloom filters have to outlive the leveldbs using them
+    leveldb::Cache* blockCache = nullptr;
+    std::vector<const leveldb::FilterPolicy*> filterPolicies;
+
+    std::atomic<uint64_t> hits[DB_STORE_COUNT] = {};
+    std::atomic<uint64_t> misses[DB_STORE_COUNT] = {};
+    std::atomic<uint64_t> pendingHits[DB_STORE_COUNT] = {};
+
+    // Mutations buffered by an open block transaction: store -> key -> (isPresent, value)
+    // isPresent == false marks a removed key
+    // Only the thread that opened the transaction writes into it and reads through it, other threads use the leveldbs directly
+    std::map<uint8_t, std::map<std::string, std::pair<bool, std::string> > > pendingWrites;
+    uint32_t blockTransactionDepth = 0;
+    std::thread::id blockTransactionThread;
+    std::mutex blockTransactionMutex; // held from the outermost beginBlockTransaction() to its commit or abort
+    std::mutex pendingWritesMutex;
+
+    // Values the keys of chain state stores had before the open block transaction touched them
+    std::map<uint8_t, std::map<std::string, std::pair<bool, std::string> > > priorValues;
+    void recordPriorValue(uint8_t store, std::string key);
+    bool isBlockTransactionThread();
+    void endBlockTransaction();
+    void appendToBatch(leveldb::WriteBatch &batch, uint8_t store);
+    bool writeBlockTransaction();
+    bool replayBlockTransactionJournal();
+    bool getPendingWrite(uint8_t store, std::string key, bool &isPresent, std::string &value);
+    std::string getStoreKey(uint8_t store, std::string key);
+    leveldb::Options getLevelDBOptions(DBStoreOptions storeOptions);
+    bool lookup(uint8_t store, std::string key, std::string &value);
+    bool migrateToSingleDatabase(uint8_t store, std::vector<unsigned char> path, leveldb::Options options);
+    bool migrateFromSingleDatabase();
 public:
     DB();
     static DB& Instance(){
@@ -68,12 +133,28 @@ public:
 
     template < class Serializable >
     bool serializeToDb(uint8_t store, uint64_t key, Serializable& data) {
-        std::string keyString = std::to_string(key);
-        return serializeToDb(store, Hexdump::stringToCharVector(keyString), data);
+        std::string keyString = DB::integerKey(key);
+        return serializeToDb(store, std::vector<unsigned char>(keyString.begin(), keyString.end()), data);
     }
 
+    bool isOpen();
+
+    static std::string integerKey(uint64_t key);
+    static bool parseIntegerKey(std::string key, uint64_t &value);
+    bool migrateIntegerKeys(uint8_t store);
+    static bool migrateIntegerKeys(leveldb::DB* db, std::string prefix, uint64_t &keyCount);
+
+    void beginBlockTransaction();
+    bool commitBlockTransaction();
+    void abortBlockTransaction();
+    std::map<uint8_t, std::map<std::string, std::pair<bool, std::string> > > getPriorValues();
     leveldb::DB* getDbForStore(uint8_t store);
-    std::vector< std::vector<unsigned char> > getAllKeys(uint8_t store);
+    DBStoreStatistics getStatistics(uint8_t store);
+    DBIterator* newIterator(uint8_t store);
+    DBIterator* newIterator(uint8_t store, std::vector<unsigned char> prefix);
+    DBIterator* newIterator(uint8_t store, uint64_t from, uint64_t to);
+    std::map<uint64_t, std::vector<unsigned char> > getRange(uint8_t store, uint64_t from, uint64_t to);
+    bool clearStore(uint8_t store);
     bool putInDB(uint8_t store, std::string key, std::vector<unsigned char> value);
     bool putInDB(uint8_t store, std::vector<unsigned char> key, std::vector<unsigned char> value);
     bool putInDB(uint8_t store, uint64_t key, std::vector<unsigned char> value);
@@ -82,6 +163,7 @@ public:
     std::vector<unsigned char> getFromDB(uint8_t store, uint64_t key);
     bool isInDB(uint8_t store, std::vector<unsigned char> key);
     bool removeFromDB(uint8_t store, std::vector<unsigned char> key);
+    bool removeFromDB(uint8_t store, uint64_t key);
 };
 
 
@@ -0,0 +1,81 @@
+#include "DBIterator.h"
+#include "DB.h"
+
+/**
+ * firstKey, lastKey and prefix include the store prefix, an empty lastKey means no upper bound
+ */
+DBIterator::DBIterator(leveldb::DB* db, std::string storePrefix, std::string prefix, std::string firstKey, std::string lastKey, bool integerKeysOnly) {
+    this->db = db;
+    this->storePrefixSize = storePrefix.size();
+    this->prefix = prefix;
+    this->lastKey = lastKey;
+    this->integerKeysOnly = integerKeysOnly;
+    this->snapshot = db->GetSnapshot();
+
+    // bulk reads would evict the blocks of point lookups from the cache
+    leveldb::ReadOptions readOptions;
+    readOptions.snapshot = this->snapshot;
+    readOptions.fill_cache = false;
+
+    this->it = db->NewIterator(readOptions);
+    this->it->Seek(firstKey);
+    this->skipToValid();
+}
+
+DBIterator::~DBIterator() {
+    delete this->it;
+    this->db->ReleaseSnapshot(this->snapshot);
+}
+
+/**
+ * Hash keys starting with the integer key tag are skipped when only integer keys are requested
+ */
+void DBIterator::skipToValid() {
+    if(!this->integerKeysOnly) {
+        return;
+    }
+
+    while(this->valid()) {
+        uint64_t value;
+        if(DB::parseIntegerKey(this->key().ToString(), value)) {
+            return;
+        }
+        this->it->Next();
+    }
+}
+
+bool DBIterator::valid() {
+    return this->it->Valid()
+           && this->it->key().starts_with(this->prefix)
+           && (this->lastKey.empty() || this->it->key().compare(this->lastKey) <= 0);
+}
+
+void DBIterator::next() {
+    this->it->Next();
+    this->skipToValid();
+}
+
+leveldb::Slice DBIterator::key() {
+    leveldb::Slice key = this->it->key();
+    return leveldb::Slice(key.data() + this->storePrefixSize, key.size() - this->storePrefixSize);
+}
+
+leveldb::Slice DBIterator::value() {
+    return this->it->value();
+}
+
+/**
+ * Only meaningful for iterators over integer keys
+ */
+uint64_t DBIterator::integerKey() {
+    uint64_t value = 0;
+    DB::parseIntegerKey(this->key().ToString(), value);
+    return value;
+}
+
+/**
+ * False if the scan stopped because of a read error
+ */
+bool DBIterator::ok() {
+    return this->it->status().ok();
+}
@@ -0,0 +1,61 @@
+
+#ifndef TX_DBITERATOR_H
+#define TX_DBITERATOR_H
+
+#include <cstdint>
+#include <string>
+#include <leveldb/db.h>
+#include "../streams.h"
+
+/**
+ * Cursor over the committed entries of a store, created by DB::newIterator()
+ * It reads from a leveldb snapshot, writes done while iterating and an open block transaction are not visible.
+ * Keys and values are slices into the leveldb iterator, they are only valid until next() is called.
+ */
+class DBIterator {
+private:
+    leveldb::DB* db;
+    const leveldb::Snapshot* snapshot;
+    leveldb::Iterator* it;
+    size_t storePrefixSize; // store id prefix in single database mode
+    std::string prefix;
+    std::string lastKey;
+    bool integerKeysOnly;
+
+    void skipToValid();
+public:
+    DBIterator(leveldb::DB* db, std::string storePrefix, std::string prefix, std::string firstKey, std::string lastKey, bool integerKeysOnly);
+    ~DBIterator();
+
+    DBIterator(const DBIterator&) = delete;
+    DBIterator& operator=(const DBIterator&) = delete;
+
+    bool valid();
+    void next();
+    leveldb::Slice key();
+    leveldb::Slice value();
+    uint64_t integerKey();
+    bool ok();
+
+    template < class Serializable >
+    bool deserializeValue(Serializable& data) {
+        leveldb::Slice found = this->value();
+
+        if(found.empty()) {
+            return false;
+        }
+
+        try {
+            CDataStream s(SER_DISK, 1);
+            s.write(found.data(), found.size());
+            s >> data;
+        } catch (const std::exception& e) {
+            return false;
+        }
+
+        return true;
+    }
+};
+
+
+#endif //TX_DBITERATOR_H
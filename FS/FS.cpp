@@ -134,6 +134,24 @@ bool FS::createDirectory(std::vector<unsigned char> path) {
     return boost::filesystem::create_directory(pData);
 }
 
+bool FS::deleteDirectory(std::vector<unsigned char> path) {
+    char pData[512];
+    FS::charPathFromVectorPath(pData, path);
+    boost::system::error_code errorCode;
+    boost::filesystem::remove_all(pData, errorCode);
+    return !errorCode;
+}
+
+bool FS::renamePath(std::vector<unsigned char> from, std::vector<unsigned char> to) {
+    char pFrom[512];
+    char pTo[512];
+    FS::charPathFromVectorPath(pFrom, from);
+    FS::charPathFromVectorPath(pTo, to);
+    boost::system::error_code errorCode;
+    boost::filesystem::rename(pFrom, pTo, errorCode);
+    return !errorCode;
+}
+
 std::vector<unsigned char> FS::getBasePath() {
     const char *t = BASE_PATH;
     return std::vector<unsigned char>(t, t + strlen(t));
@@ -164,6 +182,10 @@ std::vector<unsigned char> FS::getBlockDatDirectoryPath() {
     return FS::concatPaths(FS::getBasePath(), "blockdat/");
 }
 
+std::vector<unsigned char> FS::getBlockDatReindexDirectoryPath() {
+    return FS::concatPaths(FS::getBasePath(), "blockdat-reindex/");
+}
+
 std::vector<unsigned char> FS::getBlockDatPath() {
 
     std::vector<std::vector<unsigned char> > fileList = FS::readDir(FS::getBlockDatDirectoryPath());
@@ -221,6 +243,17 @@ std::vector<unsigned char> FS::getBlockDatPath() {
     return currentBlkFile;
 }
 
+std::vector<unsigned char> FS::getBlockDatPath(uint32_t fileNumber) {
+    return FS::getBlockDatPath(FS::getBlockDatDirectoryPath(), fileNumber);
+}
+
+std::vector<unsigned char> FS::getBlockDatPath(std::vector<unsigned char> directoryPath, uint32_t fileNumber) {
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "%08u.dat", fileNumber);
+
+    return FS::concatPaths(directoryPath, fileName);
+}
+
 std::vector<unsigned char> FS::getBlockHeadersPath() {
     return FS::concatPaths(FS::getBasePath(), "headers.mdb");
 }
@@ -257,6 +290,18 @@ std::vector<unsigned char> FS::getDSCCounterStorePath() {
     return FS::concatPaths(FS::getBasePath(), "DSCCounterStore.mdb");
 }
 
+std::vector<unsigned char> FS::getBlockUndoStorePath() {
+    return FS::concatPaths(FS::getBasePath(), "BlockUndoStore.mdb");
+}
+
+std::vector<unsigned char> FS::getPathSumStorePath() {
+    return FS::concatPaths(FS::getBasePath(), "PathSumStore.mdb");
+}
+
+std::vector<unsigned char> FS::getDatabasePath() {
+    return FS::concatPaths(FS::getBasePath(), "Database.mdb");
+}
+
 std::vector<unsigned char> FS::getLogPath() {
     return FS::concatPaths(FS::getBasePath(), "LOGS/");
 }
@@ -85,6 +85,8 @@ public:
     static std::vector<std::vector<unsigned char> > readDir(std::vector<unsigned char> path);
     static bool isDir(std::vector<unsigned char> path);
     static bool createDirectory(std::vector<unsigned char> path);
+    static bool deleteDirectory(std::vector<unsigned char> path);
+    static bool renamePath(std::vector<unsigned char> from, std::vector<unsigned char> to);
     static std::vector<unsigned char> getBasePath();
     static std::vector<unsigned char> getLockPath();
     static std::vector<unsigned char> getWebBasePath();
@@ -92,7 +94,10 @@ public:
     static std::vector<unsigned char> getCertDirectoryPath();
     static std::vector<unsigned char> getImportDirectoryPath();
     static std::vector<unsigned char> getBlockDatDirectoryPath();
+    static std::vector<unsigned char> getBlockDatReindexDirectoryPath();
     static std::vector<unsigned char> getBlockDatPath();
+    static std::vector<unsigned char> getBlockDatPath(uint32_t fileNumber);
+    static std::vector<unsigned char> getBlockDatPath(std::vector<unsigned char> directoryPath, uint32_t fileNumber);
     static std::vector<unsigned char> getBlockHeadersPath();
     static std::vector<unsigned char> getMyTransactionsPath();
     static std::vector<unsigned char> getVotesPath();
@@ -102,6 +107,9 @@ public:
     static std::vector<unsigned char> getBlockIndexStorePath();
     static std::vector<unsigned char> getNTPSKStorePath();
     static std::vector<unsigned char> getDSCCounterStorePath();
+    static std::vector<unsigned char> getBlockUndoStorePath();
+    static std::vector<unsigned char> getPathSumStorePath();
+    static std::vector<unsigned char> getDatabasePath();
     static std::vector<unsigned char> getLogPath();
     static std::vector<unsigned char> getHome();
     static std::vector<unsigned char> getConfigBasePath();
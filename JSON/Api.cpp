@@ -25,6 +25,8 @@
 #include "../Network/BanList.h"
 #include "../Crypto/CreateSignature.h"
 #include "../Base64.h"
+#include "../DB/DB.h"
+#include "../Config.h"
 
 using boost::property_tree::ptree;
 
@@ -38,7 +40,7 @@ ptree error(std::string message) {
 ptree uamountToPtree(UAmount uamount) {
     ptree uamountTree;
 
-    for(std::map<uint8_t, CAmount>::iterator it = uamount.map.begin(); it != uamount.map.end(); it++) {
+    for(auto it = uamount.map.begin(); it != uamount.map.end(); it++) {
         if(it->second > 0) {
             uamountTree.put(std::to_string(it->first), std::to_string(it->second));
         }
@@ -123,7 +125,7 @@ ptree txToPtree(Transaction transaction, bool checkIsMine) {
 ptree uamountToPtree(UAmount32 uamount) {
     ptree uamountTree;
 
-    for(std::map<uint8_t, CAmount32>::iterator it = uamount.map.begin(); it != uamount.map.end(); it++) {
+    for(auto it = uamount.map.begin(); it != uamount.map.end(); it++) {
         uamountTree.put(std::to_string(it->first), std::to_string(it->second));
     }
 
@@ -610,8 +612,7 @@ std::string Api::myTransactions() {
         ptree txInTree;
         ptree txOutTree;
 
-        BlockHeader* header = chain.getBlockHeader(it->getBlockHash());
-        if(header != nullptr) {
+        if(chain.doesBlockExist(it->getBlockHash())) {
             transactionsTree.push_back(std::make_pair("", txToPtree(it->getTx(), true)));
             txNbr++;
             if(txNbr > MAX_NUMBER_OF_MY_TRANSACTIONS_TO_DISPLAY) {
@@ -1125,7 +1126,7 @@ std::string Api::getIncomingTx() {
 
 std::string Api::getBlock(uint32_t blockHeight) {
     Chain& chain = Chain::Instance();
-    BlockHeader* blockHeader = chain.getBlockHeader(blockHeight);
+    BlockHeaderIndexEntry* blockHeader = chain.getBlockHeader(blockHeight);
 
     if(blockHeader != nullptr) {
         return Api::getBlock(blockHeader->getHeaderHash());
@@ -1134,12 +1135,41 @@ std::string Api::getBlock(uint32_t blockHeight) {
     return "{\"error\": \"Block not found\"}";
 }
 
+/**
+ * Header hashes of the active chain from fromHeight to toHeight, at most API_BLOCK_HASHES_MAX
+ */
+std::string Api::getBlockHashes(uint32_t fromHeight, uint32_t toHeight) {
+    Chain& chain = Chain::Instance();
+    DB& db = DB::Instance();
+
+    // heights above the tip can still map to blocks of a disconnected fork
+    toHeight = std::min(toHeight, chain.getCurrentBlockchainHeight());
+    if(toHeight >= fromHeight + API_BLOCK_HASHES_MAX) {
+        toHeight = fromHeight + API_BLOCK_HASHES_MAX - 1;
+    }
+
+    ptree baseTree;
+    ptree blocksTree;
+    for(auto& height : db.getRange(DB_BLOCK_HEADERS, fromHeight, toHeight)) {
+        ptree blockTree;
+        blockTree.put("height", height.first);
+        blockTree.put("hash", Hexdump::vectorToHexString(height.second));
+        blocksTree.push_back(std::make_pair("", blockTree));
+    }
+    baseTree.add_child("blocks", blocksTree);
+
+    std::stringstream ss;
+    boost::property_tree::json_parser::write_json(ss, baseTree);
+
+    return ss.str();
+}
+
 std::string Api::getBlock(std::vector<unsigned char> blockHeaderHash) {
 
     Chain& chain = Chain::Instance();
-    BlockHeader* blockHeader = chain.getBlockHeader(blockHeaderHash);
+    BlockHeader blockHeader;
 
-    if(blockHeader == NULL) {
+    if(!chain.readBlockHeader(blockHeaderHash, blockHeader)) {
         Log(LOG_LEVEL_WARNING) << "BlockHeader with hash " << blockHeaderHash << "was not found";
 
         std::stringstream ss;
@@ -1153,17 +1183,17 @@ std::string Api::getBlock(std::vector<unsigned char> blockHeaderHash) {
     ptree transactionsTree;
 
     blockHeaderTree.put("headerHash", Hexdump::vectorToHexString(blockHeaderHash));
-    blockHeaderTree.put("previousHeaderHash", Hexdump::vectorToHexString(blockHeader->getPreviousHeaderHash()));
-    blockHeaderTree.put("merkleRootHash", Hexdump::vectorToHexString(blockHeader->getMerkleRootHash()));
-    blockHeaderTree.put("blockHeight", blockHeader->getBlockHeight());
-    blockHeaderTree.put("timestamp", blockHeader->getTimestamp());
-    blockHeaderTree.put("issuerPubKey", Hexdump::vectorToHexString(blockHeader->getIssuerPubKey()));
-    blockHeaderTree.put("issuerSignature", Hexdump::vectorToHexString(blockHeader->getIssuerSignature()));
-    blockHeaderTree.push_back(std::make_pair("payout", uamountToPtree(blockHeader->getPayout())));
-    blockHeaderTree.push_back(std::make_pair("payoutRemainder", uamountToPtree(blockHeader->getPayoutRemainder())));
-    blockHeaderTree.push_back(std::make_pair("ubiReceiverCount", uamountToPtree(blockHeader->getUbiReceiverCount())));
+    blockHeaderTree.put("previousHeaderHash", Hexdump::vectorToHexString(blockHeader.getPreviousHeaderHash()));
+    blockHeaderTree.put("merkleRootHash", Hexdump::vectorToHexString(blockHeader.getMerkleRootHash()));
+    blockHeaderTree.put("blockHeight", blockHeader.getBlockHeight());
+    blockHeaderTree.put("timestamp", blockHeader.getTimestamp());
+    blockHeaderTree.put("issuerPubKey", Hexdump::vectorToHexString(blockHeader.getIssuerPubKey()));
+    blockHeaderTree.put("issuerSignature", Hexdump::vectorToHexString(blockHeader.getIssuerSignature()));
+    blockHeaderTree.push_back(std::make_pair("payout", uamountToPtree(blockHeader.getPayout())));
+    blockHeaderTree.push_back(std::make_pair("payoutRemainder", uamountToPtree(blockHeader.getPayoutRemainder())));
+    blockHeaderTree.push_back(std::make_pair("ubiReceiverCount", uamountToPtree(blockHeader.getUbiReceiverCount())));
     ptree votesTree;
-    for(auto vote: blockHeader->getVotes()) {
+    for(auto vote: blockHeader.getVotes()) {
         votesTree.push_back(std::make_pair("", txToPtree(vote, false)));
     }
     blockHeaderTree.push_back(std::make_pair("votes", votesTree));
@@ -1212,6 +1242,27 @@ std::string Api::getIndex() {
     return ss.str();
 }
 
+std::string Api::getDBStatistics() {
+    DB& db = DB::Instance();
+
+    ptree baseTree;
+
+    for(uint8_t store = 0; store < DB_STORE_COUNT; store++) {
+        DBStoreStatistics statistics = db.getStatistics(store);
+
+        ptree storeTree;
+        storeTree.put("hits", statistics.hits);
+        storeTree.put("misses", statistics.misses);
+        storeTree.put("pendingHits", statistics.pendingHits);
+        baseTree.add_child(Config::getDBStoreName(store), storeTree);
+    }
+
+    std::stringstream ss;
+    boost::property_tree::json_parser::write_json(ss, baseTree);
+
+    return ss.str();
+}
+
 std::string Api::getRootCertificates() {
     CertStore& certStore = CertStore::Instance();
 
@@ -1238,15 +1289,15 @@ std::string Api::getCSCACertificates() {
 
     ptree baseTree;
 
-    std::map<std::vector<unsigned char>, Cert>* cscaList = certStore.getCSCAList();
+    std::map<uint160, Cert>* cscaList = certStore.getCSCAList();
 
-    for(std::map<std::vector<unsigned char>, Cert>::iterator it = cscaList->begin(); it != cscaList->end(); it++) {
+    for(std::map<uint160, Cert>::iterator it = cscaList->begin(); it != cscaList->end(); it++) {
         ptree cert;
         cert.put("active", it->second.isCertAtive());
         cert.put("currency", it->second.getCurrencyId());
         cert.put("expirationDate", it->second.getExpirationDate());
         cert.put("rootSignature", Hexdump::vectorToHexString(it->second.getRootSignature()));
-        baseTree.add_child(Hexdump::vectorToHexString(it->first), cert);
+        baseTree.add_child(Hexdump::vectorToHexString(it->first.toVector()), cert);
     }
 
     std::stringstream ss;
@@ -1296,16 +1347,16 @@ std::string Api::getDSCCertificates() {
 
     ptree baseTree;
 
-    std::unordered_map<std::string, Cert>* dscList = certStore.getDSCList();
+    std::unordered_map<uint160, Cert, BlobHasher>* dscList = certStore.getDSCList();
 
-    for(std::unordered_map<std::string, Cert>::iterator it = dscList->begin(); it != dscList->end(); it++) {
+    for(std::unordered_map<uint160, Cert, BlobHasher>::iterator it = dscList->begin(); it != dscList->end(); it++) {
         ptree cert;
         cert.push_back(std::make_pair("statusList", statusListToPtree(it->second.getStatusList())));
         cert.put("active", it->second.isCertAtive());
         cert.put("currency", it->second.getCurrencyId());
         cert.put("expirationDate", it->second.getExpirationDate());
         cert.put("rootSignature", Hexdump::vectorToHexString(it->second.getRootSignature()));
-        baseTree.add_child(it->first, cert);
+        baseTree.add_child(Hexdump::vectorToHexString(it->first.toVector()), cert);
     }
 
     std::stringstream ss;
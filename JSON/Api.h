@@ -7,6 +7,8 @@
 #include <vector>
 #include <string>
 
+#define API_BLOCK_HASHES_MAX 1000
+
 class Api {
 public:
 
@@ -35,7 +37,9 @@ public:
     static std::string getIncomingTx();
     static std::string getBlock(uint32_t blockHeight);
     static std::string getBlock(std::vector<unsigned char> blockHeaderHash);
+    static std::string getBlockHashes(uint32_t fromHeight, uint32_t toHeight);
     static std::string getIndex();
+    static std::string getDBStatistics();
     static std::string getRootCertificates();
     static std::string getCSCACertificates();
     static std::string getDSCCertificate(std::string dscIdString);
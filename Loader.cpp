@@ -8,6 +8,7 @@
 #include "Wallet.h"
 #include "Consensus/VoteStore.h"
 #include "Config.h"
+#include "DB/DB.h"
 
 bool Loader::createTouchFilesAndDirectories() {
 
@@ -50,15 +51,18 @@ bool Loader::createTouchFilesAndDirectories() {
     // DSCCounterStore.mdb
     FS::createDirectory(FS::getDSCCounterStorePath());
 
+    // BlockUndoStore.mdb
+    FS::createDirectory(FS::getBlockUndoStorePath());
+
+    // PathSumStore.mdb
+    FS::createDirectory(FS::getPathSumStorePath());
+
     // blockdat/00000000.dat
     FS::touchFile(FS::getBlockDatPath());
 
     // wallet.dat
     FS::touchFile(FS::getWalletPath());
 
-    // bestHeaders.dat
-    FS::touchFile(FS::getBestBlockHeadersPath());
-
     // headers.mdb
     FS::createDirectory(FS::getBlockHeadersPath());
 
@@ -135,17 +139,30 @@ bool Loader::loadDelegates() {
 
 bool Loader::loadBestBlockHeaders() {
     Chain& chain = Chain::Instance();
+    DB& db = DB::Instance();
 
-    uint64_t pos = 0;
-    bool eof = false;
+    std::string bestBlockHeadersKey = BEST_BLOCK_HEADERS_KEY;
     std::vector<BlockHeader> bestBlockHeaders;
-    while(!eof) {
-        BlockHeader* header = new BlockHeader();
-        if(!FS::deserializeFromFile(FS::getBestBlockHeadersPath(), BLOCK_SIZE_MAX, pos, *header, pos, eof)) {
-            break;
+    if(!db.deserializeFromDb(DB_BLOCK_HEADERS, std::vector<unsigned char>(bestBlockHeadersKey.begin(), bestBlockHeadersKey.end()), bestBlockHeaders)
+       && FS::fileExists(FS::getBestBlockHeadersPath())) {
+        // nodes that kept their best headers in bestHeaders.dat, they are moved to the DB once
+        uint64_t pos = 0;
+        bool eof = false;
+        while(!eof) {
+            BlockHeader header;
+            if(!FS::deserializeFromFile(FS::getBestBlockHeadersPath(), BLOCK_SIZE_MAX, pos, header, pos, eof)) {
+                break;
+            }
+            bestBlockHeaders.emplace_back(header);
+        }
+
+        if(!bestBlockHeaders.empty()) {
+            chain.setBestBlockHeaders(bestBlockHeaders);
+            if(!chain.persistBestBlockHeaders()) {
+                return false;
+            }
         }
-        bestBlockHeaders.emplace_back(*header);
-        chain.setCurrentBlockchainHeight(header->getBlockHeight());
+        FS::deleteFile(FS::getBestBlockHeadersPath());
     }
 
     if(bestBlockHeaders.empty()) {
@@ -154,6 +171,7 @@ bool Loader::loadBestBlockHeaders() {
     }
 
     chain.setBestBlockHeaders(bestBlockHeaders);
+    chain.setCurrentBlockchainHeight(bestBlockHeaders.back().getBlockHeight());
     Log(LOG_LEVEL_INFO) << "Loaded " << (uint64_t)bestBlockHeaders.size() << " best block header(s)";
 
     return true;
@@ -169,38 +187,41 @@ bool Loader::loadCertStore() {
     return true;
 }
 
+bool Loader::loadHeaderIndex() {
+    Chain& chain = Chain::Instance();
+
+    uint64_t headerCount = chain.loadHeaderIndex();
+    Log(LOG_LEVEL_INFO) << "Loaded " << headerCount << " block header(s) into the header index";
+
+    return true;
+}
+
 bool Loader::loadPathSum() {
     PathSum& pathSum = PathSum::Instance();
     Chain& chain = Chain::Instance();
 
-    std::map<uint64_t, UAmount> pathSumList;
+    UAmount zeroBlockAmount;
+    if(chain.getBestBlockHeader() == nullptr) {
+        // positions are block heights like on a restarted node, the genesis block has to be appended at position 1
+        pathSum.appendValue(zeroBlockAmount);
+        return true;
+    }
 
-    BlockHeader* header = chain.getBestBlockHeader();
-    if(header == nullptr) {
+    if(pathSum.loadFromDB(chain.getCurrentBlockchainHeight())) {
         return true;
     }
-    pathSumList.insert(std::pair<uint64_t, UAmount>(header->getBlockHeight(), header->getPayout()));
 
-    std::vector<unsigned char> previousHeaderHash = header->getPreviousHeaderHash();
+    // values have not been persisted before, appendValue() writes them while rebuilding
+    Log(LOG_LEVEL_INFO) << "rebuilding PathSum from the block headers";
+    pathSum.appendValue(zeroBlockAmount); // Block zero doesn't exist so we assign empty value
 
-    // first we insert values in a temporary variable as we start with last block and pathSum requires
-    // a chronological order
-    while(true) {
-        //Log(LOG_LEVEL_INFO) << "previousHeaderHash: " << previousHeaderHash;
-        BlockHeader* found = chain.getBlockHeader(previousHeaderHash);
+    // the header index holds the active chain by height, so values can be appended in chronological order directly
+    for(uint64_t height = 1; height <= chain.getCurrentBlockchainHeight(); height++) {
+        BlockHeaderIndexEntry* found = chain.getBlockHeader(height);
         if(found == nullptr) {
             break;
         }
-        //Log(LOG_LEVEL_INFO) << "Temporary inserted Payout: " << found->getPayout();
-        pathSumList.insert(std::pair<uint64_t, UAmount>(found->getBlockHeight(), found->getPayout()));
-        previousHeaderHash = found->getPreviousHeaderHash();
-    }
-
-    UAmount zeroBlockAmount;
-    pathSum.appendValue(zeroBlockAmount); // Block zero doesn't exist so we assign empty value
-    for(std::map<uint64_t, UAmount>::iterator it = pathSumList.begin(); it != pathSumList.end(); ++it) {
-        pathSum.appendValue(it->second);
-        //Log(LOG_LEVEL_INFO) << "Inserted Payout: " << it->second;
+        pathSum.appendValue(found->getPayout());
     }
 
     return true;
@@ -9,6 +9,7 @@ public:
     static bool loadConfig();
     static bool loadDelegates();
     static bool loadBestBlockHeaders();
+    static bool loadHeaderIndex();
     static bool loadCertStore();
     static bool loadPathSum();
     static bool loadWallet();
@@ -5,11 +5,12 @@
 #include <cstdint>
 #include "../Block.h"
 #include "../Chain.h"
+#include "../uint256.h"
 #include "../Tools/Log.h"
 #include "BanList.h"
 
 typedef std::string ip_t;
-typedef std::vector<unsigned char> hash_t;
+typedef uint256 hash_t;
 
 class BlockCache {
 private:
@@ -93,9 +94,10 @@ public:
 
     void appendBlock(PeerInterfacePtr from, Block* block) {
         appendBlockMutex.lock();
-        std::map<hash_t, std::pair<ip_t, Block> >::iterator cacheIt = this->cache.find(block->getHeader()->getHeaderHash());
+        hash_t headerHash(block->getHeader()->getHeaderHash());
+        std::map<hash_t, std::pair<ip_t, Block> >::iterator cacheIt = this->cache.find(headerHash);
         if(cacheIt == this->cache.end()) {
-            this->cache.insert(std::make_pair(block->getHeader()->getHeaderHash(), std::make_pair(from->getIp(), *block)));
+            this->cache.insert(std::make_pair(headerHash, std::make_pair(from->getIp(), *block)));
         }
 
         // remove entry from blockHeightAskedMap
@@ -122,7 +124,7 @@ public:
         blockHashAskedMapMutex.lock();
         auto found2 = this->blockHashAskedMap.find(from->getIp());
         if(found2 != this->blockHashAskedMap.end()) {
-            if(found2->second == block->getHeader()->getHeaderHash()) {
+            if(found2->second == headerHash) {
                 Log(LOG_LEVEL_INFO) << "removed entry from blockHashAskedMap";
                 this->blockHashAskedMap.erase(found2);
             }
@@ -130,7 +132,7 @@ public:
         blockHashAskedMapMutex.unlock();
 
         // insert entry to history
-        this->appendHistory(from->getIp(), block->getHeader()->getHeaderHash());
+        this->appendHistory(from->getIp(), headerHash);
 
         this->tryToAppendBlocksToChain();
         appendBlockMutex.unlock();
@@ -139,10 +141,14 @@ public:
     std::vector<hash_t> missingBlockHashList() {
         std::vector<hash_t> missing;
         cacheMutex.lock();
-        for(auto blockIt: cache) {
-            auto found = cache.find(blockIt.second.second.getHeader()->getPreviousHeaderHash());
+        for(auto& blockIt: cache) {
+            hash_t previousHeaderHash;
+            if(!previousHeaderHash.setFromVector(blockIt.second.second.getHeader()->getPreviousHeaderHash())) {
+                continue;
+            }
+            auto found = cache.find(previousHeaderHash);
             if(found == cache.end()) {
-                missing.emplace_back(blockIt.second.second.getHeader()->getPreviousHeaderHash());
+                missing.emplace_back(previousHeaderHash);
             }
         }
         cacheMutex.unlock();
@@ -210,6 +216,16 @@ public:
         return false;
     }
 
+    void removeFromAskedMaps(ip_t ip) {
+        blockHeightAskedMapMutex.lock();
+        this->blockHeightAskedMap.erase(ip);
+        blockHeightAskedMapMutex.unlock();
+
+        blockHashAskedMapMutex.lock();
+        this->blockHashAskedMap.erase(ip);
+        blockHashAskedMapMutex.unlock();
+    }
+
     void insertInBlockHeightAskedMap(ip_t ip, std::vector<uint32_t> blockHeight) {
         blockHeightAskedMapMutex.lock();
         this->blockHeightAskedMap.insert(std::make_pair(ip, blockHeight));
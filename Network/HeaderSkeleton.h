@@ -0,0 +1,289 @@
+
+#ifndef TX_HEADERSKELETON_H
+#define TX_HEADERSKELETON_H
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "../Block.h"
+#include "../Chain.h"
+#include "../Config.h"
+#include "../Consensus/VoteStore.h"
+#include "../uint256.h"
+#include "../Tools/Log.h"
+
+// the skeleton is a sliding window of validated headers ahead of the chain tip, it never holds more than this
+#define HEADERS_FIRST_LOOKAHEAD 5000
+
+/**
+ * Validated headers above our chain tip, downloaded ahead of the block bodies during headers-first sync.
+ * Bodies received for a height covered by the skeleton are only accepted if they match its header hash,
+ * so no bandwidth is spent on blocks belonging to another fork.
+ */
+class HeaderSkeleton {
+private:
+    std::mutex skeletonMutex;
+    std::map<uint32_t, BlockHeader> headers; // height -> header
+
+    // hashes of the assume-valid block and its ancestors, assumeValidChain[i] is the hash at the assume-valid height - i
+    std::vector<uint256> assumeValidChain;
+    uint256 assumeValidChainNext; // hash the header below the lowest one in assumeValidChain has to have
+
+    /**
+     * headers above the chain tip are superseded once the corresponding blocks are connected
+     * a skeleton disagreeing with the connected blocks belongs to another fork and is dropped entirely
+     */
+    void pruneConnected() {
+        Chain& chain = Chain::Instance();
+        uint32_t currentBlockchainHeight = chain.getCurrentBlockchainHeight();
+
+        bool contradicts = false;
+        for(auto it = this->headers.begin(); it != this->headers.end() && it->first <= currentBlockchainHeight; it++) {
+            BlockHeaderIndexEntry* connected = chain.getBlockHeader((uint64_t)it->first);
+            if(connected == nullptr || connected->getHeaderHash() != it->second.getHeaderHash()) {
+                contradicts = true;
+                break;
+            }
+        }
+
+        auto next = this->headers.find(currentBlockchainHeight + 1);
+        BlockHeaderIndexEntry* tip = chain.getBlockHeader((uint64_t)currentBlockchainHeight);
+        if(next != this->headers.end() && tip != nullptr && next->second.getPreviousHeaderHash() != tip->getHeaderHash()) {
+            contradicts = true;
+        }
+
+        if(contradicts) {
+            Log(LOG_LEVEL_INFO) << "header skeleton contradicts the connected blocks, dropping it";
+            this->headers.clear();
+            return;
+        }
+
+        this->headers.erase(this->headers.begin(), this->headers.upper_bound(currentBlockchainHeight));
+    }
+public:
+    static HeaderSkeleton& Instance(){
+        static HeaderSkeleton instance;
+        return instance;
+    }
+
+    /**
+     * Appends a continuous range of headers, the first one has to link to the skeleton or to our active chain
+     * Returns false if one of the headers is invalid, headers before the invalid one are kept
+     */
+    bool appendHeaders(std::vector<BlockHeader> newHeaders) {
+        Chain& chain = Chain::Instance();
+        VoteStore& voteStore = VoteStore::Instance();
+
+        skeletonMutex.lock();
+        this->pruneConnected();
+        uint32_t currentBlockchainHeight = chain.getCurrentBlockchainHeight();
+
+        for(BlockHeader& header : newHeaders) {
+            uint32_t height = header.getBlockHeight();
+
+            if(height <= currentBlockchainHeight) {
+                continue;
+            }
+
+            if(height > currentBlockchainHeight + HEADERS_FIRST_LOOKAHEAD) {
+                // the window moves up as blocks are connected, the rest is asked for again then
+                break;
+            }
+
+            auto known = this->headers.find(height);
+            if(known != this->headers.end()) {
+                if(known->second.getHeaderHash() == header.getHeaderHash()) {
+                    continue;
+                }
+
+                // keep the first skeleton, it is cleared if its bodies can't be obtained
+                Log(LOG_LEVEL_INFO) << "header skeleton: competing header " << header.getHeaderHash() << " at height " << height;
+                skeletonMutex.unlock();
+                return true;
+            }
+
+            BlockHeader* previousBlockHeader = nullptr;
+            BlockHeader connectedPreviousBlockHeader;
+            auto previous = this->headers.find(height - 1);
+            if(previous != this->headers.end()) {
+                previousBlockHeader = &previous->second;
+            } else if(height > 1) {
+                // only the first header of a range links to the active chain
+                if(chain.readBlockHeader(height - 1, connectedPreviousBlockHeader)) {
+                    previousBlockHeader = &connectedPreviousBlockHeader;
+                } else {
+                    Log(LOG_LEVEL_INFO) << "header skeleton: no previous header for height " << height;
+                    skeletonMutex.unlock();
+                    return true;
+                }
+            }
+
+            if(previousBlockHeader != nullptr && header.getPreviousHeaderHash() != previousBlockHeader->getHeaderHash()) {
+                // the peer is on another fork, not necessarily invalid, the legacy sync will resolve it
+                Log(LOG_LEVEL_INFO) << "header skeleton: header " << header.getHeaderHash() << " is on another fork";
+                skeletonMutex.unlock();
+                return true;
+            }
+
+            if(!BlockHelper::verifyBlockHeader(&header, previousBlockHeader)) {
+                skeletonMutex.unlock();
+                return false;
+            }
+
+            // anybody can sign a header, only the ones of delegates can end up in the chain
+            // right above our tip the issuer schedule is known, it is the one verifyBlock() enforces
+            if(height == currentBlockchainHeight + 1 && !voteStore.getActiveDelegates().empty()
+               && header.getIssuerPubKey() != voteStore.getValidatorForTimestamp(header.getTimestamp())) {
+                Log(LOG_LEVEL_ERROR) << "header skeleton: header " << header.getHeaderHash() << " wasn't issued by the scheduled delegate";
+                skeletonMutex.unlock();
+                return false;
+            }
+
+            // further up a delegate might have been voted in by blocks we don't have yet, the bodies are then fetched without skeleton
+            if(!voteStore.isKnownDelegate(header.getIssuerPubKey())) {
+                Log(LOG_LEVEL_INFO) << "header skeleton: issuer of header " << header.getHeaderHash() << " isn't a known delegate";
+                skeletonMutex.unlock();
+                return true;
+            }
+
+            this->headers.insert(std::make_pair(height, header));
+        }
+
+        skeletonMutex.unlock();
+        return true;
+    }
+
+    /**
+     * Height of the last validated header, or our chain height if the skeleton is empty
+     */
+    uint32_t getHeight() {
+        Chain& chain = Chain::Instance();
+
+        skeletonMutex.lock();
+        this->pruneConnected();
+        uint32_t height = this->headers.empty() ? chain.getCurrentBlockchainHeight() : this->headers.rbegin()->first;
+        skeletonMutex.unlock();
+
+        return height;
+    }
+
+    /**
+     * Returns false if the skeleton has another header at the height of the given one
+     */
+    bool matchesSkeleton(BlockHeader* header) {
+        skeletonMutex.lock();
+        auto found = this->headers.find(header->getBlockHeight());
+        bool matches = found == this->headers.end() || found->second.getHeaderHash() == header->getHeaderHash();
+        skeletonMutex.unlock();
+
+        return matches;
+    }
+
+    /**
+     * Heights between our chain tip and the lowest known ancestor of the assume-valid block, at most maxCount of them below that ancestor
+     * Returns false if there are none, assume-valid is disabled or our chain is past the assume-valid block
+     */
+    bool getMissingAssumeValidHeaders(uint32_t maxCount, uint32_t &startBlockHeight, uint32_t &count) {
+        Config& config = Config::Instance();
+        Chain& chain = Chain::Instance();
+        uint32_t assumeValidBlockHeight = config.getAssumeValidBlockHeight();
+        uint32_t currentBlockchainHeight = chain.getCurrentBlockchainHeight();
+
+        if(config.getAssumeValidBlockHash().empty() || assumeValidBlockHeight <= currentBlockchainHeight) {
+            return false;
+        }
+
+        skeletonMutex.lock();
+        uint32_t lowest = assumeValidBlockHeight + 1 - (uint32_t)this->assumeValidChain.size();
+        skeletonMutex.unlock();
+
+        if(lowest <= currentBlockchainHeight + 1) {
+            return false;
+        }
+
+        startBlockHeight = std::max(currentBlockchainHeight + 1, lowest > maxCount ? lowest - maxCount : 1);
+        count = lowest - startBlockHeight;
+        return true;
+    }
+
+    /**
+     * Extends the assume-valid chain downwards, starting with the configured assume-valid hash
+     * A header is only taken if it hashes to the previous hash of the one above it, so the chain can't hold anything
+     * but the history of the assume-valid block. Unlike the skeleton it needs neither the delegates nor a window,
+     * only 32 bytes per block are kept. Headers of other chains are ignored.
+     */
+    void appendAssumeValidHeaders(std::vector<BlockHeader>& newHeaders) {
+        Config& config = Config::Instance();
+        uint32_t assumeValidBlockHeight = config.getAssumeValidBlockHeight();
+
+        skeletonMutex.lock();
+        if(this->assumeValidChain.empty() && !this->assumeValidChainNext.setFromVector(config.getAssumeValidBlockHash())) {
+            skeletonMutex.unlock();
+            return;
+        }
+
+        // headers are transmitted by ascending height, the chain grows downwards
+        for(auto it = newHeaders.rbegin(); it != newHeaders.rend(); it++) {
+            uint32_t lowest = assumeValidBlockHeight + 1 - (uint32_t)this->assumeValidChain.size();
+            if(it->getBlockHeight() >= lowest) {
+                continue;
+            }
+
+            if(lowest <= 1 || it->getBlockHeight() != lowest - 1) {
+                break;
+            }
+
+            uint256 hash;
+            if(!hash.setFromVector(BlockHelper::computeBlockHeaderHash(*it)) || hash != this->assumeValidChainNext) {
+                break;
+            }
+
+            this->assumeValidChain.emplace_back(hash);
+
+            // the genesis block has no previous hash, the chain is complete with it
+            this->assumeValidChainNext.setFromVector(it->getPreviousHeaderHash());
+        }
+        skeletonMutex.unlock();
+    }
+
+    /**
+     * Returns true if the given header is the block with descendantHash or one of its ancestors fetched so far
+     */
+    bool isAncestorOf(BlockHeader* header, std::vector<unsigned char> descendantHash, uint32_t descendantHeight) {
+        uint32_t height = header->getBlockHeight();
+        uint256 hash;
+        uint256 descendant;
+        if(height > descendantHeight || !hash.setFromVector(header->getHeaderHash()) || !descendant.setFromVector(descendantHash)) {
+            return false;
+        }
+
+        skeletonMutex.lock();
+        size_t index = descendantHeight - height;
+        bool isAncestor = index < this->assumeValidChain.size()
+                          && this->assumeValidChain.front() == descendant
+                          && this->assumeValidChain[index] == hash;
+        skeletonMutex.unlock();
+
+        return isAncestor;
+    }
+
+    /**
+     * Once our chain is past the assume-valid block its ancestors aren't needed anymore
+     */
+    void clearAssumeValidChain() {
+        skeletonMutex.lock();
+        std::vector<uint256>().swap(this->assumeValidChain);
+        skeletonMutex.unlock();
+    }
+
+    void clear() {
+        skeletonMutex.lock();
+        this->headers.clear();
+        skeletonMutex.unlock();
+    }
+};
+
+
+#endif //TX_HEADERSKELETON_H
@@ -3,8 +3,10 @@
 #include "Network.h"
 #include "../TxPool.h"
 #include "../Chain.h"
+#include "../Config.h"
 #include "Peers.h"
 #include "BlockCache.h"
+#include "HeaderSkeleton.h"
 #include "NetworkCommands.h"
 #include "../Time.h"
 #include <boost/asio/ssl.hpp>
@@ -14,6 +16,8 @@ bool Network::synced = false;
 bool Network::isSyncing = false;
 ip_t Network::myIP = "";
 uint64_t Network::lastPeerLookup = 0;
+std::mutex Network::blockHeadersMutex;
+std::condition_variable Network::blockHeadersCondition;
 
 using namespace boost::asio;
 
@@ -260,13 +264,33 @@ void Network::syncBlockchain() {
 
     Log(LOG_LEVEL_INFO) << "Network start syncing";
     Chain &chain = Chain::Instance();
+    HeaderSkeleton &headerSkeleton = HeaderSkeleton::Instance();
 
     uint32_t currentBlockHeight;
     uint16_t batchSize = 100;
 
     while(!synced) {
         currentBlockHeight = chain.getCurrentBlockchainHeight() + 1;
+
+        // the blocks below the assume-valid block are recognized by their hashes, fetch them before the bodies
+        Network::getAssumeValidHeaders();
+
+        // headers-first, validate the headers ahead of the bodies so only bodies of that chain are accepted
+        if(headerSkeleton.getHeight() < currentBlockHeight + batchSize) {
+            Network::getBlockHeaders(chain.getCurrentBlockchainHeight() + HEADERS_FIRST_LOOKAHEAD);
+        }
+
         Network::getBlocks(currentBlockHeight, batchSize, synced);
+
+        if(chain.getCurrentBlockchainHeight() < currentBlockHeight) {
+            // none of the skeleton's blocks could be connected, it belongs to a dead fork or a dishonest peer
+            headerSkeleton.clear();
+        }
+    }
+    headerSkeleton.clear();
+    Config& config = Config::Instance();
+    if(chain.getCurrentBlockchainHeight() >= config.getAssumeValidBlockHeight()) {
+        headerSkeleton.clearAssumeValidChain();
     }
     Log(LOG_LEVEL_INFO) << "Node is synced";
 
@@ -286,10 +310,133 @@ void Network::askForBlockchainHeight(PeerInterfacePtr peer) {
     peer->deliver(NetworkMessageHelper::serializeToNetworkMessage(askForBlockchainHeight));
 }
 
+/**
+ * Asks the peer for count headers starting at startBlockHeight and waits up to 5 seconds for its answer
+ * Peers that leave a request for headers unanswered run an older version, they are not asked for headers again
+ */
+bool Network::askForBlockHeaders(PeerInterfacePtr peer, uint32_t startBlockHeight, uint32_t count) {
+    AskForBlockHeaders askForBlockHeaders;
+    askForBlockHeaders.startBlockHeight = startBlockHeight;
+    askForBlockHeaders.count = count;
+
+    // set again by setBlockHeadersAnswered() once the peer answers
+    peer->setSupportsBlockHeaders(false);
+    peer->deliver(NetworkMessageHelper::serializeToNetworkMessage(askForBlockHeaders));
+
+    Log(LOG_LEVEL_INFO) << "asked " << peer->getIp() << " for headers, start:" << startBlockHeight;
+
+    std::unique_lock<std::mutex> lock(blockHeadersMutex);
+    bool answered = blockHeadersCondition.wait_for(lock, std::chrono::seconds(5), [peer] {
+        return peer->getSupportsBlockHeaders();
+    });
+    lock.unlock();
+
+    if(!answered) {
+        Log(LOG_LEVEL_INFO) << "peer " << peer->getIp() << " doesn't answer requests for headers, it won't be asked again";
+    }
+
+    return answered;
+}
+
+/**
+ * Called once the peer's headers have been appended, wakes up askForBlockHeaders()
+ */
+void Network::setBlockHeadersAnswered(PeerInterfacePtr peer) {
+    blockHeadersMutex.lock();
+    peer->setSupportsBlockHeaders(true);
+    blockHeadersMutex.unlock();
+
+    blockHeadersCondition.notify_all();
+}
+
+/**
+ * Extends the header skeleton until it reaches the given height or the height of our peers
+ */
+void Network::getBlockHeaders(uint32_t until) {
+    Peers &peers = Peers::Instance();
+    HeaderSkeleton &headerSkeleton = HeaderSkeleton::Instance();
+    uint8_t stalls = 0;
+
+    while(stalls < 3) {
+        uint32_t skeletonHeight = headerSkeleton.getHeight();
+        if(skeletonHeight >= until) {
+            return;
+        }
+
+        PeerInterfacePtr bestPeer = nullptr;
+        for(PeerInterfacePtr peer : peers.getRandomPeers(6)) {
+            if(peer->getSupportsBlockHeaders()
+               && peer->getBlockHeight() > skeletonHeight
+               && (bestPeer == nullptr || peer->getBlockHeight() > bestPeer->getBlockHeight())) {
+                bestPeer = peer;
+            }
+        }
+
+        if(bestPeer == nullptr) {
+            return;
+        }
+
+        Network::askForBlockHeaders(bestPeer, skeletonHeight + 1, MAX_BLOCK_HEADERS_PER_MESSAGE);
+
+        // headers the skeleton can't take, from another fork or a delegate it doesn't know yet, don't extend it either
+        if(headerSkeleton.getHeight() <= skeletonHeight) {
+            stalls++;
+        }
+    }
+
+    Log(LOG_LEVEL_INFO) << "header skeleton stalled at height " << headerSkeleton.getHeight();
+}
+
+/**
+ * Fetches the ancestors of the assume-valid block down to our chain tip, see HeaderSkeleton::appendAssumeValidHeaders()
+ * A reply is cut when it gets too big, the range asked for is halved until the header linking to the known ones is part of it
+ */
+void Network::getAssumeValidHeaders() {
+    Peers &peers = Peers::Instance();
+    HeaderSkeleton &headerSkeleton = HeaderSkeleton::Instance();
+    uint32_t maxCount = MAX_BLOCK_HEADERS_PER_MESSAGE;
+    uint32_t startBlockHeight;
+    uint32_t count;
+    uint8_t stalls = 0;
+
+    while(stalls < 3 && headerSkeleton.getMissingAssumeValidHeaders(maxCount, startBlockHeight, count)) {
+        uint32_t missingUntil = startBlockHeight + count;
+
+        PeerInterfacePtr bestPeer = nullptr;
+        for(PeerInterfacePtr peer : peers.getRandomPeers(6)) {
+            if(peer->getSupportsBlockHeaders()
+               && peer->getBlockHeight() >= missingUntil
+               && (bestPeer == nullptr || peer->getBlockHeight() > bestPeer->getBlockHeight())) {
+                bestPeer = peer;
+            }
+        }
+
+        if(bestPeer == nullptr) {
+            return;
+        }
+
+        bool answered = Network::askForBlockHeaders(bestPeer, startBlockHeight, count);
+
+        uint32_t newStartBlockHeight;
+        uint32_t newCount;
+        if(headerSkeleton.getMissingAssumeValidHeaders(maxCount, newStartBlockHeight, newCount)
+           && newStartBlockHeight + newCount >= missingUntil) {
+            if(answered && maxCount > 1) {
+                maxCount = maxCount / 2;
+            } else {
+                stalls++;
+            }
+        } else {
+            maxCount = MAX_BLOCK_HEADERS_PER_MESSAGE;
+            stalls = 0;
+        }
+    }
+}
+
 void Network::getBlocks(uint32_t from, uint16_t count, bool &synced) {
     synced = false;
     std::vector<uint32_t> neededBlockHeightList;
-    std::vector< std::vector<unsigned char> > neededBlockHashList;
+    std::vector<hash_t> neededBlockHashList;
 
     // make needed block list
     for(uint32_t i = from; i < from + count; i++) {
@@ -349,7 +496,8 @@ void Network::getBlocks(uint32_t from, uint16_t count, bool &synced) {
                             }
                             askForBlocks.count = peerBatch;
 
-                            if(peer->getBlockHeight() >= askForBlocks.startBlockHeight + askForBlocks.count) {
+                            if(peer->getBlockHeight() >= askForBlocks.startBlockHeight + askForBlocks.count
+                               && peer->getLowestServedBlockHeight() <= askForBlocks.startBlockHeight) {
                                 std::thread t0(&Network::askForBlocks, peer, askForBlocks);
                                 t0.detach();
                                 std::vector<uint32_t> blockHeightVector;
@@ -377,7 +525,8 @@ void Network::getBlocks(uint32_t from, uint16_t count, bool &synced) {
                     uint32_t blockNbr = 0;
                     for (uint32_t blockHeight : neededBlockHeightList) {
 
-                        if (unbusyPeerNbr == blockNbr && peer->getBlockHeight() >= blockHeight) {
+                        if (unbusyPeerNbr == blockNbr && peer->getBlockHeight() >= blockHeight
+                            && peer->getLowestServedBlockHeight() <= blockHeight) {
                             AskForBlocks askForBlocks;
                             askForBlocks.startBlockHeight = blockHeight;
                             askForBlocks.count = 1;
@@ -403,10 +552,10 @@ void Network::getBlocks(uint32_t from, uint16_t count, bool &synced) {
                 if(!skip) {
                     // check for missing blocks by hash
                     uint32_t blockNbr = 0;
-                    for (std::vector<unsigned char>& blockHeaderHash : blockCache.missingBlockHashList()) {
+                    for (hash_t& blockHeaderHash : blockCache.missingBlockHashList()) {
                         if (unbusyPeerNbr == blockNbr) {
                             AskForBlock askForBlock;
-                            askForBlock.blockHeaderHash = blockHeaderHash;
+                            askForBlock.blockHeaderHash = blockHeaderHash.toVector();
                             std::thread t3(&Network::askForBlock, peer, askForBlock);
                             t3.detach();
                             blockCache.insertInBlockHashAskedMap(peer->getIp(), blockHeaderHash);
@@ -2,6 +2,8 @@
 #ifndef TX_NETWORK_H
 #define TX_NETWORK_H
 
+#include <condition_variable>
+#include <mutex>
 #include <vector>
 #include "../Transaction/Transaction.h"
 #include "../Block.h"
@@ -12,6 +14,8 @@ typedef std::string ip_t;
 
 class Network {
 private:
+    static std::mutex blockHeadersMutex;
+    static std::condition_variable blockHeadersCondition; // notified when a peer answers a request for headers
 public:
     static bool synced;
     static uint64_t lastPeerLookup;
@@ -30,6 +34,10 @@ public:
     static void askForBlocks(PeerInterfacePtr peer, AskForBlocks askForBlocks);
     static void askForBlock(PeerInterfacePtr peer, AskForBlock askForBlock);
     static void askForBlockchainHeight(PeerInterfacePtr peer);
+    static bool askForBlockHeaders(PeerInterfacePtr peer, uint32_t startBlockHeight, uint32_t count);
+    static void setBlockHeadersAnswered(PeerInterfacePtr peer);
+    void getBlockHeaders(uint32_t until);
+    void getAssumeValidHeaders();
     void getBlocks(uint32_t from, uint16_t count, bool &synced);
     void getBlock(std::vector<unsigned char> blockHeaderHash, uint64_t height);
     static void broadCastNewBlockHeight(uint64_t height, std::vector<unsigned char> bestHeaderHash);
@@ -10,6 +10,7 @@
 #define ASK_FOR_VERSION_COMMAND 0x06
 #define ASK_FOR_STATUS_COMMAND 0x07
 #define ASK_FOR_DONATION_ADDRESS_COMMAND 0x08
+#define ASK_FOR_BLOCK_HEADERS_COMMAND 0x09
 #define TRANSMIT_TRANSACTIONS_COMMAND 0x11
 #define TRANSMIT_BLOCKS_COMMAND 0x12
 #define TRANSMIT_PEERS_COMMAND 0x13
@@ -19,6 +20,10 @@
 #define TRANSMIT_STATUS_COMMAND 0x17
 #define TRANSMIT_LEAVE_COMMAND 0x18
 #define TRANSMIT_DONATION_ADDRESS_COMMAND 0x19
+#define TRANSMIT_BLOCK_HEADERS_COMMAND 0x1a
+#define TRANSMIT_SERVED_BLOCK_RANGE_COMMAND 0x1b
+
+#define MAX_BLOCK_HEADERS_PER_MESSAGE 500
 
 #include <cstdint>
 #include <vector>
@@ -54,6 +59,21 @@ struct AskForBlock {
     }
 };
 
+struct AskForBlockHeaders {
+    uint8_t command = ASK_FOR_BLOCK_HEADERS_COMMAND;
+    uint64_t startBlockHeight;
+    uint64_t count;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(command);
+        READWRITE(startBlockHeight);
+        READWRITE(count);
+    }
+};
+
 struct AskForPeers {
     uint8_t command = ASK_FOR_PEERS_COMMAND;
 
@@ -146,6 +166,19 @@ struct TransmitBlock {
     }
 };
 
+struct TransmitBlockHeaders {
+    uint8_t command = TRANSMIT_BLOCK_HEADERS_COMMAND;
+    std::vector<BlockHeader> headers;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(command);
+        READWRITE(headers);
+    }
+};
+
 struct TransmitPeers {
     uint8_t command = TRANSMIT_PEERS_COMMAND;
     std::vector<std::string> ipList;
@@ -187,6 +220,24 @@ struct TransmitBestBlockHeader {
     }
 };
 
+/**
+ * Sent instead of blocks that have been pruned, tells the peer from which height on it can ask us
+ */
+struct TransmitServedBlockRange {
+    uint8_t command = TRANSMIT_SERVED_BLOCK_RANGE_COMMAND;
+    uint64_t lowestBlockHeight;
+    uint64_t highestBlockHeight;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(command);
+        READWRITE(lowestBlockHeight);
+        READWRITE(highestBlockHeight);
+    }
+};
+
 struct TransmitVersion {
     uint8_t command = TRANSMIT_VERSION_COMMAND;
     uint16_t version;
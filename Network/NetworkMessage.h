@@ -129,6 +129,10 @@ public:
     virtual void setDonationAddress(std::string donationAddress) = 0;
     virtual uint64_t getLastAsked() = 0;
     virtual void setLastAsked(uint64_t lastAsked) = 0;
+    virtual uint64_t getLowestServedBlockHeight() = 0;
+    virtual void setLowestServedBlockHeight(uint64_t lowestServedBlockHeight) = 0;
+    virtual bool getSupportsBlockHeaders() = 0;
+    virtual void setSupportsBlockHeaders(bool supportsBlockHeaders) = 0;
 };
 
 
@@ -3,6 +3,8 @@
 #include "../Tools/Log.h"
 #include "NetworkMessageHandler.h"
 #include "BlockCache.h"
+#include "HeaderSkeleton.h"
+#include "RawBlockCache.h"
 #include "../TxPool.h"
 #include "../BlockStore.h"
 #include "Network.h"
@@ -51,6 +53,19 @@ void NetworkMessageHandler::handleNetworkMessage(NetworkMessage *networkMessage,
             free(askForBlock);
             break;
         }
+        case ASK_FOR_BLOCK_HEADERS_COMMAND: {
+            AskForBlockHeaders *askForBlockHeaders = new AskForBlockHeaders();
+            try {
+                s >> *askForBlockHeaders;
+                NetworkMessageHandler::handleAskForBlockHeaders(askForBlockHeaders, recipient);
+            } catch (const std::exception& e) {
+                Log(LOG_LEVEL_ERROR) << "Error while deserializing ASK_FOR_BLOCK_HEADERS_COMMAND from peer: " << recipient->getIp()
+                                     << " terminated with exception: " << e.what();
+                banList.appendBan(recipient->getIp(), BAN_INC_FOR_INVALID_MESSAGE);
+            }
+            delete askForBlockHeaders;
+            break;
+        }
         case ASK_FOR_PEERS_COMMAND: {
             AskForPeers *askForPeers = new AskForPeers();
             try {
@@ -108,6 +123,32 @@ void NetworkMessageHandler::handleNetworkMessage(NetworkMessage *networkMessage,
             delete transmitBlocks;
             break;
         }
+        case TRANSMIT_BLOCK_HEADERS_COMMAND: {
+            TransmitBlockHeaders *transmitBlockHeaders = new TransmitBlockHeaders();
+            try {
+                s >> *transmitBlockHeaders;
+                NetworkMessageHandler::handleTransmitBlockHeaders(transmitBlockHeaders, recipient);
+            } catch (const std::exception& e) {
+                Log(LOG_LEVEL_ERROR) << "Error while deserializing TRANSMIT_BLOCK_HEADERS_COMMAND from peer: " << recipient->getIp()
+                                     << " terminated with exception: " << e.what();
+                banList.appendBan(recipient->getIp(), BAN_INC_FOR_INVALID_MESSAGE);
+            }
+            delete transmitBlockHeaders;
+            break;
+        }
+        case TRANSMIT_SERVED_BLOCK_RANGE_COMMAND: {
+            TransmitServedBlockRange *transmitServedBlockRange = new TransmitServedBlockRange();
+            try {
+                s >> *transmitServedBlockRange;
+                NetworkMessageHandler::handleTransmitServedBlockRange(transmitServedBlockRange, recipient);
+            } catch (const std::exception& e) {
+                Log(LOG_LEVEL_ERROR) << "Error while deserializing TRANSMIT_SERVED_BLOCK_RANGE_COMMAND from peer: " << recipient->getIp()
+                                     << " terminated with exception: " << e.what();
+                banList.appendBan(recipient->getIp(), BAN_INC_FOR_INVALID_MESSAGE);
+            }
+            delete transmitServedBlockRange;
+            break;
+        }
         case TRANSMIT_PEERS_COMMAND: {
             TransmitPeers *transmitPeers = new TransmitPeers();
             try {
@@ -193,74 +234,190 @@ void NetworkMessageHandler::handleNetworkMessage(NetworkMessage *networkMessage,
     delete networkMessage;
 }
 
-void NetworkMessageHandler::handleAskForBlocks(AskForBlocks *askForBlocks, PeerInterfacePtr recipient) {
+/**
+ * Builds the body of a TransmitBlock message straight from the blockdat mapping
+ * It has the same bytes as a serialized TransmitBlock without copying the block into a TransmitBlock first
+ */
+RawBlockMessagePtr NetworkMessageHandler::loadTransmitBlockBody(std::vector<unsigned char> blockHeaderHash) {
+    RawBlockView view;
+    if(!BlockStore::getRawBlockView(blockHeaderHash, view)) {
+        return nullptr;
+    }
+
+    CDataStream s(SER_DISK, 1);
+    uint8_t command = TRANSMIT_BLOCKS_COMMAND;
+    s << command;
+    WriteCompactSize(s, view.size);
+
+    if(s.size() + view.size > NetworkMessage::max_body_length) {
+        Log(LOG_LEVEL_ERROR) << "Block " << blockHeaderHash << " doesn't fit in a network message";
+        return nullptr;
+    }
+
+    std::shared_ptr<std::vector<unsigned char> > body = std::make_shared<std::vector<unsigned char> >();
+    body->reserve(s.size() + view.size);
+    body->insert(body->end(), s.begin(), s.end());
+    body->insert(body->end(), view.data, view.data + view.size);
+
+    return body;
+}
 
+RawBlockMessagePtr NetworkMessageHandler::getTransmitBlockBody(std::vector<unsigned char> blockHeaderHash) {
+    RawBlockCache& rawBlockCache = RawBlockCache::Instance();
+
+    // the hash was sent by a peer, it can have any length
+    uint256 headerHash;
+    if(!headerHash.setFromVector(blockHeaderHash)) {
+        return nullptr;
+    }
+
+    RawBlockMessagePtr body = rawBlockCache.get(headerHash);
+    if(body == nullptr) {
+        body = loadTransmitBlockBody(blockHeaderHash);
+        if(body != nullptr) {
+            rawBlockCache.insert(headerHash, body);
+        }
+    }
+
+    return body;
+}
+
+RawBlockMessagePtr NetworkMessageHandler::getTransmitBlockBody(uint64_t blockHeight) {
+    RawBlockCache& rawBlockCache = RawBlockCache::Instance();
     Chain &chain = Chain::Instance();
-    BlockStore *blockStore = new BlockStore();
 
-    uint64_t startBlockHeight = askForBlocks->startBlockHeight;
-    uint64_t endBlockHeight = startBlockHeight + (askForBlocks->count - 1);
+    RawBlockMessagePtr body = rawBlockCache.get(blockHeight);
+    if(body != nullptr) {
+        return body;
+    }
 
+    uint64_t generation = rawBlockCache.getGeneration();
+    BlockHeaderIndexEntry* blockHeader = chain.getBlockHeader(blockHeight);
+    if(blockHeader == nullptr) {
+        return nullptr;
+    }
 
-    Log(LOG_LEVEL_INFO) << "Peer asked for " << askForBlocks->count << " starting from " << askForBlocks->startBlockHeight;
+    uint256 headerHash(blockHeader->getHeaderHash());
+    body = rawBlockCache.get(headerHash);
+    if(body == nullptr) {
+        body = loadTransmitBlockBody(blockHeader->getHeaderHash());
+    }
+    if(body != nullptr) {
+        rawBlockCache.insert(headerHash, blockHeight, generation, body);
+    }
 
-    for(uint64_t blockHeight = startBlockHeight; blockHeight <= endBlockHeight; blockHeight++) {
+    return body;
+}
 
-        TransmitBlock* transmitBlock = new TransmitBlock();
-        BlockHeader* blockHeader = chain.getBlockHeader(blockHeight);
+void NetworkMessageHandler::deliverTransmitBlockBody(RawBlockMessagePtr body, PeerInterfacePtr recipient) {
+    NetworkMessage msg;
+    msg.body_length((uint32_t)body->size());
+    std::memcpy(msg.body(), body->data(), body->size());
+    msg.encode_header();
+
+    recipient->deliver(msg);
+}
 
-        if(blockHeader != nullptr) {
+/**
+ * Tells a peer that asked for pruned blocks which heights we still have
+ */
+void NetworkMessageHandler::transmitServedBlockRange(PeerInterfacePtr recipient) {
+    Chain &chain = Chain::Instance();
 
-            std::vector<unsigned char> headerHash = blockHeader->getHeaderHash();
-            transmitBlock->block = blockStore->getRawBlockVector(headerHash);
+    TransmitServedBlockRange transmitServedBlockRange;
+    transmitServedBlockRange.lowestBlockHeight = BlockStore::getLowestServedBlockHeight();
+    transmitServedBlockRange.highestBlockHeight = chain.getCurrentBlockchainHeight();
 
-            CDataStream s(SER_DISK, 1);
-            s << *transmitBlock;
+    CDataStream s(SER_DISK, 1);
+    s << transmitServedBlockRange;
 
-            NetworkMessage msg;
-            msg.body_length(s.size());
-            std::memcpy(msg.body(), s.data(), s.size());
-            s.clear();
-            msg.encode_header();
+    NetworkMessage msg;
+    msg.body_length(s.size());
+    std::memcpy(msg.body(), s.data(), s.size());
+    msg.encode_header();
 
-            recipient->deliver(msg);
+    recipient->deliver(msg);
+}
+
+void NetworkMessageHandler::handleAskForBlocks(AskForBlocks *askForBlocks, PeerInterfacePtr recipient) {
+
+    uint64_t startBlockHeight = askForBlocks->startBlockHeight;
+    uint64_t endBlockHeight = startBlockHeight + (askForBlocks->count - 1);
+
+
+    Log(LOG_LEVEL_INFO) << "Peer asked for " << askForBlocks->count << " starting from " << askForBlocks->startBlockHeight;
+
+    if(startBlockHeight < BlockStore::getLowestServedBlockHeight()) {
+        Log(LOG_LEVEL_INFO) << "Peer asked for pruned blocks";
+        transmitServedBlockRange(recipient);
+        return;
+    }
+
+    for(uint64_t blockHeight = startBlockHeight; blockHeight <= endBlockHeight; blockHeight++) {
+
+        RawBlockMessagePtr body = getTransmitBlockBody(blockHeight);
+
+        if(body != nullptr) {
+            deliverTransmitBlockBody(body, recipient);
         }
     }
 }
 
 void NetworkMessageHandler::handleAskForBlock(AskForBlock *askForBlock, PeerInterfacePtr recipient) {
 
-    BlockStore* blockStore = new BlockStore();
-
-    TransmitBlock* transmitBlock = new TransmitBlock();
+    RawBlockMessagePtr body;
 
     if(askForBlock->blockHeaderHash.size() > 0) {
         Log(LOG_LEVEL_INFO) << "Peer asked for Block with hash" << askForBlock->blockHeaderHash;
-        transmitBlock->block = blockStore->getRawBlockVector(askForBlock->blockHeaderHash);
+        body = getTransmitBlockBody(askForBlock->blockHeaderHash);
     } else {
-        Chain &chain = Chain::Instance();
         Log(LOG_LEVEL_INFO) << "Peer asked for Block with height" << askForBlock->blockHeight;
-        BlockHeader* blockHeader = chain.getBlockHeader(askForBlock->blockHeight);
-        if(blockHeader != nullptr) {
-            std::vector<unsigned char> headerHash = blockHeader->getHeaderHash();
-            transmitBlock->block = blockStore->getRawBlockVector(headerHash);
+        if(askForBlock->blockHeight < BlockStore::getLowestServedBlockHeight()) {
+            transmitServedBlockRange(recipient);
+            return;
         }
+        body = getTransmitBlockBody(askForBlock->blockHeight);
     }
 
-    if(transmitBlock->block.size() <= 0) {
+    if(body == nullptr) {
         Log(LOG_LEVEL_INFO) << "Peer asked for Block that couldn't be located";
         return;
     }
 
-    CDataStream s(SER_DISK, 1);
-    s << *transmitBlock;
+    deliverTransmitBlockBody(body, recipient);
+}
 
-    NetworkMessage msg;
-    msg.body_length(s.size());
-    std::memcpy(msg.body(), s.data(), msg.body_length());
-    msg.encode_header();
+void NetworkMessageHandler::handleAskForBlockHeaders(AskForBlockHeaders *askForBlockHeaders, PeerInterfacePtr recipient) {
+    Chain &chain = Chain::Instance();
 
-    recipient->deliver(msg);
+    uint64_t count = std::min(askForBlockHeaders->count, (uint64_t)MAX_BLOCK_HEADERS_PER_MESSAGE);
+    uint64_t endBlockHeight = askForBlockHeaders->startBlockHeight + count;
+    size_t messageSize = 0;
+
+    Log(LOG_LEVEL_INFO) << "Peer asked for " << count << " headers starting from " << askForBlockHeaders->startBlockHeight;
+
+    TransmitBlockHeaders transmitBlockHeaders;
+    for(uint64_t blockHeight = askForBlockHeaders->startBlockHeight; blockHeight < endBlockHeight; blockHeight++) {
+        // the header index doesn't hold the votes, headers are sent as stored
+        BlockHeader blockHeader;
+        if(!chain.readBlockHeader(blockHeight, blockHeader)) {
+            break;
+        }
+
+        // headers carry the votes and don't have a fixed size
+        messageSize += GetSerializeSize(blockHeader, SER_DISK, 1);
+        if(messageSize + 64 > NetworkMessage::max_body_length) {
+            break;
+        }
+
+        transmitBlockHeaders.headers.emplace_back(blockHeader);
+    }
+
+    if(transmitBlockHeaders.headers.empty()) {
+        return;
+    }
+
+    recipient->deliver(NetworkMessageHelper::serializeToNetworkMessage(transmitBlockHeaders));
 }
 
 void NetworkMessageHandler::handleAskForPeers(PeerInterfacePtr recipient) {
@@ -337,16 +494,59 @@ void NetworkMessageHandler::handleTransmitBlocks(TransmitBlock *transmitBlocks,
     Log(LOG_LEVEL_INFO) << "received block: " << block.getHeader()->getHeaderHash() << ", height: " << block.getHeader()->getBlockHeight();
 
     //verify if we asked for the block
-    if(!blockCache.verifyAskedFor(recipient->getIp(), block.getHeader()->getHeaderHash(), block.getHeader()->getBlockHeight())) {
+    hash_t headerHash;
+    if(!headerHash.setFromVector(block.getHeader()->getHeaderHash())
+       || !blockCache.verifyAskedFor(recipient->getIp(), headerHash, block.getHeader()->getBlockHeight())) {
         BanList& banList = BanList::Instance();
         Log(LOG_LEVEL_INFO) << "node:" << recipient->getIp() << "sent an unwanted block";
         banList.appendBan(recipient->getIp(), BAN_INC_FOR_UNWANTED_BLOCK);
         return;
     }
 
+    // during headers-first sync only bodies matching the validated headers are worth caching
+    HeaderSkeleton& headerSkeleton = HeaderSkeleton::Instance();
+    if(!headerSkeleton.matchesSkeleton(block.getHeader())) {
+        Log(LOG_LEVEL_INFO) << "drop block: " << block.getHeader()->getHeaderHash() << " because it isn't on the header skeleton";
+        return;
+    }
+
     blockCache.appendBlock(recipient, &block);
 }
 
+void NetworkMessageHandler::handleTransmitBlockHeaders(TransmitBlockHeaders *transmitBlockHeaders, PeerInterfacePtr recipient) {
+    BanList& banList = BanList::Instance();
+    HeaderSkeleton& headerSkeleton = HeaderSkeleton::Instance();
+
+    Log(LOG_LEVEL_INFO) << "received " << (uint64_t)transmitBlockHeaders->headers.size() << " headers from " << recipient->getIp();
+
+    if(transmitBlockHeaders->headers.size() > MAX_BLOCK_HEADERS_PER_MESSAGE) {
+        Log(LOG_LEVEL_WARNING) << "Peer: " << recipient->getIp() << " has transmitted too many headers";
+        banList.appendBan(recipient->getIp(), BAN_INC_FOR_INVALID_MESSAGE);
+        return;
+    }
+
+    headerSkeleton.appendAssumeValidHeaders(transmitBlockHeaders->headers);
+
+    if(!headerSkeleton.appendHeaders(transmitBlockHeaders->headers)) {
+        Log(LOG_LEVEL_INFO) << "node:" << recipient->getIp() << " sent an invalid header";
+        banList.appendBan(recipient->getIp(), BAN_INC_FOR_INVALID_BLOCK);
+        return;
+    }
+
+    Network::setBlockHeadersAnswered(recipient);
+}
+
+void NetworkMessageHandler::handleTransmitServedBlockRange(TransmitServedBlockRange *transmitServedBlockRange, PeerInterfacePtr recipient) {
+    BlockCache &blockCache = BlockCache::Instance();
+
+    Log(LOG_LEVEL_INFO) << "Peer " << recipient->getIp() << " serves blocks from height " << transmitServedBlockRange->lowestBlockHeight;
+
+    recipient->setLowestServedBlockHeight(transmitServedBlockRange->lowestBlockHeight);
+
+    // the peer won't send what we asked for, it can be asked for other blocks right away
+    blockCache.removeFromAskedMaps(recipient->getIp());
+}
+
 void NetworkMessageHandler::handleTransmitPeers(TransmitPeers *transmitPeers, PeerInterfacePtr recipient) {
     Peers& peers = Peers::Instance();
     if(transmitPeers->ipList.size() > 10) {
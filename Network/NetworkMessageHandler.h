@@ -5,14 +5,22 @@
 #include <mutex>
 #include "NetworkMessage.h"
 #include "NetworkCommands.h"
+#include "RawBlockCache.h"
 
 typedef std::shared_ptr<PeerInterface> PeerInterfacePtr;
 
 class NetworkMessageHandler {
 private:
 
+    static RawBlockMessagePtr loadTransmitBlockBody(std::vector<unsigned char> blockHeaderHash);
+    static RawBlockMessagePtr getTransmitBlockBody(std::vector<unsigned char> blockHeaderHash);
+    static RawBlockMessagePtr getTransmitBlockBody(uint64_t blockHeight);
+    static void deliverTransmitBlockBody(RawBlockMessagePtr body, PeerInterfacePtr recipient);
+
+    static void transmitServedBlockRange(PeerInterfacePtr recipient);
     static void handleAskForBlocks(AskForBlocks *askForBlocks, PeerInterfacePtr recipient);
     static void handleAskForBlock(AskForBlock *askForBlock, PeerInterfacePtr recipient);
+    static void handleAskForBlockHeaders(AskForBlockHeaders *askForBlockHeaders, PeerInterfacePtr recipient);
     static void handleAskForPeers(PeerInterfacePtr recipient);
     static void handleAskForBlockchainHeight(PeerInterfacePtr recipient);
     static void handleAskForBestBlockHeader(PeerInterfacePtr recipient);
@@ -22,6 +30,8 @@ private:
 
     static void handleTransmitTransactions(TransmitTransactions *transmitBlocks, PeerInterfacePtr recipient);
     static void handleTransmitBlocks(TransmitBlock *transmitBlocks, PeerInterfacePtr recipient);
+    static void handleTransmitBlockHeaders(TransmitBlockHeaders *transmitBlockHeaders, PeerInterfacePtr recipient);
+    static void handleTransmitServedBlockRange(TransmitServedBlockRange *transmitServedBlockRange, PeerInterfacePtr recipient);
     static void handleTransmitPeers(TransmitPeers *transmitPeers, PeerInterfacePtr recipient);
     static void handleTransmitBlockchainHeight(TransmitBlockchainHeight *transmitBlockchainHeight, PeerInterfacePtr recipient);
     static void handleTransmitBestBlockHeader(TransmitBestBlockHeader *transmitBestBlockHeader, PeerInterfacePtr recipient);
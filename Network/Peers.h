@@ -2,6 +2,7 @@
 #ifndef TX_PEERS_H
 #define TX_PEERS_H
 
+#include <atomic>
 #include <unordered_map>
 #include <cstdlib>
 #include <deque>
@@ -53,6 +54,9 @@ private:
     bool disconnected = false;
     std::string donationAddress;
     uint64_t lastAsked = 0;
+    // written by the handler of the peer's messages while the sync thread reads them
+    std::atomic<uint64_t> lowestServedBlockHeight{0};
+    std::atomic<bool> supportsBlockHeaders{true}; // false once the peer left a request for headers unanswered
 
     void do_read_header();
     void do_read_body();
@@ -83,6 +87,22 @@ public:
         this->lastAsked = lastAsked;
     }
 
+    uint64_t getLowestServedBlockHeight() {
+        return lowestServedBlockHeight;
+    }
+
+    void setLowestServedBlockHeight(uint64_t lowestServedBlockHeight) {
+        this->lowestServedBlockHeight = lowestServedBlockHeight;
+    }
+
+    bool getSupportsBlockHeaders() {
+        return supportsBlockHeaders;
+    }
+
+    void setSupportsBlockHeaders(bool supportsBlockHeaders) {
+        this->supportsBlockHeaders = supportsBlockHeaders;
+    }
+
     void start();
     void close();
     void deliver(NetworkMessage msg);
@@ -119,6 +139,9 @@ private:
     std::mutex deliverMutex;
     std::string donationAddress;
     uint64_t lastAsked = 0;
+    // written by the handler of the peer's messages while the sync thread reads them
+    std::atomic<uint64_t> lowestServedBlockHeight{0};
+    std::atomic<bool> supportsBlockHeaders{true}; // false once the peer left a request for headers unanswered
 
     void do_read_header();
     void do_read_body();
@@ -157,6 +180,22 @@ public:
         this->lastAsked = lastAsked;
     }
 
+    uint64_t getLowestServedBlockHeight() {
+        return lowestServedBlockHeight;
+    }
+
+    void setLowestServedBlockHeight(uint64_t lowestServedBlockHeight) {
+        this->lowestServedBlockHeight = lowestServedBlockHeight;
+    }
+
+    bool getSupportsBlockHeaders() {
+        return supportsBlockHeaders;
+    }
+
+    void setSupportsBlockHeaders(bool supportsBlockHeaders) {
+        this->supportsBlockHeaders = supportsBlockHeaders;
+    }
+
     void deliver(NetworkMessage msg);
     void close();
     ip_t getIp();
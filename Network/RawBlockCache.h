@@ -0,0 +1,141 @@
+
+#ifndef TX_RAWBLOCKCACHE_H
+#define TX_RAWBLOCKCACHE_H
+
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "../uint256.h"
+
+#define RAW_BLOCK_CACHE_MAX_SIZE (32 * 1000 * 1000) /* in bytes */
+
+// body of a serialized TransmitBlock message
+typedef std::shared_ptr<const std::vector<unsigned char> > RawBlockMessagePtr;
+
+/**
+ * Least recently used TransmitBlock message bodies, shared by all peers asking for blocks.
+ * After a block announcement most peers ask for the same few blocks, they are read from the blockdat only once.
+ * Entries are found by hash, and by height as long as the block is on the active chain.
+ */
+class RawBlockCache {
+private:
+    struct Entry {
+        uint256 hash;
+        RawBlockMessagePtr body;
+        bool isIndexedByHeight;
+        uint64_t height;
+    };
+
+    std::mutex cacheMutex;
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<uint256, std::list<Entry>::iterator, BlobHasher> byHash;
+    std::map<uint64_t, std::list<Entry>::iterator> byHeight;
+    uint64_t cachedSize = 0;
+    uint64_t generation = 0;
+
+    void evict() {
+        while(this->cachedSize > RAW_BLOCK_CACHE_MAX_SIZE && this->entries.size() > 1) {
+            auto last = std::prev(this->entries.end());
+
+            // the height might have been invalidated or taken over by another block since
+            if(last->isIndexedByHeight) {
+                auto found = this->byHeight.find(last->height);
+                if(found != this->byHeight.end() && found->second == last) {
+                    this->byHeight.erase(found);
+                }
+            }
+            this->byHash.erase(last->hash);
+            this->cachedSize -= last->body->size();
+            this->entries.erase(last);
+        }
+    }
+public:
+    static RawBlockCache& Instance(){
+        static RawBlockCache instance;
+        return instance;
+    }
+
+    RawBlockMessagePtr get(uint256 hash) {
+        RawBlockMessagePtr body;
+
+        cacheMutex.lock();
+        auto found = this->byHash.find(hash);
+        if(found != this->byHash.end()) {
+            this->entries.splice(this->entries.begin(), this->entries, found->second);
+            body = found->second->body;
+        }
+        cacheMutex.unlock();
+
+        return body;
+    }
+
+    RawBlockMessagePtr get(uint64_t height) {
+        RawBlockMessagePtr body;
+
+        cacheMutex.lock();
+        auto found = this->byHeight.find(height);
+        if(found != this->byHeight.end()) {
+            this->entries.splice(this->entries.begin(), this->entries, found->second);
+            body = found->second->body;
+        }
+        cacheMutex.unlock();
+
+        return body;
+    }
+
+    /**
+     * Has to be read before the active chain is used to resolve a height, see insert()
+     */
+    uint64_t getGeneration() {
+        cacheMutex.lock();
+        uint64_t currentGeneration = this->generation;
+        cacheMutex.unlock();
+
+        return currentGeneration;
+    }
+
+    void insert(uint256 hash, RawBlockMessagePtr body) {
+        cacheMutex.lock();
+        if(this->byHash.find(hash) == this->byHash.end()) {
+            this->entries.push_front({hash, body, false, 0});
+            this->byHash.insert(std::make_pair(hash, this->entries.begin()));
+            this->cachedSize += body->size();
+            this->evict();
+        }
+        cacheMutex.unlock();
+    }
+
+    /**
+     * The height is only indexed if no block has been disconnected since the active chain was read at the given generation
+     */
+    void insert(uint256 hash, uint64_t height, uint64_t activeChainGeneration, RawBlockMessagePtr body) {
+        this->insert(hash, body);
+
+        cacheMutex.lock();
+        auto found = this->byHash.find(hash);
+        if(found != this->byHash.end() && activeChainGeneration == this->generation) {
+            found->second->isIndexedByHeight = true;
+            found->second->height = height;
+            this->byHeight[height] = found->second;
+        }
+        cacheMutex.unlock();
+    }
+
+    /**
+     * Called when the block at the given height is disconnected, heights from there on may point to another block
+     */
+    void invalidateFromHeight(uint64_t height) {
+        cacheMutex.lock();
+        this->byHeight.erase(this->byHeight.lower_bound(height), this->byHeight.end());
+        this->generation++;
+        cacheMutex.unlock();
+    }
+};
+
+
+#endif //TX_RAWBLOCKCACHE_H
@@ -1,118 +1,154 @@
 
+#include <algorithm>
 #include "PathSum.h"
 #include "../Tools/Log.h"
+#include "../DB/DB.h"
 
-bool PathSum::appendValue(UAmount amount) {
-    this->stack[(unsigned int)this->stack.size()] = amount;
-
-    if(this->stack.size() % BABY_STEP == 0 && this->stack.size() >= BABY_STEP) {
-        UAmount babySum = getSum((uint64_t)this->stack.size() - BABY_STEP, (uint64_t)this->stack.size());
-        this->babySteps[(uint64_t)this->stack.size() - BABY_STEP] = babySum;
-    }
-    if(this->stack.size() % LITTLE_STEP == 0 && this->stack.size() >= LITTLE_STEP) {
-        UAmount littleSum = getSum((uint64_t)this->stack.size() - LITTLE_STEP, (uint64_t)this->stack.size());
-        this->littleSteps[(uint64_t)this->stack.size() - LITTLE_STEP] = littleSum;
+/**
+ * Sum of the payouts at positions lower than position
+ */
+CAmount CurrencyPathSum::getTotalBefore(uint64_t position) {
+    auto found = std::lower_bound(this->positions.begin(), this->positions.end(), position);
+    if(found == this->positions.begin()) {
+        return 0;
     }
-    if(this->stack.size() % NORMAL_STEP == 0 && this->stack.size() >= NORMAL_STEP) {
-        UAmount normalSum = getSum((uint64_t)this->stack.size() - NORMAL_STEP, (uint64_t)this->stack.size());
-        this->normalSteps[(uint64_t)this->stack.size() - NORMAL_STEP] = normalSum;
+
+    return this->totals[found - this->positions.begin() - 1];
+}
+
+/**
+ * Has to be called with pathSumMutex locked
+ */
+void PathSum::appendToTotals(UAmount& amount) {
+    for(auto& value : amount.map) {
+        if(value.second == 0) {
+            continue;
+        }
+
+        CurrencyPathSum& currency = this->currencies[value.first];
+        CAmount previousTotal = currency.totals.empty() ? 0 : currency.totals.back();
+        currency.positions.emplace_back(this->stackHeight);
+        currency.totals.emplace_back(previousTotal + value.second);
     }
-    if(this->stack.size() % BIG_STEP == 0 && this->stack.size() >= BIG_STEP) {
-        UAmount bigSum = getSum((uint64_t)this->stack.size() - BIG_STEP, (uint64_t)this->stack.size());
-        this->bigSteps[(uint64_t)this->stack.size() - BIG_STEP] = bigSum;
+    this->stackHeight++;
+}
+
+/**
+ * The value is persisted with the open block transaction
+ */
+bool PathSum::appendValue(UAmount amount) {
+    DB& db = DB::Instance();
+
+    pathSumMutex.lock();
+    bool success = db.serializeToDb(DB_PATH_SUM, this->stackHeight, amount);
+    this->appendToTotals(amount);
+    pathSumMutex.unlock();
+
+    return success;
+}
+
+/**
+ * Loads the values of positions 0 to height from DB_PATH_SUM
+ * Returns false without loading anything if one of them is missing
+ */
+bool PathSum::loadFromDB(uint64_t height) {
+    DB& db = DB::Instance();
+
+    std::vector<UAmount> values;
+    DBIterator* it = db.newIterator(DB_PATH_SUM, 0, height);
+    for(; it->valid(); it->next()) {
+        UAmount amount;
+        if(it->integerKey() != values.size() || !it->deserializeValue(amount)) {
+            break;
+        }
+        values.emplace_back(amount);
     }
-    if(this->stack.size() % HUGE_STEP == 0 && this->stack.size() >= HUGE_STEP) {
-        UAmount hugeSum = getSum((uint64_t)this->stack.size() - HUGE_STEP, (uint64_t)this->stack.size());
-        this->hugeSteps[(uint64_t)this->stack.size() - HUGE_STEP] = hugeSum;
+    delete it;
+
+    if(values.size() != height + 1) {
+        return false;
     }
-    if(this->stack.size() % GIANT_STEP == 0 && this->stack.size() >= GIANT_STEP) {
-        UAmount giantSum = getSum((uint64_t)this->stack.size() - GIANT_STEP, (uint64_t)this->stack.size());
-        this->giantSteps[(uint64_t)this->stack.size() - GIANT_STEP] = giantSum;
+
+    pathSumMutex.lock();
+    this->currencies.clear();
+    this->stackHeight = 0;
+    for(UAmount& amount : values) {
+        this->appendToTotals(amount);
     }
+    pathSumMutex.unlock();
 
     return true;
 }
 
+/**
+ * Sum of the payouts from startPosition to endPosition excluded
+ */
 UAmount PathSum::getSum(uint64_t startPosition, uint64_t endPosition) {
-    //Log(LOG_LEVEL_INFO) << "getSum: " << startPosition << "," << endPosition;
     UAmount sum;
-    uint64_t currentPosition = startPosition;
-
-    while(currentPosition < endPosition) {
-        if (currentPosition % GIANT_STEP == 0 && endPosition >= (currentPosition + GIANT_STEP)) {
-            if(this->giantSteps.find(currentPosition) != this->giantSteps.end()) {
-                sum += this->giantSteps[currentPosition];
-                //Log(LOG_LEVEL_INFO) << "Position: " << currentPosition << " Do GIANT_STEP +" << this->giantSteps[currentPosition];
-                currentPosition += GIANT_STEP;
-                continue;
-            }
-        }
-        if (currentPosition % HUGE_STEP == 0 && endPosition >= (currentPosition + HUGE_STEP)) {
-            if(this->hugeSteps.find(currentPosition) != this->hugeSteps.end()) {
-                sum += this->hugeSteps[currentPosition];
-                //Log(LOG_LEVEL_INFO) << "Position: " << currentPosition << " Do HUGE_STEP +" << this->hugeSteps[currentPosition];
-                currentPosition += HUGE_STEP;
-                continue;
-            }
-        }
-        if (currentPosition % BIG_STEP == 0 && endPosition >= (currentPosition + BIG_STEP)) {
-            if(this->bigSteps.find(currentPosition) != this->bigSteps.end()) {
-                sum += this->bigSteps[currentPosition];
-                Log(LOG_LEVEL_INFO) << "Position: " << currentPosition << " Do BIG_STEP +" << this->bigSteps[currentPosition];
-                currentPosition += BIG_STEP;
-                continue;
-            }
-        }
-        if (currentPosition % NORMAL_STEP == 0 && endPosition >= (currentPosition + NORMAL_STEP)) {
-            if(this->normalSteps.find(currentPosition) != this->normalSteps.end()) {
-                sum += this->normalSteps[currentPosition];
-                //Log(LOG_LEVEL_INFO) << "Position: " << currentPosition << " Do NORMAL_STEP +" << this->normalSteps[currentPosition];
-                currentPosition += NORMAL_STEP;
-                continue;
-            }
-        }
-        if (currentPosition % LITTLE_STEP == 0 && endPosition >= (currentPosition + LITTLE_STEP)) {
-            if(this->littleSteps.find(currentPosition) != this->littleSteps.end()) {
-                sum += this->littleSteps[currentPosition];
-                //Log(LOG_LEVEL_INFO) << "Position: " << currentPosition << " Do LITTLE_STEP +" << this->littleSteps[currentPosition];
-                currentPosition += LITTLE_STEP;
-                continue;
-            }
-        }
-        if (currentPosition % BABY_STEP == 0 && endPosition >= (currentPosition + BABY_STEP)) {
-            if(this->babySteps.find(currentPosition) != this->babySteps.end()) {
-                sum += this->babySteps[currentPosition];
-                //Log(LOG_LEVEL_INFO) << "Position: " << currentPosition << " Do BABY_STEP +" << this->babySteps[currentPosition];
-                currentPosition += BABY_STEP;
-                continue;
-            }
-        }
+    if(startPosition >= endPosition) {
+        return sum;
+    }
 
-        //do simple step
-        if(this->stack.find(currentPosition) != this->stack.end()) {
-            sum += this->stack[currentPosition];
-            //Log(LOG_LEVEL_INFO) << "Position: " << currentPosition << " Do simple step +" << this->stack[currentPosition];
+    pathSumMutex.lock();
+    for(auto& currency : this->currencies) {
+        CAmount currencySum = currency.second.getTotalBefore(endPosition) - currency.second.getTotalBefore(startPosition);
+        if(currencySum > 0) {
+            sum.map[currency.first] = currencySum;
         }
+    }
+    pathSumMutex.unlock();
+
+    return sum;
+}
+
+CAmount PathSum::getSum(uint8_t currency, uint64_t startPosition, uint64_t endPosition) {
+    if(startPosition >= endPosition) {
+        return 0;
+    }
 
-        currentPosition += 1;
+    pathSumMutex.lock();
+    CAmount sum = 0;
+    auto found = this->currencies.find(currency);
+    if(found != this->currencies.end()) {
+        sum = found->second.getTotalBefore(endPosition) - found->second.getTotalBefore(startPosition);
     }
+    pathSumMutex.unlock();
 
     return sum;
 }
 
+/**
+ * Removes the size last values, sums over the removed positions are 0 afterwards
+ */
 bool PathSum::popValue(uint64_t size) {
-    uint64_t oldStackHeight = PathSum::getStackHeight();
-    for(uint64_t i = oldStackHeight; i > oldStackHeight - size; i--) {
-        this->stack.erase(i);
+    DB& db = DB::Instance();
+
+    pathSumMutex.lock();
+
+    if(size > this->stackHeight) {
+        Log(LOG_LEVEL_ERROR) << "Cannot pop " << size << " value(s) from a PathSum of height " << this->stackHeight;
+        pathSumMutex.unlock();
+        return false;
+    }
+
+    for(uint64_t position = this->stackHeight - size; position < this->stackHeight; position++) {
+        std::string key = DB::integerKey(position);
+        db.removeFromDB(DB_PATH_SUM, std::vector<unsigned char>(key.begin(), key.end()));
+    }
+
+    this->stackHeight -= size;
+    for(auto& currency : this->currencies) {
+        while(!currency.second.positions.empty() && currency.second.positions.back() >= this->stackHeight) {
+            currency.second.positions.pop_back();
+            currency.second.totals.pop_back();
+        }
     }
 
+    pathSumMutex.unlock();
+
     return true;
 }
 
 uint64_t PathSum::getStackHeight() {
-    return (uint64_t)this->stack.size();
-}
-
-std::map<uint64_t, UAmount> PathSum::getStack() {
-    return this->stack;
+    return this->stackHeight;
 }
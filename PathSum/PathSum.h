@@ -3,19 +3,20 @@
  * With UBIC the UBI reward is distributed every block to a large amount of addresses. This is why
  * The PathSum Class is there to drastically reduce the amount of computation required for every payout.
  *
- * Example:
+ * For every currency it keeps the running total of the payouts at the positions where the currency was paid out.
+ * The payout between two positions is the difference of the running totals before them,
+ * each one is found with a binary search.
  *
- *                                          158
- *                                           /\
- *                  87                                            71
- *                  /\                                            /\
- *        45                    42                      30                   41
- *        /\                    /\                      /\                   /\
- * 5 5 5 5 5 4 4 4 4 4 | 5 5 5 5 5 5 3 3 3 3 | 3 3 3 3 3 3 3 3 3 3 | 4 5 4 4 4 4 4 4 4 4
+ * Example for one currency:
  *
- * In this example without the PathSum it would take 22 computational steps to calculate
- * the UBI reward between Block 0 and 22. With the PathSum it takes only 3:
- * 87 + 3 + 3
+ * position:      0  1  2  3  4  5
+ * payout:        0  5  5  0  4  4
+ * running total:    5  10    14 18   (only positions with a payout are stored)
+ *
+ * The payout between position 2 and 5 is the total before 5 minus the total before 2: 14 - 5 = 9
+ *
+ * The payout of every position is also written to DB_PATH_SUM with the block, so the totals are
+ * rebuilt at start with one sweep over the store instead of walking the chain.
  *
  */
 
@@ -23,24 +24,24 @@
 #define PATH_SUM_H
 
 #include <map>
+#include <mutex>
+#include <vector>
 #include "../UAmount.h"
 
+struct CurrencyPathSum {
+    std::vector<uint64_t> positions; // ascending
+    std::vector<CAmount> totals; // totals[i] is the sum of the payouts up to and including positions[i]
+
+    CAmount getTotalBefore(uint64_t position);
+};
+
 class PathSum {
 private:
-    std::map<uint64_t, UAmount> stack;
-    std::map<uint64_t, UAmount> babySteps; // *10
-    std::map<uint64_t, UAmount> littleSteps; // *100
-    std::map<uint64_t, UAmount> normalSteps; // *1000
-    std::map<uint64_t, UAmount> bigSteps; // *10000
-    std::map<uint64_t, UAmount> hugeSteps; // *100000
-    std::map<uint64_t, UAmount> giantSteps; // *1000000
-
-    int64_t BABY_STEP = 10;
-    int64_t LITTLE_STEP = 100;
-    int64_t NORMAL_STEP = 1000;
-    int64_t BIG_STEP = 10000;
-    int64_t HUGE_STEP = 100000;
-    int64_t GIANT_STEP = 1000000;
+    std::mutex pathSumMutex;
+    std::map<uint8_t, CurrencyPathSum> currencies;
+    uint64_t stackHeight = 0;
+
+    void appendToTotals(UAmount& amount);
 public:
     static PathSum& Instance(){
         static PathSum instance;
@@ -48,10 +49,11 @@ public:
     }
 
     bool appendValue(UAmount amount);
+    bool loadFromDB(uint64_t height);
     bool popValue(uint64_t size);
     UAmount getSum(uint64_t startPosition, uint64_t endPosition);
+    CAmount getSum(uint8_t currency, uint64_t startPosition, uint64_t endPosition);
     uint64_t getStackHeight();
-    std::map<uint64_t, UAmount> getStack();
 };
 
 
@@ -120,6 +120,9 @@ std::string ApiServer::route(std::vector<std::string> urlParts, std::string json
 
             }
         } else if(urlParts.at(0) == "blocks") {
+            if(urlParts.size() >= 3) {
+                return Api::getBlockHashes((uint32_t)atoi(urlParts.at(1).c_str()), (uint32_t)atoi(urlParts.at(2).c_str()));
+            }
             if(urlParts.size() >= 2) {
                 if(urlParts.at(1).size() == 64) {
                     return Api::getBlock(Hexdump::hexStringToVector(urlParts.at(1)));
@@ -191,6 +194,8 @@ std::string ApiServer::route(std::vector<std::string> urlParts, std::string json
                 }
             }
             return Api::getBans();
+        } else if(urlParts.at(0) == "db") {
+            return Api::getDBStatistics();
         } else if(urlParts.at(0) == "address") {
             if(urlParts.size() == 2) {
                 return Api::getAddress(Hexdump::hexStringToVector(urlParts.at(1)));
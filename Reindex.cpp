@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include "Reindex.h"
+#include "AddressStore.h"
+#include "BlockDatWriter.h"
+#include "Chain.h"
+#include "DB/DB.h"
+#include "FS/FS.h"
+#include "streams.h"
+#include "uint256.h"
+#include "Tools/Log.h"
+#include "Tools/WorkerPool.h"
+
+// stores that are rebuilt, my transactions are written again when the blocks are connected
+static const uint8_t reindexStores[] = {
+        DB_ADDRESS_STORE,
+        DB_BLOCK_INDEX,
+        DB_NTPSK_ALREADY_USED,
+        DB_DSC_ATTACHED_PASSPORTS_COUNTER,
+        DB_BLOCK_HEADERS,
+        DB_MY_TRANSACTIONS,
+        DB_VOTES,
+        DB_BLOCK_UNDO,
+        DB_PATH_SUM
+};
+
+static const char* reindexCertDirectories[] = {"csca/", "dsc/"};
+
+BlockDatMappingPtr Reindex::mapBlockDatFile(uint32_t fileNumber) {
+    char cPath[512];
+    FS::charPathFromVectorPath(cPath, FS::getBlockDatPath(FS::getBlockDatReindexDirectoryPath(), fileNumber));
+
+    try {
+        BlockDatMappingPtr mapping = std::make_shared<BlockDatMapping>();
+        mapping->file = boost::interprocess::file_mapping(cPath, boost::interprocess::read_only);
+        mapping->region = boost::interprocess::mapped_region(mapping->file, boost::interprocess::read_only);
+        mapping->region.advise(boost::interprocess::mapped_region::advice_sequential);
+
+        return mapping;
+    } catch (const boost::interprocess::interprocess_exception& e) {
+        Log(LOG_LEVEL_ERROR) << "failed to map blockdat file " << cPath << ": " << e.what();
+    }
+
+    return nullptr;
+}
+
+/**
+ * The block index already knows where each block starts, so blocks can be deserialized independently
+ */
+bool Reindex::loadEntriesFromBlockIndex() {
+    DB& db = DB::Instance();
+
+    DBIterator* it = db.newIterator(DB_BLOCK_INDEX);
+    for(; it->valid(); it->next()) {
+        BlockIndex index;
+        if(it->key().size() != uint256::size() || !it->deserializeValue(index)) {
+            continue;
+        }
+
+        ReindexEntry entry;
+        entry.fileNumber = BlockDatWriter::getFileNumber(index.getBlockDatPath());
+        entry.startPosition = index.getStartPosition();
+        entry.size = index.getSize();
+        this->entries.emplace_back(entry);
+    }
+    delete it;
+
+    return !this->entries.empty();
+}
+
+/**
+ * Without a usable block index the block boundaries are found by deserializing every file once
+ * A preallocated file ends with zeros, they deserialize to a block of height 0
+ */
+bool Reindex::scanBlockDatFiles() {
+    std::vector<uint32_t> fileNumbers;
+    for(std::vector<unsigned char> filePath : FS::readDir(FS::getBlockDatReindexDirectoryPath())) {
+        fileNumbers.emplace_back(BlockDatWriter::getFileNumber(filePath));
+    }
+    std::sort(fileNumbers.begin(), fileNumbers.end());
+
+    for(uint32_t fileNumber : fileNumbers) {
+        BlockDatMappingPtr mapping = mapBlockDatFile(fileNumber);
+        if(mapping == nullptr) {
+            continue;
+        }
+
+        size_t fileSize = mapping->region.get_size();
+        SpanReader reader(SER_DISK, SERIALIZATION_VERSION, (const char*)mapping->region.get_address(), fileSize);
+        try {
+            while(!reader.empty()) {
+                uint64_t startPosition = fileSize - reader.size();
+                Block block;
+                reader >> block;
+
+                if(block.getHeader()->getBlockHeight() == 0) {
+                    break;
+                }
+
+                ReindexEntry entry;
+                entry.fileNumber = fileNumber;
+                entry.startPosition = startPosition;
+                entry.size = (fileSize - reader.size()) - startPosition;
+                this->entries.emplace_back(entry);
+            }
+        } catch (const std::exception& e) {
+            Log(LOG_LEVEL_WARNING) << "blockdat file " << fileNumber << " ends with an incomplete block: " << e.what();
+        }
+    }
+
+    Log(LOG_LEVEL_INFO) << "reindex: found " << (uint64_t)this->entries.size() << " block(s) in blockdat files";
+
+    return !this->entries.empty();
+}
+
+/**
+ * Has to be called after the config is loaded and before anything reads the chain state or writes blocks
+ */
+bool Reindex::prepare() {
+    DB& db = DB::Instance();
+
+    if(FS::isDir(FS::getBlockDatReindexDirectoryPath())) {
+        // an interrupted reindex, the blocks connected so far are connected again
+        Log(LOG_LEVEL_INFO) << "reindex: resuming interrupted reindex";
+        FS::deleteDirectory(FS::getBlockDatDirectoryPath());
+    } else {
+        std::string filesKey = BLOCK_DAT_FILES_KEY;
+        BlockDatFiles files;
+        if(db.deserializeFromDb(DB_BLOCK_INDEX, std::vector<unsigned char>(filesKey.begin(), filesKey.end()), files)
+           && files.prunedBlockHeight > 0) {
+            Log(LOG_LEVEL_CRITICAL_ERROR) << "reindex: blocks up to height " << files.prunedBlockHeight << " have been pruned";
+            return false;
+        }
+
+        this->loadEntriesFromBlockIndex();
+
+        if(!FS::renamePath(FS::getBlockDatDirectoryPath(), FS::getBlockDatReindexDirectoryPath())) {
+            Log(LOG_LEVEL_CRITICAL_ERROR) << "reindex: couldn't move the blockdat directory";
+            return false;
+        }
+    }
+
+    if(this->entries.empty() && !this->scanBlockDatFiles()) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "reindex: there are no blocks to reindex";
+        return false;
+    }
+
+    std::sort(this->entries.begin(), this->entries.end(), [](const ReindexEntry& a, const ReindexEntry& b) {
+        return a.fileNumber < b.fileNumber || (a.fileNumber == b.fileNumber && a.startPosition < b.startPosition);
+    });
+
+    for(uint8_t store : reindexStores) {
+        if(!db.clearStore(store)) {
+            return false;
+        }
+    }
+    FS::deleteFile(FS::getBestBlockHeadersPath());
+    AddressStore& addressStore = AddressStore::Instance();
+    addressStore.clearCache();
+
+    for(const char* directory : reindexCertDirectories) {
+        for(std::vector<unsigned char> filePath : FS::readDir(FS::concatPaths(FS::getCertDirectoryPath(), directory))) {
+            FS::deleteFile(filePath);
+        }
+        for(std::vector<unsigned char> filePath : FS::readDir(FS::concatPaths(FS::getX509DirectoryPath(), directory))) {
+            FS::deleteFile(filePath);
+        }
+    }
+
+    FS::createDirectory(FS::getBlockDatDirectoryPath());
+    FS::touchFile(FS::getBlockDatPath(0));
+
+    Log(LOG_LEVEL_INFO) << "reindex: prepared " << (uint64_t)this->entries.size() << " block(s)";
+
+    return true;
+}
+
+bool Reindex::run() {
+    Chain& chain = Chain::Instance();
+    WorkerPool& workerPool = WorkerPool::Instance();
+
+    uint64_t totalBytes = 0;
+    for(ReindexEntry& entry : this->entries) {
+        totalBytes += entry.size;
+    }
+
+    std::map<uint32_t, BlockDatMappingPtr> mappings;
+    uint64_t processedBytes = 0;
+    uint64_t connectedCount = 0;
+    uint64_t skippedCount = 0;
+    uint64_t failedCount = 0;
+
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point lastProgress = startTime;
+
+    for(size_t batchStart = 0; batchStart < this->entries.size(); batchStart += REINDEX_BATCH_SIZE) {
+        size_t batchSize = std::min((size_t)REINDEX_BATCH_SIZE, this->entries.size() - batchStart);
+
+        // only the files of the current batch stay mapped
+        uint32_t firstFileNumber = this->entries[batchStart].fileNumber;
+        mappings.erase(mappings.begin(), mappings.lower_bound(firstFileNumber));
+        for(size_t i = batchStart; i < batchStart + batchSize; i++) {
+            if(mappings.count(this->entries[i].fileNumber) == 0) {
+                mappings[this->entries[i].fileNumber] = mapBlockDatFile(this->entries[i].fileNumber);
+            }
+        }
+
+        std::vector<Block> blocks(batchSize);
+        std::vector<uint8_t> deserialized(batchSize, 0);
+        workerPool.parallelFor(batchSize, [&](size_t i) {
+            ReindexEntry& entry = this->entries[batchStart + i];
+            BlockDatMappingPtr mapping = mappings.at(entry.fileNumber);
+            if(mapping == nullptr || entry.startPosition + entry.size > mapping->region.get_size()) {
+                return;
+            }
+
+            try {
+                SpanReader reader(SER_DISK, SERIALIZATION_VERSION, (const char*)mapping->region.get_address() + entry.startPosition, entry.size);
+                reader >> blocks[i];
+                deserialized[i] = 1;
+            } catch (const std::exception& e) {
+                Log(LOG_LEVEL_ERROR) << "reindex: failed to deserialize block at " << entry.startPosition
+                                     << " in blockdat file " << entry.fileNumber << ": " << e.what();
+            }
+        });
+
+        for(size_t i = 0; i < batchSize; i++) {
+            processedBytes += this->entries[batchStart + i].size;
+
+            if(!deserialized[i]) {
+                failedCount++;
+            } else if(chain.doesBlockExist(blocks[i].getHeader()->getHeaderHash())) {
+                skippedCount++;
+            } else if(chain.connectBlock(&blocks[i])) {
+                connectedCount++;
+            } else {
+                failedCount++;
+            }
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if(now - lastProgress >= std::chrono::seconds(REINDEX_PROGRESS_INTERVAL) || batchStart + batchSize == this->entries.size()) {
+            double seconds = std::chrono::duration<double>(now - startTime).count();
+            if(seconds <= 0) {
+                seconds = 1;
+            }
+
+            Log(LOG_LEVEL_INFO) << "reindex: height " << chain.getCurrentBlockchainHeight()
+                                << ", " << (uint64_t)(processedBytes * 100 / std::max(totalBytes, (uint64_t)1)) << "%"
+                                << ", " << (uint64_t)((batchStart + batchSize) / seconds) << " blocks/s"
+                                << ", " << (uint64_t)(processedBytes / seconds / 1000000) << " MB/s"
+                                << ", " << connectedCount << " connected, " << skippedCount << " duplicate, " << failedCount << " failed";
+            lastProgress = now;
+        }
+    }
+    mappings.clear();
+    this->entries.clear();
+
+    if(failedCount > 0) {
+        Log(LOG_LEVEL_WARNING) << "reindex: " << failedCount << " block(s) couldn't be connected, blockdat-reindex/ is kept";
+        return false;
+    }
+
+    FS::deleteDirectory(FS::getBlockDatReindexDirectoryPath());
+    Log(LOG_LEVEL_INFO) << "reindex: done at height " << chain.getCurrentBlockchainHeight();
+
+    return true;
+}
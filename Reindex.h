@@ -0,0 +1,46 @@
+
+#ifndef TX_REINDEX_H
+#define TX_REINDEX_H
+
+#include <cstdint>
+#include <vector>
+#include "BlockStore.h"
+
+#define REINDEX_BATCH_SIZE 128 /* blocks deserialized in parallel before they are connected */
+#define REINDEX_PROGRESS_INTERVAL 10 /* in seconds */
+
+/**
+ * Position of a block in a blockdat file of the reindex directory
+ */
+struct ReindexEntry {
+    uint32_t fileNumber;
+    uint64_t startPosition;
+    uint64_t size;
+};
+
+/**
+ * Rebuilds all chain state stores from the local blockdat files, no peer is needed.
+ *
+ * prepare() moves blockdat/ to blockdat-reindex/ and empties the stores before anything else is loaded,
+ * run() connects the blocks again in the order they were stored, which is an order in which they connected before.
+ * Blocks are deserialized in batches on the WorkerPool, connecting them verifies and applies them one by one.
+ */
+class Reindex {
+private:
+    std::vector<ReindexEntry> entries;
+
+    bool loadEntriesFromBlockIndex();
+    bool scanBlockDatFiles();
+    static BlockDatMappingPtr mapBlockDatFile(uint32_t fileNumber);
+public:
+    static Reindex& Instance(){
+        static Reindex instance;
+        return instance;
+    }
+
+    bool prepare();
+    bool run();
+};
+
+
+#endif //TX_REINDEX_H
@@ -0,0 +1,381 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <openssl/evp.h>
+#include "Snapshot.h"
+#include "BlockDatWriter.h"
+#include "Chain.h"
+#include "DB/DB.h"
+#include "FS/FS.h"
+#include "streams.h"
+#include "Tools/Log.h"
+
+// stores holding the chain state, block bodies, undo records and wallet data are not part of a snapshot
+static const uint8_t snapshotStores[] = {
+        DB_ADDRESS_STORE,
+        DB_NTPSK_ALREADY_USED,
+        DB_DSC_ATTACHED_PASSPORTS_COUNTER,
+        DB_VOTES,
+        DB_BLOCK_HEADERS
+};
+
+static const char* snapshotCertDirectories[] = {"csca/", "dsc/"};
+
+std::vector<unsigned char> SnapshotHelper::scheduledPath;
+uint64_t SnapshotHelper::scheduledHeight = 0;
+
+template < class Serializable >
+static bool writeToSnapshot(FILE* file, EVP_MD_CTX* mdctx, Serializable& data) {
+    CDataStream s(SER_DISK, SERIALIZATION_VERSION);
+    s << data;
+
+    EVP_DigestUpdate(mdctx, s.data(), s.size());
+    return fwrite(s.data(), 1, s.size(), file) == s.size();
+}
+
+static bool isSnapshotStore(uint8_t store) {
+    for(uint8_t snapshotStore : snapshotStores) {
+        if(snapshotStore == store) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Only plain file names in the csca/ and dsc/ directories can be restored
+ */
+static bool isSnapshotCertPath(std::vector<unsigned char> relativePath) {
+    std::string pathString(relativePath.begin(), relativePath.end());
+
+    if(pathString.find("..") != std::string::npos || pathString.find('\\') != std::string::npos) {
+        return false;
+    }
+
+    for(const char* directory : snapshotCertDirectories) {
+        size_t directoryLength = strlen(directory);
+        if(pathString.size() > directoryLength
+           && pathString.compare(0, directoryLength, directory) == 0
+           && pathString.find('/', directoryLength) == std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool writeCertFilesToSnapshot(FILE* file, EVP_MD_CTX* mdctx, uint8_t recordType, std::vector<unsigned char> basePath, uint64_t &recordCount) {
+    for(const char* directory : snapshotCertDirectories) {
+        for(std::vector<unsigned char> filePath : FS::readDir(FS::concatPaths(basePath, directory))) {
+            std::string filePathString(filePath.begin(), filePath.end());
+            size_t nameStart = filePathString.find_last_of("/\\") + 1;
+
+            SnapshotRecord record;
+            record.type = recordType;
+            record.key = FS::concatPaths(directory, filePathString.substr(nameStart).c_str());
+            record.value = FS::readFile(filePath);
+
+            if(!writeToSnapshot(file, mdctx, record)) {
+                return false;
+            }
+            recordCount++;
+        }
+    }
+    return true;
+}
+
+bool SnapshotHelper::dumpSnapshot(std::vector<unsigned char> path) {
+    Chain& chain = Chain::Instance();
+    DB& db = DB::Instance();
+
+    BlockHeader* bestHeader = chain.getBestBlockHeader();
+    if(bestHeader == nullptr) {
+        Log(LOG_LEVEL_ERROR) << "cannot dump snapshot, there is no block";
+        return false;
+    }
+
+    char cPath[512];
+    FS::charPathFromVectorPath(cPath, path);
+    FILE* file = fopen(cPath, "wb");
+    if(file == nullptr) {
+        Log(LOG_LEVEL_ERROR) << "cannot open snapshot file " << cPath;
+        return false;
+    }
+
+    EVP_MD_CTX* mdctx = EVP_MD_CTX_create();
+    EVP_DigestInit_ex(mdctx, EVP_sha256(), NULL);
+
+    SnapshotHeader snapshotHeader;
+    snapshotHeader.blockHeight = bestHeader->getBlockHeight();
+    snapshotHeader.bestHeaderHash = bestHeader->getHeaderHash();
+    bool success = writeToSnapshot(file, mdctx, snapshotHeader);
+
+    uint64_t recordCount = 0;
+    for(uint8_t store : snapshotStores) {
+        DBIterator* it = db.newIterator(store);
+        for(; it->valid() && success; it->next()) {
+            leveldb::Slice key = it->key();
+            leveldb::Slice value = it->value();
+
+            SnapshotRecord record;
+            record.type = SNAPSHOT_RECORD_DB_ENTRY;
+            record.store = store;
+            record.key = std::vector<unsigned char>(key.data(), key.data() + key.size());
+            record.value = std::vector<unsigned char>(value.data(), value.data() + value.size());
+
+            success = writeToSnapshot(file, mdctx, record);
+            recordCount++;
+        }
+        success = success && it->ok();
+        delete it;
+    }
+
+    success = success
+              && writeCertFilesToSnapshot(file, mdctx, SNAPSHOT_RECORD_CERT_FILE, FS::getCertDirectoryPath(), recordCount)
+              && writeCertFilesToSnapshot(file, mdctx, SNAPSHOT_RECORD_X509_FILE, FS::getX509DirectoryPath(), recordCount);
+
+    SnapshotRecord bestHeaderRecord;
+    bestHeaderRecord.type = SNAPSHOT_RECORD_BEST_HEADER;
+    CDataStream s(SER_DISK, SERIALIZATION_VERSION);
+    s << *bestHeader;
+    bestHeaderRecord.value = std::vector<unsigned char>(s.data(), s.data() + s.size());
+
+    SnapshotRecord endRecord;
+    success = success
+              && writeToSnapshot(file, mdctx, bestHeaderRecord)
+              && writeToSnapshot(file, mdctx, endRecord);
+
+    unsigned char digest[32];
+    unsigned int digestLength;
+    EVP_DigestFinal_ex(mdctx, digest, &digestLength);
+    EVP_MD_CTX_destroy(mdctx);
+
+    success = success && fwrite(digest, 1, sizeof(digest), file) == sizeof(digest);
+    success = fclose(file) == 0 && success;
+
+    if(!success) {
+        Log(LOG_LEVEL_ERROR) << "failed to write snapshot file " << cPath;
+        return false;
+    }
+
+    Log(LOG_LEVEL_INFO) << "dumped snapshot at height " << snapshotHeader.blockHeight
+                        << " with " << recordCount << " record(s) to " << cPath;
+
+    return true;
+}
+
+/**
+ * Has to be called before blocks are connected, the dump happens once in onBlockConnected()
+ */
+void SnapshotHelper::scheduleDump(std::vector<unsigned char> path, uint64_t blockHeight) {
+    scheduledPath = path;
+    scheduledHeight = blockHeight;
+}
+
+/**
+ * Called by connectBlock() while it still holds the chain, so the stores are exactly at blockHeight
+ * If that block is later replaced by a fork the snapshot holds the replaced one
+ */
+void SnapshotHelper::onBlockConnected(uint64_t blockHeight) {
+    if(scheduledHeight == 0 || blockHeight != scheduledHeight) {
+        return;
+    }
+    scheduledHeight = 0;
+
+    if(!dumpSnapshot(scheduledPath)) {
+        Log(LOG_LEVEL_ERROR) << "failed to dump the snapshot scheduled at height " << blockHeight;
+    }
+}
+
+/**
+ * Reads the records up to the end record into the open block transaction, it is committed every SNAPSHOT_LOAD_BATCH_RECORDS records
+ * Returns false on the first record that can't be read or written, a block transaction is open again then
+ */
+static bool loadSnapshotRecords(CAutoFile& filein, SnapshotHeader& snapshotHeader, BlockHeader& bestHeader, uint64_t &recordCount) {
+    DB& db = DB::Instance();
+    bool bestHeaderFound = false;
+
+    try {
+        SnapshotRecord record;
+        filein >> record;
+
+        while(record.type != SNAPSHOT_RECORD_END) {
+            switch(record.type) {
+                case SNAPSHOT_RECORD_DB_ENTRY: {
+                    if(!isSnapshotStore(record.store)) {
+                        Log(LOG_LEVEL_ERROR) << "snapshot contains unexpected store " << (uint32_t)record.store;
+                        return false;
+                    }
+                    if(!db.putInDB(record.store, record.key, record.value)) {
+                        Log(LOG_LEVEL_ERROR) << "failed to write snapshot record to Store: " << (uint32_t)record.store;
+                        return false;
+                    }
+                    break;
+                }
+                case SNAPSHOT_RECORD_CERT_FILE:
+                case SNAPSHOT_RECORD_X509_FILE: {
+                    if(!isSnapshotCertPath(record.key)) {
+                        Log(LOG_LEVEL_ERROR) << "snapshot contains unexpected file path";
+                        return false;
+                    }
+                    std::vector<unsigned char> basePath = record.type == SNAPSHOT_RECORD_CERT_FILE ? FS::getCertDirectoryPath() : FS::getX509DirectoryPath();
+                    std::vector<unsigned char> filePath = FS::concatPaths(basePath, record.key);
+                    FS::touchFile(filePath);
+                    if(!FS::overwriteFile(filePath, record.value)) {
+                        Log(LOG_LEVEL_ERROR) << "failed to write snapshot file record";
+                        return false;
+                    }
+                    break;
+                }
+                case SNAPSHOT_RECORD_BEST_HEADER: {
+                    CDataStream s(SER_DISK, SERIALIZATION_VERSION);
+                    s.write((char*)record.value.data(), record.value.size());
+                    s >> bestHeader;
+
+                    if(bestHeader.getHeaderHash() != snapshotHeader.bestHeaderHash
+                       || bestHeader.getBlockHeight() != snapshotHeader.blockHeight) {
+                        Log(LOG_LEVEL_ERROR) << "snapshot best header doesn't match the snapshot height";
+                        return false;
+                    }
+                    bestHeaderFound = true;
+                    break;
+                }
+                default:
+                    Log(LOG_LEVEL_ERROR) << "snapshot contains unknown record type " << (uint32_t)record.type;
+                    return false;
+            }
+
+            recordCount++;
+            if(recordCount % SNAPSHOT_LOAD_BATCH_RECORDS == 0) {
+                bool committed = db.commitBlockTransaction();
+                db.beginBlockTransaction();
+                if(!committed) {
+                    Log(LOG_LEVEL_ERROR) << "failed to write snapshot records to the stores";
+                    return false;
+                }
+                Log(LOG_LEVEL_INFO) << "loaded " << recordCount << " snapshot record(s)";
+            }
+
+            filein >> record;
+        }
+    } catch (const std::exception& e) {
+        Log(LOG_LEVEL_ERROR) << "failed to read snapshot record: " << e.what();
+        return false;
+    }
+
+    if(!bestHeaderFound) {
+        Log(LOG_LEVEL_ERROR) << "snapshot has no best header";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Has to be called on an empty node before the chain state is loaded
+ */
+bool SnapshotHelper::loadSnapshot(std::vector<unsigned char> path) {
+    DB& db = DB::Instance();
+
+    std::string bestBlockHeadersKey = BEST_BLOCK_HEADERS_KEY;
+    if(!db.getFromDB(DB_BLOCK_HEADERS, bestBlockHeadersKey).empty() || FS::getEofPosition(FS::getBestBlockHeadersPath()) > 0) {
+        Log(LOG_LEVEL_ERROR) << "cannot load snapshot, this node already has a chain";
+        return false;
+    }
+
+    char cPath[512];
+    FS::charPathFromVectorPath(cPath, path);
+    FILE* file = fopen(cPath, "rb");
+    if(file == nullptr) {
+        Log(LOG_LEVEL_ERROR) << "cannot open snapshot file " << cPath;
+        return false;
+    }
+
+    // verify the checksum before anything is written
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    if(fileSize < 32) {
+        Log(LOG_LEVEL_ERROR) << "snapshot file " << cPath << " is truncated";
+        fclose(file);
+        return false;
+    }
+
+    EVP_MD_CTX* mdctx = EVP_MD_CTX_create();
+    EVP_DigestInit_ex(mdctx, EVP_sha256(), NULL);
+
+    std::vector<char> buffer(1 << 16);
+    long remaining = fileSize - 32;
+    while(remaining > 0) {
+        size_t toRead = (size_t)std::min<long>(remaining, (long)buffer.size());
+        if(fread(buffer.data(), 1, toRead, file) != toRead) {
+            break;
+        }
+        EVP_DigestUpdate(mdctx, buffer.data(), toRead);
+        remaining -= toRead;
+    }
+
+    unsigned char digest[32];
+    unsigned int digestLength;
+    EVP_DigestFinal_ex(mdctx, digest, &digestLength);
+    EVP_MD_CTX_destroy(mdctx);
+
+    unsigned char storedDigest[32];
+    if(remaining != 0 || fread(storedDigest, 1, sizeof(storedDigest), file) != sizeof(storedDigest)
+       || memcmp(digest, storedDigest, sizeof(digest)) != 0) {
+        Log(LOG_LEVEL_ERROR) << "snapshot file " << cPath << " checksum mismatch";
+        fclose(file);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_SET);
+    CAutoFile filein(file, SER_DISK, SERIALIZATION_VERSION);
+
+    try {
+        SnapshotHeader snapshotHeader;
+        filein >> snapshotHeader;
+
+        if(snapshotHeader.magic != SNAPSHOT_MAGIC || snapshotHeader.version != SNAPSHOT_VERSION) {
+            Log(LOG_LEVEL_ERROR) << "unsupported snapshot version " << snapshotHeader.version;
+            return false;
+        }
+
+        // records are written in bounded block transactions, the best header only once all of them are written
+        // so a node interrupted while loading has no chain and can load the snapshot again
+        uint64_t recordCount = 0;
+        BlockHeader bestHeader;
+        db.beginBlockTransaction();
+        bool success = loadSnapshotRecords(filein, snapshotHeader, bestHeader, recordCount);
+        if(!success) {
+            db.abortBlockTransaction();
+            return false;
+        }
+
+        // snapshots of older nodes have heights as decimal keys
+        if(!db.commitBlockTransaction() || !db.migrateIntegerKeys(DB_BLOCK_HEADERS)) {
+            Log(LOG_LEVEL_ERROR) << "failed to write the snapshot to the stores";
+            return false;
+        }
+
+        std::vector<BlockHeader> bestBlockHeaders;
+        bestBlockHeaders.emplace_back(bestHeader);
+        db.beginBlockTransaction();
+        db.serializeToDb(DB_BLOCK_HEADERS, std::vector<unsigned char>(bestBlockHeadersKey.begin(), bestBlockHeadersKey.end()), bestBlockHeaders);
+
+        // the blocks up to the snapshot are neither stored nor undoable, peers asking for them are told so
+        BlockDatWriter& blockDatWriter = BlockDatWriter::Instance();
+        blockDatWriter.setPrunedBlockHeight(snapshotHeader.blockHeight);
+        if(!db.commitBlockTransaction()) {
+            Log(LOG_LEVEL_ERROR) << "failed to write the snapshot best header";
+            return false;
+        }
+
+        Log(LOG_LEVEL_INFO) << "loaded snapshot at height " << snapshotHeader.blockHeight
+                            << " with " << recordCount << " record(s)";
+    } catch (const std::exception& e) {
+        Log(LOG_LEVEL_ERROR) << "failed to read snapshot file " << cPath << ": " << e.what();
+        return false;
+    }
+
+    return true;
+}
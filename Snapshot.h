@@ -0,0 +1,75 @@
+
+#ifndef TX_SNAPSHOT_H
+#define TX_SNAPSHOT_H
+
+#include <cstdint>
+#include <vector>
+#include "serialize.h"
+
+#define SNAPSHOT_MAGIC 0x55424353 /* "UBCS" */
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_LOAD_BATCH_RECORDS 10000 /* records written with one block transaction when a snapshot is loaded */
+
+#define SNAPSHOT_RECORD_END 0x00
+#define SNAPSHOT_RECORD_DB_ENTRY 0x01
+#define SNAPSHOT_RECORD_CERT_FILE 0x02
+#define SNAPSHOT_RECORD_X509_FILE 0x03
+#define SNAPSHOT_RECORD_BEST_HEADER 0x04
+
+struct SnapshotHeader {
+    uint32_t magic = SNAPSHOT_MAGIC;
+    uint32_t version = SNAPSHOT_VERSION;
+    uint32_t blockHeight = 0;
+    std::vector<unsigned char> bestHeaderHash;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(magic);
+        READWRITE(version);
+        READWRITE(blockHeight);
+        READWRITE(bestHeaderHash);
+    }
+};
+
+/**
+ * A DB store entry, a certificate file or the best block header
+ * For files the key is the path relative to the certs/ or x509/ directory
+ */
+struct SnapshotRecord {
+    uint8_t type = SNAPSHOT_RECORD_END;
+    uint8_t store = 0;
+    std::vector<unsigned char> key;
+    std::vector<unsigned char> value;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(type);
+        READWRITE(store);
+        READWRITE(key);
+        READWRITE(value);
+    }
+};
+
+/**
+ * A snapshot is a SnapshotHeader followed by SnapshotRecords terminated by a SNAPSHOT_RECORD_END record
+ * and the raw SHA256 of everything before it.
+ * It holds the chain state at the best block, the PathSum is rebuilt from the block headers it contains.
+ * The stores only hold the state at the tip, a snapshot at a lower height is dumped when the chain reaches it.
+ */
+class SnapshotHelper {
+private:
+    static std::vector<unsigned char> scheduledPath;
+    static uint64_t scheduledHeight;
+public:
+    static bool dumpSnapshot(std::vector<unsigned char> path);
+    static void scheduleDump(std::vector<unsigned char> path, uint64_t blockHeight);
+    static void onBlockConnected(uint64_t blockHeight);
+    static bool loadSnapshot(std::vector<unsigned char> path);
+};
+
+
+#endif //TX_SNAPSHOT_H
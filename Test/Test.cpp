@@ -9,6 +9,10 @@
 #include "../TxPool.h"
 #include "../Wallet.h"
 #include "../Time.h"
+#include "../DB/DB.h"
+#include "../PathSum/PathSum.h"
+#include "../Block.h"
+#include "../Tools/Log.h"
 
 uint8_t Test::getCurrencyIdFromIso2Code(char* iso2code) {
     uint8_t currencyId = 0;
@@ -444,3 +448,380 @@ void Test::importDSCCerts(BlockHeader *header) {
     }
     Log(LOG_LEVEL_INFO) << "added: " << dscCounter << " csca certificates";
 }
+
+static bool expect(bool condition, const char* description) {
+    if(!condition) {
+        Log(LOG_LEVEL_ERROR) << "self test failed: " << description;
+    }
+    return condition;
+}
+
+/**
+ * Deterministic checks of consensus relevant code, run with --test
+ * Values written to the stores are part of a block transaction that is aborted at the end,
+ * the integer key migration is checked on a temporary database
+ */
+bool Test::runSelfTests() {
+    DB& db = DB::Instance();
+
+    bool success = Test::testIntegerKeys();
+
+    db.beginBlockTransaction();
+    success = Test::testPathSumPositions() && success;
+    success = Test::testPathSum() && success;
+    success = Test::testUAmount() && success;
+    success = Test::testPayouts() && success;
+    db.abortBlockTransaction();
+
+    Log(LOG_LEVEL_INFO) << (success ? "all self tests passed" : "self tests failed");
+
+    return success;
+}
+
+/**
+ * PathSum positions are block heights on fresh and on restarted nodes
+ * UBICalculator::totalReceivedUBI() adds up getSum(currency, DSC linked at height, height) ranges
+ */
+bool Test::testPathSumPositions() {
+    bool success = true;
+
+    // a fresh node, Loader::loadPathSum() appends block zero before the genesis block is connected
+    PathSum fresh;
+    fresh.appendValue(UAmount());
+
+    // a restarted node, Loader::loadPathSum() rebuilds block zero and then every block by height
+    PathSum restarted;
+    restarted.appendValue(UAmount());
+
+    for(uint64_t height = 1; height <= 5; height++) {
+        UAmount payout;
+        payout.map[CURRENCY_SWITZERLAND] = (CAmount)(height * 100);
+        fresh.appendValue(payout);
+        restarted.appendValue(payout);
+    }
+
+    // blocks 2, 3 and 4 for an address linked at height 2
+    success = expect(fresh.getSum(CURRENCY_SWITZERLAND, 2, 5) == 900, "fresh node UBI of blocks 2 to 4") && success;
+    success = expect(restarted.getSum(CURRENCY_SWITZERLAND, 2, 5) == 900, "restarted node UBI of blocks 2 to 4") && success;
+    success = expect(fresh.getSum(CURRENCY_SWITZERLAND, 1, 6) == 1500, "fresh node UBI since genesis") && success;
+    success = expect(fresh.getSum(CURRENCY_SWITZERLAND, 0, 1) == 0, "block zero pays nothing") && success;
+    success = expect(fresh.getStackHeight() == restarted.getStackHeight(), "same PathSum height") && success;
+
+    return success;
+}
+
+/**
+ * Range sums of a PathSum match the sums of the appended values after blocks are disconnected and connected again
+ */
+bool Test::testPathSum() {
+    bool success = true;
+
+    PathSum pathSum;
+    std::vector<std::map<uint8_t, CAmount> > values;
+    uint64_t seed = 42;
+
+    for(uint32_t round = 0; round < 4; round++) {
+        for(uint32_t i = 0; i < 40; i++) {
+            UAmount amount;
+            std::map<uint8_t, CAmount> value;
+            for(uint8_t currency = 1; currency <= 3; currency++) {
+                seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                CAmount payout = (seed >> 33) % 3 == 0 ? 0 : (CAmount)((seed >> 40) % 1000);
+                amount.map[currency] = payout;
+                value[currency] = payout;
+            }
+            pathSum.appendValue(amount);
+            values.emplace_back(value);
+        }
+
+        // a rollback of a few blocks
+        uint64_t popCount = 7 + round * 5;
+        pathSum.popValue(popCount);
+        values.resize(values.size() - popCount);
+    }
+
+    success = expect(!pathSum.popValue(pathSum.getStackHeight() + 1), "pop more values than the PathSum height") && success;
+    success = expect(pathSum.getStackHeight() == values.size(), "PathSum height after rollbacks") && success;
+
+    bool sumsMatch = true;
+    for(uint64_t start = 0; start <= values.size(); start++) {
+        std::map<uint8_t, CAmount> expected;
+        for(uint64_t end = start; end <= values.size() + 1; end++) {
+            UAmount sum = pathSum.getSum(start, end);
+            for(uint8_t currency = 1; currency <= 3; currency++) {
+                CAmount sumInMap = sum.map.count(currency) > 0 ? sum.map[currency] : 0;
+                sumsMatch = sumsMatch && pathSum.getSum(currency, start, end) == expected[currency];
+                sumsMatch = sumsMatch && sumInMap == expected[currency];
+            }
+
+            if(end < values.size()) {
+                for(auto& value : values[end]) {
+                    expected[value.first] += value.second;
+                }
+            }
+        }
+    }
+    success = expect(sumsMatch, "PathSum range sums match the appended values") && success;
+
+    return success;
+}
+
+template <typename Serializable>
+static std::string serializeToString(const Serializable& value) {
+    CDataStream s(SER_DISK, 1);
+    s << value;
+    return std::string(s.begin(), s.end());
+}
+
+/**
+ * UAmount operators as they were when UAmount was a std::map, absent currencies read as 0
+ */
+static std::map<uint8_t, CAmount> mapAdd(std::map<uint8_t, CAmount> amount, std::map<uint8_t, CAmount> other) {
+    for(auto& entry : other) {
+        amount[entry.first] += entry.second;
+    }
+    return amount;
+}
+
+static std::map<uint8_t, CAmount> mapSubtract(std::map<uint8_t, CAmount> amount, std::map<uint8_t, CAmount> other) {
+    for(auto& entry : other) {
+        amount[entry.first] = amount[entry.first] > entry.second ? amount[entry.first] - entry.second : 0;
+    }
+    return amount;
+}
+
+static bool mapEquals(std::map<uint8_t, CAmount>& amount, std::map<uint8_t, CAmount> other) {
+    bool equal = true;
+    for(auto& entry : amount) {
+        if(entry.second != other[entry.first]) {
+            equal = false;
+        }
+    }
+    for(auto& entry : other) {
+        if(entry.second != amount[entry.first]) {
+            equal = false;
+        }
+    }
+    return equal;
+}
+
+static bool mapCovers(std::map<uint8_t, CAmount> amount, std::map<uint8_t, CAmount> other, bool lessOrEqual) {
+    for(auto& entry : other) {
+        auto found = amount.find(entry.first);
+        if(found == amount.end() || (lessOrEqual ? found->second > entry.second : found->second < entry.second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * UAmount serializes like the std::map it replaced and its operators give the same results,
+ * including the currencies they make present
+ */
+bool Test::testUAmount() {
+    bool success = true;
+
+    // present zero values and currencies past the dense array are part of the encoding
+    std::vector<std::map<uint8_t, CAmount> > maps = {
+            {},
+            {{CURRENCY_SWITZERLAND, 5}, {CURRENCY_GERMANY, 0}, {40, 7}},
+            {{CURRENCY_SWITZERLAND, 5}, {40, 7}},
+            {{CURRENCY_SWITZERLAND, 2}, {CURRENCY_AUSTRIA, 9}},
+            {{0, 3}, {CURRENCY_SWITZERLAND, 6}, {40, 7}, {255, 1}},
+    };
+
+    bool encodingMatches = true;
+    bool operatorsMatch = true;
+    for(auto& map : maps) {
+        UAmount amount;
+        amount = map;
+        encodingMatches = encodingMatches && serializeToString(amount) == serializeToString(map);
+
+        CDataStream s(SER_DISK, 1);
+        s << map;
+        UAmount unserialized;
+        s >> unserialized;
+        encodingMatches = encodingMatches && serializeToString(unserialized) == serializeToString(map);
+
+        CAmount mapTotal = 0;
+        for(auto& entry : map) {
+            mapTotal += entry.second;
+        }
+        operatorsMatch = operatorsMatch && amount.total() == mapTotal && amount == mapTotal;
+
+        for(auto& otherMap : maps) {
+            UAmount other;
+            other = otherMap;
+
+            UAmount sum = amount + other;
+            UAmount difference = amount - other;
+            operatorsMatch = operatorsMatch && serializeToString(sum) == serializeToString(mapAdd(map, otherMap));
+            operatorsMatch = operatorsMatch && serializeToString(difference) == serializeToString(mapSubtract(map, otherMap));
+
+            UAmount added = amount;
+            added += other;
+            UAmount subtracted = amount;
+            subtracted -= other;
+            operatorsMatch = operatorsMatch && serializeToString(added) == serializeToString(sum);
+            operatorsMatch = operatorsMatch && serializeToString(subtracted) == serializeToString(difference);
+
+            operatorsMatch = operatorsMatch && (amount <= other) == mapCovers(map, otherMap, true);
+            operatorsMatch = operatorsMatch && (amount >= other) == mapCovers(map, otherMap, false);
+
+            UAmount compared = amount;
+            std::map<uint8_t, CAmount> comparedMap = map;
+            operatorsMatch = operatorsMatch && (compared == other) == mapEquals(comparedMap, otherMap);
+            operatorsMatch = operatorsMatch && serializeToString(compared) == serializeToString(comparedMap);
+            operatorsMatch = operatorsMatch && (compared != other) != mapEquals(comparedMap, otherMap);
+        }
+    }
+    success = expect(encodingMatches, "UAmount serializes like a std::map") && success;
+    success = expect(operatorsMatch, "UAmount operators match the std::map operators") && success;
+
+    return success;
+}
+
+/**
+ * Integer keys sort like the integers they encode and decimal string keys are migrated to them
+ */
+bool Test::testIntegerKeys() {
+    bool success = true;
+
+    std::vector<uint64_t> integers = {0, 1, 9, 10, 255, 256, 65535, 65536, 4294967295ULL, 4294967296ULL, 9223372036854775808ULL, 18446744073709551615ULL};
+
+    bool ordered = true;
+    bool parsed = true;
+    for(uint32_t i = 0; i < integers.size(); i++) {
+        uint64_t value = 0;
+        parsed = parsed && DB::parseIntegerKey(DB::integerKey(integers[i]), value) && value == integers[i];
+        if(i > 0) {
+            ordered = ordered && DB::integerKey(integers[i - 1]) < DB::integerKey(integers[i]);
+        }
+    }
+    success = expect(ordered, "integer keys sort in numeric order") && success;
+    success = expect(parsed, "integer keys parse back to their integer") && success;
+
+    uint64_t value = 0;
+    success = expect(!DB::parseIntegerKey(std::string(DB_INTEGER_KEY_SIZE - 1, (char)DB_INTEGER_KEY_TAG), value), "reject integer keys that are too short") && success;
+    success = expect(!DB::parseIntegerKey("12345678" + std::string(1, (char)DB_INTEGER_KEY_TAG), value), "reject keys without integer key tag") && success;
+
+    // the migration runs on a throwaway leveldb, once unprefixed and once with a store prefix like in single database mode
+    char cPath[512];
+    FS::charPathFromVectorPath(cPath, FS::concatPaths(FS::getBasePath(), "selfTestIntegerKeys.mdb"));
+    leveldb::DestroyDB(cPath, leveldb::Options());
+
+    leveldb::Options options;
+    options.create_if_missing = true;
+    leveldb::DB* testDb = nullptr;
+    if(!expect(leveldb::DB::Open(options, cPath, &testDb).ok(), "open temporary integer key database")) {
+        return false;
+    }
+
+    // a key starting with digits that doesn't fit a uint64_t, and another store's key that has to stay untouched
+    std::string tooLongKey = "123456789012345678901";
+    std::string otherStoreKey = std::string(1, (char)DB_PATH_SUM) + "42";
+    std::string payload = "payload";
+    uint64_t position = 18446744073709551000ULL;
+
+    for(std::string prefix : {std::string(), std::string(1, (char)DB_BLOCK_HEADERS)}) {
+        testDb->Put(leveldb::WriteOptions(), prefix + std::to_string(position), payload);
+        testDb->Put(leveldb::WriteOptions(), prefix + tooLongKey, payload);
+        if(!prefix.empty()) {
+            testDb->Put(leveldb::WriteOptions(), otherStoreKey, payload);
+        }
+
+        uint64_t keyCount = 0;
+        success = expect(DB::migrateIntegerKeys(testDb, prefix, keyCount) && keyCount == 1, "migrate decimal keys") && success;
+
+        std::string found;
+        success = expect(testDb->Get(leveldb::ReadOptions(), prefix + DB::integerKey(position), &found).ok() && found == payload, "migrated value under its integer key") && success;
+        success = expect(testDb->Get(leveldb::ReadOptions(), prefix + std::to_string(position), &found).IsNotFound(), "decimal key removed") && success;
+        success = expect(testDb->Get(leveldb::ReadOptions(), prefix + tooLongKey, &found).ok(), "keys that aren't integers are kept") && success;
+        if(!prefix.empty()) {
+            success = expect(testDb->Get(leveldb::ReadOptions(), otherStoreKey, &found).ok(), "keys of other stores are kept") && success;
+        }
+
+        success = expect(DB::migrateIntegerKeys(testDb, prefix, keyCount) && keyCount == 0, "migrating again finds nothing") && success;
+    }
+
+    delete testDb;
+    leveldb::DestroyDB(cPath, leveldb::Options());
+
+    return success;
+}
+
+/**
+ * Delegate, dev fund and UBI payouts on both sides of every halving, the expected values
+ * are computed the way they were before the payouts moved to a per currency parameter table
+ */
+bool Test::testPayouts() {
+    bool success = true;
+
+    bool halvingsMatch = true;
+    for(uint32_t halving = 0; halving <= NUMBER_OF_HALVINGS + 2; halving++) {
+        std::vector<uint32_t> heights = {halving * HALVING_INTERVAL_IN_BLOCKS};
+        if(halving > 0) {
+            heights.emplace_back(halving * HALVING_INTERVAL_IN_BLOCKS - 1);
+        }
+
+        for(uint32_t height : heights) {
+            int32_t halvingFactor = 1;
+            for(uint32_t i = 0; i < height / HALVING_INTERVAL_IN_BLOCKS && i < NUMBER_OF_HALVINGS; i++) {
+                halvingFactor = halvingFactor * 2;
+            }
+
+            UAmount delegatePayout;
+            UAmount devFundPayout;
+#define EXPECTED_PAYOUTS(NAME) \
+            delegatePayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_##NAME, (uint64_t)(CURRENCY_##NAME##_DELEGATE_PAYOUT / halvingFactor))); \
+            devFundPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_##NAME, (uint64_t)(CURRENCY_##NAME##_DEVELOPMENT_PAYOUT / halvingFactor)));
+            FOR_EACH_CURRENCY(EXPECTED_PAYOUTS)
+#undef EXPECTED_PAYOUTS
+
+            halvingsMatch = halvingsMatch && serializeToString(BlockHelper::calculateDelegatePayout(height)) == serializeToString(delegatePayout);
+            halvingsMatch = halvingsMatch && serializeToString(BlockHelper::calculateDevFundPayout(height)) == serializeToString(devFundPayout);
+        }
+    }
+    success = expect(halvingsMatch, "delegate and dev fund payouts at the halving boundaries") && success;
+    success = expect(BlockHelper::calculateDelegatePayout(UINT32_MAX) == BlockHelper::calculateDelegatePayout(NUMBER_OF_HALVINGS * HALVING_INTERVAL_IN_BLOCKS), "no halvings after the last one") && success;
+
+    UAmount totalPayout;
+#define EXPECTED_EMISSION(NAME) totalPayout.map.insert(std::pair<uint8_t, CAmount>(CURRENCY_##NAME, CURRENCY_##NAME##_EMISSION_RATE));
+    FOR_EACH_CURRENCY(EXPECTED_EMISSION)
+#undef EXPECTED_EMISSION
+    success = expect(serializeToString(BlockHelper::getTotalPayout()) == serializeToString(totalPayout), "emission rates") && success;
+
+    // the genesis block pays nothing but lists every currency
+    UAmount genesisPayout;
+    UAmount genesisPayoutRemainder;
+    BlockHelper::calculatePayout(nullptr, nullptr, UAmount32(), genesisPayout, genesisPayoutRemainder);
+    success = expect(genesisPayout.map.size() == CURRENCY_COUNT && genesisPayout.total() == 0, "genesis payout") && success;
+    success = expect(genesisPayoutRemainder.map.size() == CURRENCY_COUNT && genesisPayoutRemainder.total() == 0, "genesis payout remainder") && success;
+
+    // the emission and the previous remainder are split between the receivers, a currency without receivers pays nothing
+    UAmount previousRemainder;
+    UAmount32 receiverCount;
+    for(uint8_t currency = 1; currency <= CURRENCY_COUNT; currency++) {
+        previousRemainder.map[currency] = (CAmount)currency * 13;
+        receiverCount.map[currency] = currency == CURRENCY_MONACO ? 0 : (CAmount32)currency * 7919;
+    }
+    BlockHeader previousBlockHeader;
+    previousBlockHeader.setPayoutRemainder(previousRemainder);
+
+    UAmount payout;
+    UAmount payoutRemainder;
+    BlockHelper::calculatePayout(nullptr, &previousBlockHeader, receiverCount, payout, payoutRemainder);
+
+    bool splitMatches = payout.map.size() == CURRENCY_COUNT && payoutRemainder.map.size() == CURRENCY_COUNT;
+    for(uint8_t currency = 1; currency <= CURRENCY_COUNT; currency++) {
+        CAmount currencyTotal = totalPayout.map[currency] + previousRemainder.map[currency];
+        CAmount32 currencyReceivers = receiverCount.map[currency];
+        CAmount expectedPayout = currencyReceivers == 0 ? 0 : currencyTotal / currencyReceivers;
+        CAmount expectedRemainder = currencyReceivers == 0 ? 0 : currencyTotal % currencyReceivers;
+        splitMatches = splitMatches && payout.map[currency] == expectedPayout && payoutRemainder.map[currency] == expectedRemainder;
+    }
+    success = expect(splitMatches, "UBI payout and remainder") && success;
+
+    return success;
+}
@@ -11,6 +11,12 @@ public:
     static time_t ASN1_GetTimeT(ASN1_TIME* time);
     static void importCACerts(BlockHeader* header);
     static void importDSCCerts(BlockHeader* header);
+    static bool runSelfTests();
+    static bool testPathSumPositions();
+    static bool testPathSum();
+    static bool testUAmount();
+    static bool testIntegerKeys();
+    static bool testPayouts();
 };
 
 
@@ -174,7 +174,7 @@ Log& Log::operator<<(bool obj)
 
 Log& Log::operator<<(UAmount obj)
 {
-    for (std::map<uint8_t, CAmount>::const_iterator it(obj.map.begin()); it != obj.map.end(); ++it) {
+    for (auto it(obj.map.begin()); it != obj.map.end(); ++it) {
         std::cout << "[" << (int)it->first << ":" << it->second << "]";
         *currentStream << "[" << (int)it->first << ":" << it->second << "]";
     }
@@ -183,7 +183,7 @@ Log& Log::operator<<(UAmount obj)
 
 Log& Log::operator<<(UAmount32 obj)
 {
-    for (std::map<uint8_t, CAmount32>::const_iterator it(obj.map.begin()); it != obj.map.end(); ++it) {
+    for (auto it(obj.map.begin()); it != obj.map.end(); ++it) {
         std::cout << "[" << (int)it->first << ":" << it->second << "]";
         *currentStream << "[" << (int)it->first << ":" << it->second << "]";
     }
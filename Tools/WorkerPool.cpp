@@ -0,0 +1,91 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool() {
+    this->nextItem = 0;
+
+    uint32_t threadCount = std::thread::hardware_concurrency();
+
+    // the thread calling parallelFor() is the last worker
+    for(uint32_t i = 1; i < threadCount; i++) {
+        this->workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    jobMutex.lock();
+    this->stop = true;
+    jobMutex.unlock();
+    jobCondition.notify_all();
+
+    for(std::thread &worker : this->workers) {
+        worker.join();
+    }
+}
+
+size_t WorkerPool::getThreadCount() {
+    return this->workers.size() + 1;
+}
+
+void WorkerPool::runItems() {
+    size_t item;
+    while((item = this->nextItem++) < this->itemCount) {
+        this->job(item);
+    }
+}
+
+void WorkerPool::workerLoop() {
+    uint64_t lastGeneration = 0;
+
+    while(true) {
+        std::unique_lock<std::mutex> lock(jobMutex);
+        jobCondition.wait(lock, [&] { return this->stop || this->generation != lastGeneration; });
+
+        if(this->stop) {
+            return;
+        }
+
+        lastGeneration = this->generation;
+        lock.unlock();
+
+        this->runItems();
+
+        lock.lock();
+        this->busyWorkers--;
+        if(this->busyWorkers == 0) {
+            doneCondition.notify_all();
+        }
+    }
+}
+
+void WorkerPool::parallelFor(size_t count, std::function<void(size_t)> job) {
+    if(count == 0) {
+        return;
+    }
+
+    if(this->workers.empty() || count == 1) {
+        for(size_t i = 0; i < count; i++) {
+            job(i);
+        }
+        return;
+    }
+
+    runMutex.lock();
+
+    jobMutex.lock();
+    this->job = job;
+    this->itemCount = count;
+    this->nextItem = 0;
+    this->busyWorkers = this->workers.size();
+    this->generation++;
+    jobMutex.unlock();
+    jobCondition.notify_all();
+
+    this->runItems();
+
+    std::unique_lock<std::mutex> lock(jobMutex);
+    doneCondition.wait(lock, [&] { return this->busyWorkers == 0; });
+    this->job = nullptr;
+    lock.unlock();
+
+    runMutex.unlock();
+}
@@ -0,0 +1,45 @@
+
+#ifndef TX_WORKERPOOL_H
+#define TX_WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed pool of worker threads sized to the number of cores.
+ * parallelFor() blocks until every item has been processed, the calling thread works as well.
+ * Jobs must not call parallelFor() themselves.
+ */
+class WorkerPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex runMutex;
+    std::mutex jobMutex;
+    std::condition_variable jobCondition;
+    std::condition_variable doneCondition;
+    std::function<void(size_t)> job;
+    std::atomic<size_t> nextItem;
+    size_t itemCount = 0;
+    size_t busyWorkers = 0;
+    uint64_t generation = 0;
+    bool stop = false;
+    void workerLoop();
+    void runItems();
+public:
+    WorkerPool();
+    ~WorkerPool();
+    static WorkerPool& Instance(){
+        static WorkerPool instance;
+        return instance;
+    }
+    size_t getThreadCount();
+    void parallelFor(size_t count, std::function<void(size_t)> job);
+};
+
+
+#endif //TX_WORKERPOOL_H
@@ -80,6 +80,14 @@ uint32_t TransactionHelper::getTxSize(Transaction* tx) {
     return (uint32_t)s.size();
 }
 
+/**
+ * Binary key used to detect two transactions acting on the same input address, passport hash or vote target
+ * Hex encoding is only needed when the key is displayed
+ */
+std::string TransactionHelper::getInputKey(std::vector<unsigned char> input) {
+    return std::string(input.begin(), input.end());
+}
+
 std::vector<unsigned char> TransactionHelper::getPassportHash(Transaction* tx) {
     CDataStream srpScript(SER_DISK, 1);
     UScript script = tx->getTxIns().front().getScript();
@@ -155,6 +163,20 @@ bool TransactionHelper::isRegisterPassport(Transaction* tx) {
  * @return bool
  */
 bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeader* header) {
+    return TransactionHelper::verifyTx(tx, isInHeader, header, TX_VERIFY_ALL);
+}
+
+/**
+ * Checks that are cheap and only depend on the transaction itself always run.
+ * TX_VERIFY_PROOFS only reads the cert store, so it can run in parallel for the transactions of a block.
+ *
+ * @param tx
+ * @param isInHeader
+ * @param header
+ * @param verifyFlags TX_VERIFY_PROOFS, TX_VERIFY_STATE or TX_VERIFY_ALL
+ * @return bool
+ */
+bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeader* header, uint8_t verifyFlags) {
 
     Chain& chain = Chain::Instance();
     BlockHeader* bestHeader = chain.getBestBlockHeader();
@@ -189,11 +211,13 @@ bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeade
             return false;
         }
         totalInAmount += inAmount;
-        AddressForStore addressForStore = addressStore.getAddressFromStore(txIn->getInAddress());
-        addressAvailableAmount += AddressHelper::getAmountWithUBI(&addressForStore);
+        if(verifyFlags & TX_VERIFY_STATE) {
+            AddressForStore addressForStore = addressStore.getAddressFromStore(txIn->getInAddress());
+            addressAvailableAmount += AddressHelper::getAmountWithUBI(&addressForStore);
+        }
     }
 
-    if(!(addressAvailableAmount >= totalInAmount)) {
+    if((verifyFlags & TX_VERIFY_STATE) && !(addressAvailableAmount >= totalInAmount)) {
         Log(LOG_LEVEL_ERROR) << "Transaction "
                              << TransactionHelper::getTxId(tx)
                              << " is trying to spend more than it's balance "
@@ -247,7 +271,7 @@ bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeade
         switch (script.getScriptType()) {
 
             case SCRIPT_LINK: {
-                if(!TransactionHelper::verifyNonce(txIn->getInAddress(), txIn->getNonce())) {
+                if((verifyFlags & TX_VERIFY_STATE) && !TransactionHelper::verifyNonce(txIn->getInAddress(), txIn->getNonce())) {
                     Log(LOG_LEVEL_ERROR) << "wrong nonce " << txIn->getNonce()
                                          << " expected "
                                          << TransactionHelper::getNonce(txIn->getInAddress())
@@ -261,7 +285,7 @@ bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeade
                 break;
             }
             case SCRIPT_PKH: {
-                if(!TransactionHelper::verifyNonce(txIn->getInAddress(), txIn->getNonce())) {
+                if((verifyFlags & TX_VERIFY_STATE) && !TransactionHelper::verifyNonce(txIn->getInAddress(), txIn->getNonce())) {
                     Log(LOG_LEVEL_ERROR) << "wrong nonce " << txIn->getNonce()
                                          << " expected "
                                          << TransactionHelper::getNonce(txIn->getInAddress())
@@ -283,6 +307,10 @@ bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeade
                 //verify signature
                 switch(pkhInScript.getVersion()) {
                     case PKH_SECP256K1_VERSION: {
+                        if(!(verifyFlags & TX_VERIFY_PROOFS)) {
+                            break;
+                        }
+
                         Address recoveredAddress = Wallet::addressFromPublicKey(
                                 pkhInScript.publicKey
                         );
@@ -368,15 +396,17 @@ bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeade
                     std::vector<unsigned char> messageHash = ECCtools::bnToVector(ntpRskSignatureVerificationObject->getM());
                     std::vector<unsigned char> em = ECCtools::bnToVector(ntpRskSignatureVerificationObject->getPaddedM());
 
-                    Log(LOG_LEVEL_INFO) << "going to verify padding on: " << em;
-
                     //
                     //
                     // Begin of padding verification hack
                     //
                     //
 
-                    bool verifiedPadding = false;
+                    bool verifiedPadding = !(verifyFlags & TX_VERIFY_PROOFS);
+
+                    if(!verifiedPadding) {
+                        Log(LOG_LEVEL_INFO) << "going to verify padding on: " << em;
+                    }
 
                     std::vector<unsigned char> em2;
                     em2.emplace_back((unsigned char)0x00);
@@ -390,7 +420,7 @@ bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeade
 
                     asn1RSAWITHSHA256.insert(asn1RSAWITHSHA256.end(), messageHash.begin(), messageHash.end());
 
-                    if(RSA_padding_check_PKCS1_type_1(asn1RSAWITHSHA256.data(), (uint32_t)asn1RSAWITHSHA256.size(), em2.data(), (uint32_t)em2.size(), (uint32_t)em2.size()) >= 0) {
+                    if(!verifiedPadding && RSA_padding_check_PKCS1_type_1(asn1RSAWITHSHA256.data(), (uint32_t)asn1RSAWITHSHA256.size(), em2.data(), (uint32_t)em2.size(), (uint32_t)em2.size()) >= 0) {
                         Log(LOG_LEVEL_INFO) << "Register passport: PKCS1_type_1 verified with SHA256 ASN1";
                         verifiedPadding = true;
                     }
@@ -420,20 +450,23 @@ bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeade
 
                     // verify proof not already used
                     DB& db = DB::Instance();
-                    if(db.isInDB(DB_NTPSK_ALREADY_USED, ECCtools::bnToVector(ntpRskSignatureVerificationObject->getM()))) {
+                    if((verifyFlags & TX_VERIFY_STATE) && db.isInDB(DB_NTPSK_ALREADY_USED, ECCtools::bnToVector(ntpRskSignatureVerificationObject->getM()))) {
                         Log(LOG_LEVEL_ERROR) << "NtpRsk " << ECCtools::bnToVector(ntpRskSignatureVerificationObject->getM()) << " already used";
                         return false;
                     }
 
                     // Verify NtpEsk proof itself
-                    if(!NtpRsk::verifyNtpRsk(ntpRskSignatureVerificationObject)) {
+                    if((verifyFlags & TX_VERIFY_PROOFS) && !NtpRsk::verifyNtpRsk(ntpRskSignatureVerificationObject)) {
                         Log(LOG_LEVEL_ERROR) << "NtpRsk failed";
                         return false;
                     }
 
                     // verify address hasn't already a passport linked to it
                     std::vector<unsigned char> outAddress =  AddressHelper::addressLinkFromScript(txOuts.begin()->getScript());
-                    AddressForStore addressForStore = addressStore.getAddressFromStore(outAddress);
+                    AddressForStore addressForStore;
+                    if(verifyFlags & TX_VERIFY_STATE) {
+                        addressForStore = addressStore.getAddressFromStore(outAddress);
+                    }
 
                     if(addressForStore.getDSCLinkedAtHeight() != 0) {
                         Log(LOG_LEVEL_ERROR) << "Address " << outAddress << " has already a DSC linked to it ";
@@ -460,20 +493,23 @@ bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeade
 
                     // verify proof not already used
                     DB& db = DB::Instance();
-                    if(db.isInDB(DB_NTPSK_ALREADY_USED, ntpEskSignatureVerificationObject->getMessageHash())) {
+                    if((verifyFlags & TX_VERIFY_STATE) && db.isInDB(DB_NTPSK_ALREADY_USED, ntpEskSignatureVerificationObject->getMessageHash())) {
                         Log(LOG_LEVEL_ERROR) << "NtpEsk " << ntpEskSignatureVerificationObject->getMessageHash() << " already used";
                         return false;
                     }
 
                     // Verify NtpEsk proof itself
-                    if(!NtpEsk::verifyNtpEsk(ntpEskSignatureVerificationObject)) {
+                    if((verifyFlags & TX_VERIFY_PROOFS) && !NtpEsk::verifyNtpEsk(ntpEskSignatureVerificationObject)) {
                         Log(LOG_LEVEL_ERROR) << "NtpEsk failed";
                         return false;
                     }
 
                     // verify address hasn't already a passport linked to it
                     std::vector<unsigned char> outAddress =  AddressHelper::addressLinkFromScript(txOuts.begin()->getScript());
-                    AddressForStore addressForStore = addressStore.getAddressFromStore(outAddress);
+                    AddressForStore addressForStore;
+                    if(verifyFlags & TX_VERIFY_STATE) {
+                        addressForStore = addressStore.getAddressFromStore(outAddress);
+                    }
 
                     if(addressForStore.getDSCLinkedAtHeight() != 0) {
                         Log(LOG_LEVEL_ERROR) << "Address " << outAddress << " has already a DSC linked to it ";
@@ -542,32 +578,41 @@ bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeade
 
                 CertStore& certStore = CertStore::Instance();
 
-                if(addCertificateScript.isCSCA()) {
-                    if(!certStore.verifyAddCSCA(cert)) {
-                        return false;
-                    }
-                } else if(addCertificateScript.isDSC()) {
-                    if(!certStore.verifyAddDSC(cert, header->getBlockHeight())) {
-                        return false;
-                    }
+                if(!addCertificateScript.isCSCA() && !addCertificateScript.isDSC()) {
+                    Log(LOG_LEVEL_ERROR) << "unknown addCertificateScript type: " << addCertificateScript.type;
+                    return false;
                 }
 
-                if(!certStore.isCertSignedByUBICrootCert(cert, true, addCertificateScript.type)) {
-                    Log(LOG_LEVEL_ERROR) << "cert: " << cert->getId() << " is not signed by UBIC root Cert";
-                    return false;
+                if(verifyFlags & TX_VERIFY_STATE) {
+                    if(addCertificateScript.isCSCA()) {
+                        if(!certStore.verifyAddCSCA(cert)) {
+                            return false;
+                        }
+                    } else if(addCertificateScript.isDSC()) {
+                        if(!certStore.verifyAddDSC(cert, header->getBlockHeight())) {
+                            return false;
+                        }
+                    }
                 }
 
-                if(addCertificateScript.isCSCA()) {
-                    cert = certStore.getCscaCertWithCertId(txIn->getInAddress());
-                } else if(addCertificateScript.isDSC()) {
-                    if(!certStore.isCertSignedByCSCA(cert, chain.getCurrentBlockchainHeight())) {
+                if(verifyFlags & TX_VERIFY_PROOFS) {
+                    if(!certStore.isCertSignedByUBICrootCert(cert, true, addCertificateScript.type)) {
+                        Log(LOG_LEVEL_ERROR) << "cert: " << cert->getId() << " is not signed by UBIC root Cert";
+                        return false;
+                    }
+
+                    if(addCertificateScript.isDSC() && !certStore.isCertSignedByCSCA(cert, chain.getCurrentBlockchainHeight())) {
                         Log(LOG_LEVEL_ERROR) << "DSC: " << cert->getId() << " is not signed by a CSCA";
                         return false;
                     }
-                    cert = certStore.getDscCertWithCertId(txIn->getInAddress());
+                }
+
+                if(!(verifyFlags & TX_VERIFY_STATE)) {
+                    cert = nullptr;
+                } else if(addCertificateScript.isCSCA()) {
+                    cert = certStore.getCscaCertWithCertId(txIn->getInAddress());
                 } else {
-                    Log(LOG_LEVEL_ERROR) << "unknown addCertificateScript type: " << addCertificateScript.type;
-                    return false;
+                    cert = certStore.getDscCertWithCertId(txIn->getInAddress());
                 }
 
                 if(cert != nullptr) {
@@ -607,18 +652,20 @@ bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeade
                     return false;
                 }
 
-                if(deactivateCertificateScript.isDSC()) {
-                    cert = certStore.getDscCertWithCertId(deactivateCertificateScript.certificateId);
-                } else if(deactivateCertificateScript.isCSCA()) {
-                    cert = certStore.getCscaCertWithCertId(deactivateCertificateScript.certificateId);
-                }
+                if(verifyFlags & TX_VERIFY_STATE) {
+                    if(deactivateCertificateScript.isDSC()) {
+                        cert = certStore.getDscCertWithCertId(deactivateCertificateScript.certificateId);
+                    } else if(deactivateCertificateScript.isCSCA()) {
+                        cert = certStore.getCscaCertWithCertId(deactivateCertificateScript.certificateId);
+                    }
 
-                if(!deactivateCertificateScript.nonce != cert->getNonce()) {
-                    Log(LOG_LEVEL_ERROR) << "SCRIPT_DEACTIVATE_CERTIFICATE nonce mismatch";
-                    return false;
+                    if(!deactivateCertificateScript.nonce != cert->getNonce()) {
+                        Log(LOG_LEVEL_ERROR) << "SCRIPT_DEACTIVATE_CERTIFICATE nonce mismatch";
+                        return false;
+                    }
                 }
 
-                if(!certStore.isSignedByUBICrootCert(
+                if((verifyFlags & TX_VERIFY_PROOFS) && !certStore.isSignedByUBICrootCert(
                         TransactionHelper::getDeactivateCertificateScriptId(deactivateCertificateScript),
                         deactivateCertificateScript.rootCertSignature)
                   ) {
@@ -632,7 +679,7 @@ bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeade
             case SCRIPT_VOTE: {
                 std::vector<unsigned char> signature = txIn->getScript().getScript();
 
-                if(!VerifySignature::verify(txId, signature, txIn->getInAddress())) {
+                if((verifyFlags & TX_VERIFY_PROOFS) && !VerifySignature::verify(txId, signature, txIn->getInAddress())) {
                     Log(LOG_LEVEL_INFO) << "Signature : " << signature;
                     Log(LOG_LEVEL_INFO) << "getInAddress : " << txIn->getInAddress();
                     Log(LOG_LEVEL_ERROR) << "SCRIPT_VOTE signature verification failed";
@@ -659,7 +706,7 @@ bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeade
                 vote->setFromPubKey(txIn->getInAddress());
 
                 VoteStore& voteStore = VoteStore::Instance();
-                if(!voteStore.verifyVote(vote)) {
+                if((verifyFlags & TX_VERIFY_STATE) && !voteStore.verifyVote(vote)) {
                     Log(LOG_LEVEL_ERROR) << "voteStore.verifyVote failed";
                     return false;
                 }
@@ -678,12 +725,12 @@ bool TransactionHelper::verifyTx(Transaction* tx, uint8_t isInHeader, BlockHeade
 
     //verify fees
     //no fee verification for the genesis block or some kind of transactions
-    if(bestHeader != nullptr && needToPayFee) {
+    if((verifyFlags & TX_VERIFY_STATE) && bestHeader != nullptr && needToPayFee) {
         bool payedMinimumFee = false;
         UAmount payedFee = totalInAmount - totalOutAmount;
         UAmount calculatedMinimumFee = TransactionHelper::calculateMinimumFee(tx, bestHeader);
 
-        for (std::map<uint8_t, CAmount>::const_iterator it(payedFee.map.begin()); it != payedFee.map.end(); ++it) {
+        for (auto it(payedFee.map.begin()); it != payedFee.map.end(); ++it) {
             if(it->second >= calculatedMinimumFee.map[it->first]) {
                 payedMinimumFee = true;
             }
@@ -1060,7 +1107,7 @@ UAmount TransactionHelper::calculateMinimumFee(Transaction* transaction, BlockHe
     CDataStream s(SER_DISK, 1);
     s << *transaction;
 
-    for (std::map<uint8_t, CAmount>::const_iterator it(totalPayout.map.begin()); it != totalPayout.map.end(); ++it) {
+    for (auto it(totalPayout.map.begin()); it != totalPayout.map.end(); ++it) {
         rAmount.map[it->first] = it->second * s.size() * TXFEE_FACTOR;
     }
 
@@ -4,10 +4,15 @@
 
 #include <vector>
 #include <list>
+#include <string>
 #include "TxIn.h"
 #include "TxOut.h"
 #include "../BlockHeader.h"
 
+#define TX_VERIFY_PROOFS 0x01 // signatures, NtpRsk/NtpEsk proofs, certificate signatures, don't depend on chain state
+#define TX_VERIFY_STATE 0x02 // nonces, balances, already used proofs, certificate and delegate state
+#define TX_VERIFY_ALL 0x03
+
 class TransactionHelper {
 private:
     static bool verifyNonce(std::vector<unsigned char> inAddress, uint32_t nonce);
@@ -18,9 +23,11 @@ public:
     static std::vector<unsigned char> getTxHash(Transaction* tx);
     static uint32_t getTxSize(Transaction* tx);
     static std::vector<unsigned char> getPassportHash(Transaction* tx);
+    static std::string getInputKey(std::vector<unsigned char> input);
     static bool isVote(Transaction* tx);
     static bool isRegisterPassport(Transaction* tx);
     static bool verifyTx(Transaction* tx, uint8_t isInHeader,  BlockHeader* header);
+    static bool verifyTx(Transaction* tx, uint8_t isInHeader,  BlockHeader* header, uint8_t verifyFlags);
     static bool applyTransaction(Transaction* tx, BlockHeader* blockHeader);
     static bool undoTransaction(Transaction* tx, BlockHeader* blockHeader);
     static UAmount calculateMinimumFee(Transaction* transaction, BlockHeader* header);
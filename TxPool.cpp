@@ -12,7 +12,7 @@ bool TxPool::isTxInputPresent(TxIn txIn) {
         return false;
     }
 
-    std::unordered_map<std::string, TxIn>::iterator txInIt = this->txInputs.find(Hexdump::vectorToHexString(txIn.getInAddress()));
+    std::unordered_map<std::string, TxIn>::iterator txInIt = this->txInputs.find(TransactionHelper::getInputKey(txIn.getInAddress()));
     return txInIt != this->txInputs.end();
 }
 
@@ -20,7 +20,7 @@ bool TxPool::isTxInputPresent(Transaction* transaction) {
     if(TransactionHelper::isRegisterPassport(transaction)) {
         std::vector<unsigned char> passportHash = TransactionHelper::getPassportHash(transaction);
 
-        std::unordered_map<std::string, TxIn>::iterator txInIt = this->txInputs.find(Hexdump::vectorToHexString(passportHash));
+        std::unordered_map<std::string, TxIn>::iterator txInIt = this->txInputs.find(TransactionHelper::getInputKey(passportHash));
         return txInIt != this->txInputs.end();
     } else {
         for (TxIn txIn: transaction->getTxIns()) {
@@ -33,23 +33,23 @@ bool TxPool::isTxInputPresent(Transaction* transaction) {
     return false;
 }
 
-std::unordered_map<std::string, Transaction> TxPool::getTransactionList() {
+std::unordered_map<uint256, Transaction, BlobHasher> TxPool::getTransactionList() {
     return this->transactionList;
 }
 
-void TxPool::setTransactionList(std::unordered_map<std::string, Transaction> transactionList) {
+void TxPool::setTransactionList(std::unordered_map<uint256, Transaction, BlobHasher> transactionList) {
     this->transactionList = transactionList;
 }
 
 void TxPool::popTransaction(std::vector<unsigned char> txId) {
-    std::unordered_map<std::string, Transaction>::iterator txIt = this->transactionList.find(Hexdump::vectorToHexString(txId));
+    std::unordered_map<uint256, Transaction, BlobHasher>::iterator txIt = this->transactionList.find(uint256(txId));
     if(txIt != this->transactionList.end()) {
         for(TxIn txIn: txIt->second.getTxIns()) {
-            auto found = this->txInputs.find(Hexdump::vectorToHexString(txIn.getInAddress()));
+            auto found = this->txInputs.find(TransactionHelper::getInputKey(txIn.getInAddress()));
             this->txInputs.erase(found);
         }
 
-        this->transactionList.erase(Hexdump::vectorToHexString(txId));
+        this->transactionList.erase(txIt);
     } else {
         Log(LOG_LEVEL_INFO) << "popTransaction txId:" << txId << " not found";
     }
@@ -68,18 +68,18 @@ bool TxPool::appendTransaction(Transaction transaction) {
     }
 
     this->transactionList.insert(
-            std::pair<std::string, Transaction>(
-                    Hexdump::vectorToHexString(TransactionHelper::getTxId(&transaction)),
+            std::pair<uint256, Transaction>(
+                    uint256(TransactionHelper::getTxId(&transaction)),
                     transaction
             )
     );
 
     if(TransactionHelper::isRegisterPassport(&transaction)) {
         std::vector<unsigned char> passportHash = TransactionHelper::getPassportHash(&transaction);
-        this->txInputs.insert(std::make_pair(Hexdump::vectorToHexString(passportHash), transaction.getTxIns().front()));
+        this->txInputs.insert(std::make_pair(TransactionHelper::getInputKey(passportHash), transaction.getTxIns().front()));
     } else {
         for (TxIn txIn: transaction.getTxIns()) {
-            this->txInputs.insert(std::make_pair(Hexdump::vectorToHexString(txIn.getInAddress()), txIn));
+            this->txInputs.insert(std::make_pair(TransactionHelper::getInputKey(txIn.getInAddress()), txIn));
         }
     }
 
@@ -113,7 +113,7 @@ Transaction* TxPool::popTransaction() {
     this->transactionList.erase(tb->first);
 
     for(TxIn txIn: rval->getTxIns()) {
-        this->txInputs.erase(Hexdump::vectorToHexString(txIn.getInAddress()));
+        this->txInputs.erase(TransactionHelper::getInputKey(txIn.getInAddress()));
     }
 
     return rval;
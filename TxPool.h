@@ -7,11 +7,12 @@
 #include <unordered_map>
 #include "Transaction/Transaction.h"
 #include "Block.h"
+#include "uint256.h"
 
 class TxPool {
 private:
-    std::unordered_map<std::string, Transaction> transactionList;
-    std::unordered_map<std::string, TxIn> txInputs;
+    std::unordered_map<uint256, Transaction, BlobHasher> transactionList; // txId -> transaction
+    std::unordered_map<std::string, TxIn> txInputs; // binary input key -> input, see TransactionHelper::getInputKey()
 
     bool isTxInputPresent(TxIn txIn);
     bool isTxInputPresent(Transaction* transaction);
@@ -21,8 +22,8 @@ public:
         return instance;
     }
 
-    std::unordered_map<std::string, Transaction> getTransactionList();
-    void setTransactionList(std::unordered_map<std::string, Transaction> transactionList);
+    std::unordered_map<uint256, Transaction, BlobHasher> getTransactionList();
+    void setTransactionList(std::unordered_map<uint256, Transaction, BlobHasher> transactionList);
     void popTransaction(std::vector<unsigned char> txId);
     bool appendTransaction(Transaction transaction);
     void appendTransactionsFromBlock(Block* block);
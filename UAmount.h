@@ -5,336 +5,419 @@
 #include "serialize.h"
 #include "ChainParams.h"
 
+#include <map>
+#include <stdexcept>
 #include <stdlib.h>
 
 typedef uint64_t CAmount;
 typedef uint32_t CAmount32;
 
-struct UAmount {
-    std::map<uint8_t, CAmount> map;
+#define UAMOUNT_DENSE_CURRENCIES 32 /* currency ids below are stored inline, all valid currencies are */
 
-    uint64_t safeSub(uint64_t n1, uint64_t n2) {
-        if(n1 > n2) {
-            return n1 - n2;
-        }
-        return 0;
-    }
+template<typename T>
+struct CurrencyAmount {
+    uint8_t first;
+    T second;
+};
 
-    inline UAmount& operator=(const UAmount& other){
-        map = other.map;
-        return *this;
-    }
+/**
+ * Drop-in replacement of the std::map<uint8_t, T> UAmount used to be, amounts of the currencies
+ * below UAMOUNT_DENSE_CURRENCIES are an inline array with a presence bitmask.
+ * Absent currencies always hold 0 in the array, so the arithmetic below is plain loops over the whole array
+ * that the compiler vectorizes.
+ * Like a std::map an entry becomes present through operator[] or insert() and present entries with value 0
+ * are kept, iteration is in ascending currency order and serialization is byte for byte the one of the map.
+ */
+template<typename T>
+class CurrencyMap {
+public:
+    typedef CurrencyAmount<T> Entry;
+private:
+    Entry dense[UAMOUNT_DENSE_CURRENCIES];
+    uint32_t presence = 0;
+    std::map<uint8_t, Entry> overflow; // only invalid amounts use currency ids above the dense range
 
-    inline UAmount& operator=(const std::map<uint8_t, CAmount>& other){
-        map = other;
-        return *this;
+    static uint32_t bit(uint8_t currency) {
+        return (uint32_t)1 << currency;
     }
-
-    inline void operator+=(const UAmount& other) {
-        for (std::map<uint8_t, CAmount>::const_iterator it(other.map.begin()); it != other.map.end(); ++it) {
-            map[it->first] += it->second;
+public:
+    template<typename Container, typename EntryType, typename OverflowIterator>
+    class basic_iterator {
+    private:
+        Container* container;
+        uint32_t index; // UAMOUNT_DENSE_CURRENCIES once the dense entries are passed
+        OverflowIterator overflowIt;
+
+        void skipAbsent() {
+            while(this->index < UAMOUNT_DENSE_CURRENCIES && (this->container->presence & CurrencyMap::bit((uint8_t)this->index)) == 0) {
+                this->index++;
+            }
+            if(this->index == UAMOUNT_DENSE_CURRENCIES) {
+                this->overflowIt = this->container->overflow.begin();
+            }
         }
-    }
-
-    inline void operator-=(const UAmount& other) {
-        for (std::map<uint8_t, CAmount>::const_iterator it(other.map.begin()); it != other.map.end(); ++it) {
-            map[it->first] = safeSub(map[it->first],it->second);
+    public:
+        basic_iterator(Container* container, uint32_t index, OverflowIterator overflowIt) : container(container), index(index), overflowIt(overflowIt) {
+            if(this->index < UAMOUNT_DENSE_CURRENCIES) {
+                this->skipAbsent();
+            }
         }
-    }
 
-    inline void operator=(const CAmount other) {
-        if(other == 0) {
-            for (std::map<uint8_t, CAmount>::const_iterator it(map.begin()); it != map.end(); ++it) {
-                map[it->first] = 0;
+        template<typename OtherContainer, typename OtherEntryType, typename OtherOverflowIterator>
+        basic_iterator(const basic_iterator<OtherContainer, OtherEntryType, OtherOverflowIterator>& other) : container(other.container), index(other.index), overflowIt(other.overflowIt) {}
+
+        EntryType& operator*() const {
+            if(this->index < UAMOUNT_DENSE_CURRENCIES) {
+                return this->container->dense[this->index];
             }
+            return this->overflowIt->second;
         }
-    }
 
-    inline UAmount operator+(const UAmount& other) {
-        UAmount res;
-        for (std::map<uint8_t, CAmount>::const_iterator it(other.map.begin()); it != other.map.end(); ++it) {
-            res.map[it->first] += it->second;
+        EntryType* operator->() const {
+            return &(**this);
         }
 
-        for (std::map<uint8_t, CAmount>::const_iterator it(map.begin()); it != map.end(); ++it) {
-            res.map[it->first] += it->second;
+        basic_iterator& operator++() {
+            if(this->index < UAMOUNT_DENSE_CURRENCIES) {
+                this->index++;
+                this->skipAbsent();
+            } else {
+                ++this->overflowIt;
+            }
+            return *this;
         }
-        return res;
-    }
-
-    inline UAmount operator-(const UAmount& other) {
-        UAmount res;
 
-        for (std::map<uint8_t, CAmount>::const_iterator it(map.begin()); it != map.end(); ++it) {
-            res.map[it->first] = it->second;
+        basic_iterator operator++(int) {
+            basic_iterator previous = *this;
+            ++(*this);
+            return previous;
         }
 
-        for (std::map<uint8_t, CAmount>::const_iterator it(other.map.begin()); it != other.map.end(); ++it) {
-            res.map[it->first] = safeSub(res.map[it->first], it->second);
+        bool operator==(const basic_iterator& other) const {
+            return this->index == other.index && (this->index < UAMOUNT_DENSE_CURRENCIES || this->overflowIt == other.overflowIt);
         }
 
-        return res;
-    }
-
-    inline bool operator==(const UAmount& other) {
-        bool equal = true;
-        std::map<uint8_t, CAmount> otherMap = other.map;
-
-        for (std::map<uint8_t, CAmount>::const_iterator it(map.begin()); it != map.end(); ++it) {
-            if(it->second != otherMap[it->first]) {
-                equal = false;
-            }
-        }
-        for (std::map<uint8_t, CAmount>::const_iterator it(otherMap.begin()); it != otherMap.end(); ++it) {
-            if(it->second != map[it->first]) {
-                equal = false;
-            }
+        bool operator!=(const basic_iterator& other) const {
+            return !(*this == other);
         }
 
-        return equal;
-    }
+        template<typename, typename, typename> friend class basic_iterator;
+    };
 
-    inline bool operator!=(const UAmount& other) {
-        bool notEqual = false;
-        std::map<uint8_t, CAmount> otherMap = other.map;
+    typedef basic_iterator<CurrencyMap, Entry, typename std::map<uint8_t, Entry>::iterator> iterator;
+    typedef basic_iterator<const CurrencyMap, const Entry, typename std::map<uint8_t, Entry>::const_iterator> const_iterator;
 
-        for (std::map<uint8_t, CAmount>::const_iterator it(map.begin()); it != map.end(); ++it) {
-            if(it->second != otherMap[it->first]) {
-                notEqual = true;
-            }
-        }
-        for (std::map<uint8_t, CAmount>::const_iterator it(otherMap.begin()); it != otherMap.end(); ++it) {
-            if(it->second != map[it->first]) {
-                notEqual = true;
-            }
+    CurrencyMap() {
+        for(uint32_t i = 0; i < UAMOUNT_DENSE_CURRENCIES; i++) {
+            this->dense[i].first = (uint8_t)i;
+            this->dense[i].second = 0;
         }
+    }
 
-        return notEqual;
+    iterator begin() {
+        return iterator(this, 0, this->overflow.begin());
     }
 
-    inline bool operator==(CAmount other) const {
-        return (total() == other);
+    iterator end() {
+        return iterator(this, UAMOUNT_DENSE_CURRENCIES, this->overflow.end());
     }
 
-    inline bool operator!=(CAmount other) const {
-        return (total() != other);
+    const_iterator begin() const {
+        return const_iterator(this, 0, this->overflow.begin());
     }
 
-    inline bool operator<=(const UAmount& other) {
-        bool result = true;
+    const_iterator end() const {
+        return const_iterator(this, UAMOUNT_DENSE_CURRENCIES, this->overflow.end());
+    }
 
-        for (std::map<uint8_t, CAmount>::const_iterator it(other.map.begin()); it != other.map.end(); ++it) {
-            if(map.find(it->first) == map.end() || map[it->first] > it->second) {
-                result = false;
-            }
+    T& operator[](uint8_t currency) {
+        if(currency < UAMOUNT_DENSE_CURRENCIES) {
+            this->presence |= bit(currency);
+            return this->dense[currency].second;
         }
 
-        return result;
+        Entry& entry = this->overflow[currency];
+        entry.first = currency;
+        return entry.second;
     }
 
-    inline bool operator>=(const UAmount& other) {
-        bool result = true;
-
-        for (std::map<uint8_t, CAmount>::const_iterator it(other.map.begin()); it != other.map.end(); ++it) {
-            if(map.find(it->first) == map.end() || map[it->first] < it->second) {
-                result = false;
-            }
+    bool contains(uint8_t currency) const {
+        if(currency < UAMOUNT_DENSE_CURRENCIES) {
+            return (this->presence & bit(currency)) != 0;
         }
+        return this->overflow.count(currency) > 0;
+    }
 
-        return result;
+    iterator find(uint8_t currency) {
+        if(!this->contains(currency)) {
+            return this->end();
+        }
+        if(currency < UAMOUNT_DENSE_CURRENCIES) {
+            return iterator(this, currency, this->overflow.begin());
+        }
+        return iterator(this, UAMOUNT_DENSE_CURRENCIES, this->overflow.find(currency));
     }
 
-    inline bool operator<(CAmount other) const {
-        return (total() < other);
+    const_iterator find(uint8_t currency) const {
+        if(!this->contains(currency)) {
+            return this->end();
+        }
+        if(currency < UAMOUNT_DENSE_CURRENCIES) {
+            return const_iterator(this, currency, this->overflow.begin());
+        }
+        return const_iterator(this, UAMOUNT_DENSE_CURRENCIES, this->overflow.find(currency));
     }
 
-    inline bool operator>(CAmount other) const {
-        return (total() > other);
+    const T& at(uint8_t currency) const {
+        if(!this->contains(currency)) {
+            throw std::out_of_range("CurrencyMap::at(): currency not present");
+        }
+        if(currency < UAMOUNT_DENSE_CURRENCIES) {
+            return this->dense[currency].second;
+        }
+        return this->overflow.find(currency)->second.second;
     }
 
-    inline bool operator<=(CAmount other) const {
-        return (total() <= other);
+    /**
+     * Like std::map::insert() an already present currency keeps its value
+     */
+    template<typename K, typename V>
+    std::pair<iterator, bool> insert(const std::pair<K, V>& value) {
+        uint8_t currency = (uint8_t)value.first;
+        bool inserted = !this->contains(currency);
+        if(inserted) {
+            (*this)[currency] = (T)value.second;
+        }
+        return std::make_pair(this->find(currency), inserted);
     }
 
-    inline bool operator>=(CAmount other) const {
-        return (total() >= other);
+    size_t count(uint8_t currency) const {
+        return this->contains(currency) ? 1 : 0;
     }
 
-    CAmount total() const
-    {
-        CAmount total = 0;
-        for (std::map<uint8_t, CAmount>::const_iterator it(map.begin()); it != map.end(); ++it) {
-            total += it->second;
+    size_t size() const {
+        size_t size = this->overflow.size();
+        for(uint32_t presence = this->presence; presence != 0; presence &= presence - 1) {
+            size++;
         }
-        return total;
+        return size;
     }
 
-    ADD_SERIALIZE_METHODS;
-
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action) {
-        READWRITE(map);
+    bool empty() const {
+        return this->presence == 0 && this->overflow.empty();
     }
-};
-
-
-struct UAmount32 {
-    std::map<uint8_t, CAmount32> map;
 
-    uint32_t safeSub(uint32_t n1, uint32_t n2) {
-        if(n1 > n2) {
-            return n1 - n2;
+    size_t erase(uint8_t currency) {
+        if(!this->contains(currency)) {
+            return 0;
         }
-        return 0;
+        if(currency < UAMOUNT_DENSE_CURRENCIES) {
+            this->presence &= ~bit(currency);
+            this->dense[currency].second = 0;
+            return 1;
+        }
+        return this->overflow.erase(currency);
     }
 
-    inline UAmount32& operator=(const UAmount32& other){
-        map = other.map;
-        return *this;
+    void clear() {
+        for(uint32_t i = 0; i < UAMOUNT_DENSE_CURRENCIES; i++) {
+            this->dense[i].second = 0;
+        }
+        this->presence = 0;
+        this->overflow.clear();
     }
 
-    inline UAmount32& operator=(const std::map<uint8_t, CAmount32>& other){
-        map = other;
-        return *this;
+    /**
+     * Currencies of other become present
+     */
+    void add(const CurrencyMap& other) {
+        for(uint32_t i = 0; i < UAMOUNT_DENSE_CURRENCIES; i++) {
+            this->dense[i].second += other.dense[i].second;
+        }
+        this->presence |= other.presence;
+        for(auto& entry : other.overflow) {
+            (*this)[entry.first] += entry.second.second;
+        }
     }
 
-    inline void operator+=(const UAmount32& other) {
-        for (std::map<uint8_t, CAmount32>::const_iterator it(other.map.begin()); it != other.map.end(); ++it) {
-            map[it->first] += it->second;
+    /**
+     * Currencies of other become present, values don't go below 0
+     */
+    void subtractSaturating(const CurrencyMap& other) {
+        for(uint32_t i = 0; i < UAMOUNT_DENSE_CURRENCIES; i++) {
+            T value = this->dense[i].second;
+            T otherValue = other.dense[i].second;
+            this->dense[i].second = value > otherValue ? value - otherValue : 0;
+        }
+        this->presence |= other.presence;
+        for(auto& entry : other.overflow) {
+            T& value = (*this)[entry.first];
+            value = value > entry.second.second ? value - entry.second.second : 0;
         }
     }
 
-    inline void operator-=(const UAmount32& other) {
-        for (std::map<uint8_t, CAmount32>::const_iterator it(other.map.begin()); it != other.map.end(); ++it) {
-            map[it->first] = safeSub(map[it->first],it->second);
+    /**
+     * Absent currencies compare as 0
+     */
+    bool equals(const CurrencyMap& other) const {
+        bool equal = true;
+        for(uint32_t i = 0; i < UAMOUNT_DENSE_CURRENCIES; i++) {
+            equal &= this->dense[i].second == other.dense[i].second;
         }
+        for(auto& entry : this->overflow) {
+            auto found = other.overflow.find(entry.first);
+            equal &= entry.second.second == (found == other.overflow.end() ? 0 : found->second.second);
+        }
+        for(auto& entry : other.overflow) {
+            auto found = this->overflow.find(entry.first);
+            equal &= entry.second.second == (found == this->overflow.end() ? 0 : found->second.second);
+        }
+        return equal;
     }
 
-    inline void operator=(const CAmount32 other) {
-        if(other == 0) {
-            for (std::map<uint8_t, CAmount32>::const_iterator it(map.begin()); it != map.end(); ++it) {
-                map[it->first] = 0;
-            }
+    /**
+     * True if every currency of other is present and its value compares true with the value of other
+     */
+    template<typename Compare>
+    bool coversAll(const CurrencyMap& other, Compare compare) const {
+        if((other.presence & ~this->presence) != 0) {
+            return false;
+        }
+        bool result = true;
+        for(uint32_t i = 0; i < UAMOUNT_DENSE_CURRENCIES; i++) {
+            result &= (other.presence & bit((uint8_t)i)) == 0 || compare(this->dense[i].second, other.dense[i].second);
+        }
+        for(auto& entry : other.overflow) {
+            auto found = this->overflow.find(entry.first);
+            result &= found != this->overflow.end() && compare(found->second.second, entry.second.second);
         }
+        return result;
     }
 
-    inline UAmount32 operator+(const UAmount32& other) {
-        UAmount32 res;
-        for (std::map<uint8_t, CAmount32>::const_iterator it(other.map.begin()); it != other.map.end(); ++it) {
-            res.map[it->first] += it->second;
+    T total() const {
+        T total = 0;
+        for(uint32_t i = 0; i < UAMOUNT_DENSE_CURRENCIES; i++) {
+            total += this->dense[i].second;
         }
-
-        for (std::map<uint8_t, CAmount32>::const_iterator it(map.begin()); it != map.end(); ++it) {
-            res.map[it->first] += it->second;
+        for(auto& entry : this->overflow) {
+            total += entry.second.second;
         }
-        return res;
+        return total;
     }
 
-    inline UAmount32 operator-(const UAmount32& other) {
-        UAmount32 res;
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        WriteCompactSize(s, this->size());
+        for(const Entry& entry : *this) {
+            ::Serialize(s, entry.first);
+            ::Serialize(s, entry.second);
+        }
+    }
 
-        for (std::map<uint8_t, CAmount32>::const_iterator it(map.begin()); it != map.end(); ++it) {
-            res.map[it->first] = it->second;
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        this->clear();
+        unsigned int nSize = ReadCompactSize(s);
+        for(unsigned int i = 0; i < nSize; i++) {
+            uint8_t currency;
+            T value;
+            ::Unserialize(s, currency);
+            ::Unserialize(s, value);
+            this->insert(std::make_pair(currency, value));
         }
+    }
+};
 
-        for (std::map<uint8_t, CAmount32>::const_iterator it(other.map.begin()); it != other.map.end(); ++it) {
-            res.map[it->first] = safeSub(res.map[it->first],it->second);
+template<typename T>
+struct BasicUAmount {
+    CurrencyMap<T> map;
+
+    inline BasicUAmount& operator=(const std::map<uint8_t, T>& other){
+        map.clear();
+        for(auto& entry : other) {
+            map[entry.first] = entry.second;
         }
+        return *this;
+    }
 
-        return res;
+    inline void operator+=(const BasicUAmount& other) {
+        map.add(other.map);
     }
 
-    inline bool operator==(const UAmount32& other) {
-        bool equal = true;
-        std::map<uint8_t, CAmount32> otherMap = other.map;
+    inline void operator-=(const BasicUAmount& other) {
+        map.subtractSaturating(other.map);
+    }
 
-        for (std::map<uint8_t, CAmount32>::const_iterator it(map.begin()); it != map.end(); ++it) {
-            if(it->second != otherMap[it->first]) {
-                equal = false;
-            }
-        }
-        for (std::map<uint8_t, CAmount32>::const_iterator it(otherMap.begin()); it != otherMap.end(); ++it) {
-            if(it->second != map[it->first]) {
-                equal = false;
+    inline void operator=(const T other) {
+        if(other == 0) {
+            for(auto& entry : map) {
+                entry.second = 0;
             }
         }
+    }
 
-        return equal;
+    inline BasicUAmount operator+(const BasicUAmount& other) const {
+        BasicUAmount res = *this;
+        res.map.add(other.map);
+        return res;
     }
 
-    inline bool operator!=(const UAmount32& other) {
-        bool notEqual = false;
-        std::map<uint8_t, CAmount32> otherMap = other.map;
+    inline BasicUAmount operator-(const BasicUAmount& other) const {
+        BasicUAmount res = *this;
+        res.map.subtractSaturating(other.map);
+        return res;
+    }
 
-        for (std::map<uint8_t, CAmount32>::const_iterator it(map.begin()); it != map.end(); ++it) {
-            if(it->second != otherMap[it->first]) {
-                notEqual = true;
-            }
-        }
-        for (std::map<uint8_t, CAmount32>::const_iterator it(otherMap.begin()); it != otherMap.end(); ++it) {
-            if(it->second != map[it->first]) {
-                notEqual = true;
-            }
+    /**
+     * The map based comparison inserted the currencies of other into this one, they stay present
+     * so amounts serialize the same way they always did
+     */
+    inline bool operator==(const BasicUAmount& other) {
+        bool equal = map.equals(other.map);
+        for(auto& entry : other.map) {
+            map[entry.first];
         }
+        return equal;
+    }
 
-        return notEqual;
+    inline bool operator!=(const BasicUAmount& other) {
+        return !(*this == other);
     }
 
-    inline bool operator==(CAmount32 other) const {
+    inline bool operator==(T other) const {
         return (total() == other);
     }
 
-    inline bool operator!=(CAmount32 other) const {
+    inline bool operator!=(T other) const {
         return (total() != other);
     }
 
-    inline bool operator<=(const UAmount32& other) {
-        bool result = true;
-
-        for (std::map<uint8_t, CAmount32>::const_iterator it(other.map.begin()); it != other.map.end(); ++it) {
-            if(map.find(it->first) == map.end() || map[it->first] > it->second) {
-                result = false;
-            }
-        }
-
-        return result;
+    inline bool operator<=(const BasicUAmount& other) const {
+        return map.coversAll(other.map, [](T value, T otherValue) { return value <= otherValue; });
     }
 
-    inline bool operator>=(const UAmount32& other) {
-        bool result = true;
-
-        for (std::map<uint8_t, CAmount32>::const_iterator it(other.map.begin()); it != other.map.end(); ++it) {
-            if(map.find(it->first) == map.end() || map[it->first] < it->second) {
-                result = false;
-            }
-        }
-
-        return result;
+    inline bool operator>=(const BasicUAmount& other) const {
+        return map.coversAll(other.map, [](T value, T otherValue) { return value >= otherValue; });
     }
 
-    inline bool operator<(CAmount32 other) const {
+    inline bool operator<(T other) const {
         return (total() < other);
     }
 
-    inline bool operator>(CAmount32 other) const {
+    inline bool operator>(T other) const {
         return (total() > other);
     }
 
-    inline bool operator<=(CAmount32 other) const {
+    inline bool operator<=(T other) const {
         return (total() <= other);
     }
 
-    inline bool operator>=(CAmount32 other) const {
+    inline bool operator>=(T other) const {
         return (total() >= other);
     }
 
-    CAmount32 total() const
-    {
-        CAmount32 total = 0;
-        for (std::map<uint8_t, CAmount32>::const_iterator it(map.begin()); it != map.end(); ++it) {
-            total += it->second;
-        }
-        return total;
+    T total() const {
+        return map.total();
     }
 
     ADD_SERIALIZE_METHODS;
@@ -345,6 +428,9 @@ struct UAmount32 {
     }
 };
 
+typedef BasicUAmount<CAmount> UAmount;
+typedef BasicUAmount<CAmount32> UAmount32;
+
 class UAmountHelper {
 public:
     static bool isValidAmount(UAmount amount) {
@@ -352,7 +438,7 @@ public:
             return true;
         }
 
-        for (std::map<uint8_t, CAmount>::const_iterator it(amount.map.begin()); it != amount.map.end(); ++it) {
+        for (auto it(amount.map.begin()); it != amount.map.end(); ++it) {
             if(!(it->first == CURRENCY_SWITZERLAND ||
                  it->first == CURRENCY_GERMANY ||
                  it->first == CURRENCY_AUSTRIA ||
@@ -85,10 +85,10 @@ UAmount UBICalculator::totalReceivedUBI(AddressForStore* addressForStore, uint32
             //do nothing
         } else if(startHeight > pair.first) {
             // take pair between startHeight and pair.second
-            totalAmount.map[cert->getCurrencyId()] += pathSum.getSum(startHeight, pair.second).map[cert->getCurrencyId()]; // @TODO can be performance optimized
+            totalAmount.map[cert->getCurrencyId()] += pathSum.getSum(cert->getCurrencyId(), startHeight, pair.second);
         } else if(startHeight < pair.first) {
             //take entire pair
-            totalAmount.map[cert->getCurrencyId()] += pathSum.getSum(pair.first, pair.second).map[cert->getCurrencyId()];
+            totalAmount.map[cert->getCurrencyId()] += pathSum.getSum(cert->getCurrencyId(), pair.first, pair.second);
         }
     }
 
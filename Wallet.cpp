@@ -271,7 +271,7 @@ Transaction* Wallet::payToTxOutputsWithoutFees(std::vector<TxOut> txOutputs) {
         UAmount addressAmount = AddressHelper::getAmountWithUBI(&addressForStore);
         TxIn txIn;
         // iterate through all currencies of the address
-        for (std::map<uint8_t, CAmount>::iterator it = addressAmount.map.begin(); it != addressAmount.map.end(); ++it)
+        for (auto it = addressAmount.map.begin(); it != addressAmount.map.end(); ++it)
         {
             auto cToSpend = toSpend.map.find(it->first);
             if(cToSpend != toSpend.map.end()) {
@@ -485,14 +485,16 @@ std::vector<TransactionForStore> Wallet::getMyTransactions() {
     Log(LOG_LEVEL_INFO) << "getMyTransactions() ";
 
     std::vector<TransactionForStore> response;
-    std::vector< std::vector<unsigned char> > keys = db.getAllKeys(DB_MY_TRANSACTIONS);
 
-    for(std::vector<unsigned char> key : keys) {
-        Log(LOG_LEVEL_INFO) << "key: " << key;
+    // keyed by timestamp, the iterator is in chronological order
+    DBIterator* it = db.newIterator(DB_MY_TRANSACTIONS, 0, UINT64_MAX);
+    for(; it->valid(); it->next()) {
         TransactionForStore transaction;
-        db.deserializeFromDb(DB_MY_TRANSACTIONS, key, transaction);
-        response.emplace_back(transaction);
+        if(it->deserializeValue(transaction)) {
+            response.emplace_back(transaction);
+        }
     }
+    delete it;
 
     Log(LOG_LEVEL_INFO) << "My transactions count: " << (uint64_t)response.size();
 
@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <iostream>
 #include <boost/asio/io_service.hpp>
 #include <thread>
@@ -17,6 +18,10 @@
 #include "Config.h"
 #include "App.h"
 #include "Network/Network.h"
+#include "Snapshot.h"
+#include "Reindex.h"
+#include "Chain.h"
+#include "DB/DB.h"
 
 void startSync() {
     Network &network = Network::Instance();
@@ -79,7 +84,7 @@ BOOL WINAPI signalHandler(DWORD signal) {
 }
 #endif
 
-int main() {
+int main(int argc, char* argv[]) {
 
     Log(LOG_LEVEL_INFO) << "Starting UBIC version " << VERSION;
 
@@ -91,6 +96,57 @@ int main() {
         return 0;
     }
 
+    std::string dumpSnapshotPath;
+    uint64_t snapshotHeight = 0;
+    std::string loadSnapshotPath;
+    bool reindex = false;
+    bool runSelfTests = false;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--reindex") == 0) {
+            reindex = true;
+        } else if(strcmp(argv[i], "--test") == 0) {
+            runSelfTests = true;
+        }
+    }
+    for(int i = 1; i + 1 < argc; i++) {
+        if(strcmp(argv[i], "--dump-snapshot") == 0) {
+            dumpSnapshotPath = argv[++i];
+        } else if(strcmp(argv[i], "--snapshot-height") == 0) {
+            snapshotHeight = std::strtoull(argv[++i], nullptr, 10);
+        } else if(strcmp(argv[i], "--load-snapshot") == 0) {
+            loadSnapshotPath = argv[++i];
+        }
+    }
+
+    // --test runs the self tests against the configured stores and exits
+    if(runSelfTests) {
+        Loader::createTouchFilesAndDirectories();
+        Loader::loadConfig();
+        if(!DB::Instance().isOpen()) {
+            Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to open the database";
+            return 1;
+        }
+
+        return Test::runSelfTests() ? 0 : 1;
+    }
+
+    // --dump-snapshot <path> writes the chain state at the best block and exits
+    // with --snapshot-height <height> the node runs until its chain reaches that height and dumps it then
+    if(!dumpSnapshotPath.empty() && snapshotHeight > 0) {
+        SnapshotHelper::scheduleDump(std::vector<unsigned char>(dumpSnapshotPath.begin(), dumpSnapshotPath.end()), snapshotHeight);
+    } else if(!dumpSnapshotPath.empty()) {
+        Loader::createTouchFilesAndDirectories();
+        Loader::loadConfig();
+        if(!DB::Instance().isOpen()) {
+            Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to open the database";
+            return 1;
+        }
+        Loader::loadBestBlockHeaders();
+        Loader::loadHeaderIndex();
+
+        return SnapshotHelper::dumpSnapshot(std::vector<unsigned char>(dumpSnapshotPath.begin(), dumpSnapshotPath.end())) ? 0 : 1;
+    }
+
 
 
 #if defined(__linux__)
@@ -139,12 +195,49 @@ int main() {
     //Loader::lock();
     Loader::createTouchFilesAndDirectories();
     Loader::loadConfig();
+
+    if(!DB::Instance().isOpen()) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to open the database, see the errors above";
+        return 1;
+    }
+
+    // --load-snapshot <path> bootstraps an empty node, syncing continues from the snapshot height
+    if(!loadSnapshotPath.empty() && !SnapshotHelper::loadSnapshot(std::vector<unsigned char>(loadSnapshotPath.begin(), loadSnapshotPath.end()))) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to load snapshot " << loadSnapshotPath
+                                      << ", the blockchain directory has to be emptied before trying again";
+        return 1;
+    }
+
+    // --reindex rebuilds the chain state from the local blockdat files
+    Reindex& reindexer = Reindex::Instance();
+    if(reindex && !reindexer.prepare()) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to prepare reindex";
+        return 1;
+    }
+
     Loader::loadDelegates();
     Loader::loadBestBlockHeaders();
+    Loader::loadHeaderIndex();
     Loader::loadCertStore();
     Loader::loadPathSum();
     Loader::loadWallet();
 
+    if(reindex && !reindexer.run()) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Failed to reindex, restart with --reindex to try again";
+        return 1;
+    }
+
+    // the state below the tip isn't kept, a snapshot height we are already past can't be dumped anymore
+    Chain& chain = Chain::Instance();
+    if(snapshotHeight > 0 && chain.getCurrentBlockchainHeight() > snapshotHeight) {
+        Log(LOG_LEVEL_CRITICAL_ERROR) << "Cannot dump a snapshot at height " << snapshotHeight
+                                      << ", the chain is already at height " << chain.getCurrentBlockchainHeight();
+        return 1;
+    }
+    if(snapshotHeight > 0 && chain.getCurrentBlockchainHeight() == snapshotHeight) {
+        return SnapshotHelper::dumpSnapshot(std::vector<unsigned char>(dumpSnapshotPath.begin(), dumpSnapshotPath.end())) ? 0 : 1;
+    }
+
     Mint& mint = Mint::Instance();
     TxPool& txPool = TxPool::Instance();
     Wallet& wallet = Wallet::Instance();
@@ -138,6 +138,69 @@ private:
     size_t nPos;
 };
 
+/* Minimal stream for reading from a byte range that is owned by someone else, e.g. a memory-mapped file
+ *
+ * The referenced memory has to stay valid while the reader is used
+ */
+class SpanReader
+{
+public:
+
+/*
+ * @param[in]  nTypeIn Serialization Type
+ * @param[in]  nVersionIn Serialization Version (including any flags)
+ * @param[in]  pchDataIn  Start of the referenced bytes
+ * @param[in]  nSizeIn  Number of referenced bytes
+*/
+    SpanReader(int nTypeIn, int nVersionIn, const char* pchDataIn, size_t nSizeIn) : nType(nTypeIn), nVersion(nVersionIn), pchData(pchDataIn), nSize(nSizeIn), nPos(0)
+    {
+    }
+    void read(char* pch, size_t nSizeRead)
+    {
+        if (nSizeRead > nSize - nPos) {
+            throw std::ios_base::failure("SpanReader::read(): end of data");
+        }
+        memcpy(pch, pchData + nPos, nSizeRead);
+        nPos += nSizeRead;
+    }
+    void ignore(size_t nSizeIgnore)
+    {
+        if (nSizeIgnore > nSize - nPos) {
+            throw std::ios_base::failure("SpanReader::ignore(): end of data");
+        }
+        nPos += nSizeIgnore;
+    }
+    template<typename T>
+    SpanReader& operator>>(T& obj)
+    {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+    int GetVersion() const
+    {
+        return nVersion;
+    }
+    int GetType() const
+    {
+        return nType;
+    }
+    size_t size() const
+    {
+        return nSize - nPos;
+    }
+    bool empty() const
+    {
+        return nPos == nSize;
+    }
+private:
+    const int nType;
+    const int nVersion;
+    const char* pchData;
+    const size_t nSize;
+    size_t nPos;
+};
+
 /** Double ended buffer combining vector and stream-like interfaces.
  *
  * >> and << read and write unformatted data using the above serialization templates.
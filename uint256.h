@@ -0,0 +1,139 @@
+#ifndef TX_UINT256_H
+#define TX_UINT256_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <ios>
+#include "serialize.h"
+
+/**
+ * Fixed-size opaque blob of BITS bits, stored inline.
+ * Used as key for hashes and ids so that map lookups don't allocate or chase pointers.
+ *
+ * Serializes like a std::vector<unsigned char> of the same length (compact size prefix followed by the bytes)
+ * so it can replace such a vector without changing the wire or disk format.
+ */
+template<unsigned int BITS>
+class base_blob {
+protected:
+    static const unsigned int WIDTH = BITS / 8;
+    uint8_t data[WIDTH];
+public:
+    base_blob() {
+        memset(data, 0, sizeof(data));
+    }
+
+    /**
+     * The vector has to be WIDTH bytes long, input of other nodes goes through setFromVector()
+     */
+    explicit base_blob(const std::vector<unsigned char>& vch) {
+        assert(vch.size() == WIDTH);
+        if(vch.size() == WIDTH) {
+            memcpy(data, vch.data(), sizeof(data));
+        } else {
+            memset(data, 0, sizeof(data));
+        }
+    }
+
+    /**
+     * Copies WIDTH bytes, for keys read straight from a DB slice
+     */
+    explicit base_blob(const unsigned char* bytes) {
+        memcpy(data, bytes, sizeof(data));
+    }
+
+    /**
+     * Returns false and keeps the current value if the vector isn't WIDTH bytes long
+     */
+    bool setFromVector(const std::vector<unsigned char>& vch) {
+        if(vch.size() != WIDTH) {
+            return false;
+        }
+        memcpy(data, vch.data(), sizeof(data));
+
+        return true;
+    }
+
+    bool isNull() const {
+        for(unsigned int i = 0; i < WIDTH; i++) {
+            if(data[i] != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<unsigned char> toVector() const {
+        return std::vector<unsigned char>(data, data + WIDTH);
+    }
+
+    const unsigned char* begin() const {
+        return &data[0];
+    }
+
+    const unsigned char* end() const {
+        return &data[WIDTH];
+    }
+
+    static constexpr unsigned int size() {
+        return WIDTH;
+    }
+
+    friend inline bool operator==(const base_blob& a, const base_blob& b) {
+        return memcmp(a.data, b.data, sizeof(a.data)) == 0;
+    }
+
+    friend inline bool operator!=(const base_blob& a, const base_blob& b) {
+        return memcmp(a.data, b.data, sizeof(a.data)) != 0;
+    }
+
+    friend inline bool operator<(const base_blob& a, const base_blob& b) {
+        return memcmp(a.data, b.data, sizeof(a.data)) < 0;
+    }
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        WriteCompactSize(s, WIDTH);
+        s.write((char*)data, sizeof(data));
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        if(ReadCompactSize(s) != WIDTH) {
+            throw std::ios_base::failure("base_blob::Unserialize(): unexpected size");
+        }
+        s.read((char*)data, sizeof(data));
+    }
+};
+
+/** 160-bit blob, used for Hash160 results like certificate ids */
+class uint160 : public base_blob<160> {
+public:
+    uint160() {}
+    explicit uint160(const std::vector<unsigned char>& vch) : base_blob<160>(vch) {}
+    explicit uint160(const unsigned char* bytes) : base_blob<160>(bytes) {}
+};
+
+/** 256-bit blob, used for Hash256 results like block header hashes and transaction ids */
+class uint256 : public base_blob<256> {
+public:
+    uint256() {}
+    explicit uint256(const std::vector<unsigned char>& vch) : base_blob<256>(vch) {}
+    explicit uint256(const unsigned char* bytes) : base_blob<256>(bytes) {}
+};
+
+/**
+ * Hashes are already uniformly distributed, the first bytes are good enough for unordered containers
+ */
+struct BlobHasher {
+    template<unsigned int BITS>
+    size_t operator()(const base_blob<BITS>& blob) const {
+        size_t result;
+        memcpy(&result, blob.begin(), sizeof(result));
+        return result;
+    }
+};
+
+#endif //TX_UINT256_H